@@ -0,0 +1,170 @@
+#pragma once
+
+// Upgrade handoff: a running sidecar passes its receiver sessions and cached state to a replacement started
+// with `--takeover`. Each instance travels as one JSON message over a SOCK_SEQPACKET connection, with its open
+// receiver connection attached via SCM_RIGHTS; a {"type":"done"} message ends the list.
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace onkyo {
+
+constexpr std::size_t kHandoffMessageMaxBytes = 65536;
+constexpr std::size_t kHandoffMaxDescriptors = 8;
+
+// Session and cached state of one instance passed from a running sidecar to its replacement.
+// fd is an open receiver connection owned by whoever holds the record, or -1.
+struct HandoffRecord
+{
+    std::string externalId;
+    QJsonObject state;
+    int fd = -1;
+    std::int64_t expiresAtMs = std::numeric_limits<std::int64_t>::max();
+};
+
+inline void closeHandoffDescriptor(int fd)
+{
+#ifdef Q_OS_UNIX
+    if (fd >= 0)
+        ::close(fd);
+#else
+    Q_UNUSED(fd);
+#endif
+}
+
+#ifdef Q_OS_LINUX
+// One JSON object per message, optionally carrying one descriptor.
+inline bool sendHandoffMessage(int channel, const QJsonObject &message, int fd = -1)
+{
+    const QByteArray payload = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    iovec iov{};
+    iov.iov_base = const_cast<char *>(payload.constData());
+    iov.iov_len = static_cast<std::size_t>(payload.size());
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    if (fd >= 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr *header = CMSG_FIRSTHDR(&msg);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(header), &fd, sizeof(int));
+    }
+    return ::sendmsg(channel, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(payload.size());
+}
+
+inline bool receiveHandoffMessage(int channel, int timeoutMs, QJsonObject *message, int *fd)
+{
+    *fd = -1;
+    pollfd pending{channel, POLLIN, 0};
+    if (::poll(&pending, 1, timeoutMs) <= 0)
+        return false;
+    std::vector<char> buffer(kHandoffMessageMaxBytes);
+    iovec iov{};
+    iov.iov_base = buffer.data();
+    iov.iov_len = buffer.size();
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    // Room for more than the one descriptor the protocol allows, so surplus ones arrive here and get closed
+    // instead of leaking; whatever did not fit even then is reported through MSG_CTRUNC.
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kHandoffMaxDescriptors)] = {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    const ssize_t received = ::recvmsg(channel, &msg, MSG_CMSG_CLOEXEC);
+    if (received <= 0)
+        return false;
+    int surplus = 0;
+    for (cmsghdr *header = CMSG_FIRSTHDR(&msg); header; header = CMSG_NXTHDR(&msg, header)) {
+        if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+            continue;
+        const std::size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (std::size_t i = 0; i < count; ++i) {
+            int descriptor = -1;
+            std::memcpy(&descriptor, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+            if (*fd < 0) {
+                *fd = descriptor;
+            } else {
+                ::close(descriptor);
+                ++surplus;
+            }
+        }
+    }
+    if (surplus > 0 || (msg.msg_flags & MSG_CTRUNC))
+        std::cerr << "handoff: dropped " << surplus << " surplus descriptors"
+                  << ((msg.msg_flags & MSG_CTRUNC) ? " (control data truncated)" : "") << '\n';
+    if (msg.msg_flags & MSG_TRUNC) {
+        closeHandoffDescriptor(*fd);
+        *fd = -1;
+        return false;
+    }
+    *message = QJsonDocument::fromJson(QByteArray(buffer.data(), static_cast<int>(received))).object();
+    return true;
+}
+
+// Export side: one message per record; descriptors stay owned by the caller. Returns the records sent.
+// The list is finished with sendHandoffDone() once the sender no longer serves the instances.
+inline int sendHandoffRecords(int channel, const std::vector<HandoffRecord> &records)
+{
+    int sent = 0;
+    for (const HandoffRecord &record : records) {
+        const QJsonObject message{
+            {QStringLiteral("type"), QStringLiteral("instance")},
+            {QStringLiteral("externalId"), QString::fromStdString(record.externalId)},
+            {QStringLiteral("state"), record.state},
+        };
+        if (sendHandoffMessage(channel, message, record.fd))
+            ++sent;
+        else
+            std::cerr << "handoff: failed to send instance " << record.externalId << '\n';
+    }
+    return sent;
+}
+
+inline bool sendHandoffDone(int channel)
+{
+    return sendHandoffMessage(channel, QJsonObject{{QStringLiteral("type"), QStringLiteral("done")}});
+}
+
+// Import side: records until `done`, a timeout or a closed channel. Unknown messages are skipped.
+inline std::vector<HandoffRecord> receiveHandoffRecords(int channel, int timeoutMs)
+{
+    std::vector<HandoffRecord> records;
+    QJsonObject message;
+    int fd = -1;
+    while (receiveHandoffMessage(channel, timeoutMs, &message, &fd)) {
+        const QString type = message.value(QStringLiteral("type")).toString();
+        if (type == QLatin1String("done"))
+            break;
+        if (type != QLatin1String("instance")) {
+            closeHandoffDescriptor(fd);
+            continue;
+        }
+        HandoffRecord record;
+        record.externalId = message.value(QStringLiteral("externalId")).toString().toStdString();
+        record.state = message.value(QStringLiteral("state")).toObject();
+        record.fd = fd;
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+#endif
+
+} // namespace onkyo
@@ -1,15 +1,24 @@
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <cerrno>
 #include <chrono>
 #include <csignal>
+#include <cstring>
 #include <cstdlib>
-#include <deque>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <deque>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -17,17 +26,47 @@
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QElapsedTimer>
+#include <QFile>
+#include <QEventLoop>
 #include <QHash>
+#include <QHostAddress>
+#include <QHostInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QNetworkDatagram>
 #include <QRegularExpression>
+#include <QSaveFile>
 #include <QSet>
+#include <QSocketNotifier>
 #include <QStringList>
 #include <QTcpSocket>
 #include <QTimer>
+#include <QUdpSocket>
+#include <QXmlStreamReader>
 #include <QtGlobal>
 
+#ifdef Q_OS_LINUX
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#include "onkyohandoff.h"
+#include "onkyolocalsocket.h"
+#include "onkyooperationpool.h"
+#include "onkyorecentcommands.h"
+#include "onkyostatetable.h"
+#include "onkyotransport.h"
+#include "onkyowait.h"
+#include "onkyowol.h"
 #include "phi/adapter/sdk/sidecar.h"
 #include "phi/adapter/sdk/qt/instance_execution_backend_qt.h"
 
@@ -42,6 +81,17 @@ constexpr const char kChannelVolume[] = "volume";
 constexpr const char kChannelMute[] = "mute";
 constexpr const char kChannelInput[] = "input";
 constexpr const char kChannelConnectivity[] = "connectivity";
+constexpr const char kChannelListeningMode[] = "listeningMode";
+constexpr const char kChannelBass[] = "bass";
+constexpr const char kChannelTreble[] = "treble";
+constexpr const char kChannelCenterLevel[] = "centerLevel";
+constexpr const char kChannelSubwooferLevel[] = "subwooferLevel";
+constexpr const char kChannelDimmer[] = "dimmer";
+constexpr const char kChannelAudioSignal[] = "audioSignal";
+constexpr const char kChannelVideoSignal[] = "videoSignal";
+constexpr const char kChannelLinkQuality[] = "linkQuality";
+constexpr const char kChannelTunerFrequency[] = "tunerFrequency";
+constexpr const char kChannelTunerPreset[] = "tunerPreset";
 constexpr const char kOnkyoIconSvg[] =
     "<svg width=\"24\" height=\"24\" viewBox=\"0 0 24 24\" fill=\"none\" "
     "xmlns=\"http://www.w3.org/2000/svg\" role=\"img\" aria-label=\"Receiver icon\">"
@@ -52,12 +102,187 @@ constexpr const char kOnkyoIconSvg[] =
     "<rect x=\"13\" y=\"13\" width=\"5\" height=\"1.6\" rx=\"0.8\" fill=\"#7A8AA4\"/>"
     "</svg>";
 
-constexpr bool kUseEiscp = true;
-constexpr bool kUseCrlf = false;
 constexpr bool kTraceEnabled = false;
 constexpr bool kTimingLogsEnabled = true;
 constexpr int kPollQueryTimeoutMs = 500;
+constexpr qsizetype kStateStreamBufferBytes = 64 * 1024;
 constexpr int kConnectFailuresBeforeDisconnect = 3;
+constexpr int kSceneAckTimeoutMs = 1500;
+constexpr int kPowerOnAckTimeoutMs = 3000;
+constexpr int kPowerOnSettleMs = 1200;
+constexpr int kEffectStepMs = 200;
+constexpr int kPollDeadlineMs = 8000;
+constexpr int kCommandDeadlineMs = 15000;
+constexpr int kHeartbeatTimeoutMs = 1000;
+constexpr int kSessionEchoTimeoutMs = 1000;
+constexpr int kConnectAttemptDelayMs = 250;
+constexpr int kSignalInfoSettleMs = 2000;
+constexpr int kSignalInfoReplyTimeoutMs = 1000;
+constexpr int kBrowseReplyTimeoutMs = 3000;
+constexpr int kBrowseDefaultPageSize = 25;
+constexpr std::size_t kBrowsePageCacheSize = 4;
+constexpr int kNlsWindowLines = 10;
+constexpr int kPresetListTimeoutMs = 4000;
+constexpr int kTunerPresetSlots = 40;
+constexpr std::size_t kOperationPoolSize = 32;
+constexpr std::size_t kRecentCommandCapacity = 64;
+constexpr std::int64_t kScheduleMaxSleepMs = 600000;
+constexpr std::int64_t kScheduleLateGraceMs = 300000;
+constexpr int kScheduleDispatchTimeoutMs = 20000;
+constexpr int kSleepTimerMaxMinutes = 90;
+constexpr int kDeferredDefaultTtlMs = 600000;
+constexpr int kWakeDefaultTimeoutMs = 30000;
+constexpr int kWakeConnectTimeoutMs = 400;
+constexpr int kWakeBackoffInitialMs = 250;
+constexpr int kWakeBackoffMaxMs = 2000;
+constexpr int kWakeResendIntervalMs = 5000;
+constexpr std::uint16_t kWakeDefaultPort = 9;
+constexpr std::int64_t kLivenessTcpFallbackMs = 300000;
+constexpr std::int64_t kLivenessTcpBackoffInitialMs = 5000;
+constexpr std::size_t kLinkQualityWindow = 50;
+constexpr std::int64_t kLinkQualityMinIntervalMs = 10000;
+constexpr double kLinkQualityRttMinDeltaMs = 5.0;
+constexpr double kLinkQualityRttRelDelta = 0.25;
+constexpr double kLinkQualityTimeoutDelta = 0.05;
+
+// Channels served by this adapter. Hot paths carry the enum; the names exist once per process.
+enum class ChannelId : std::uint8_t {
+    Power,
+    Volume,
+    Mute,
+    Input,
+    ListeningMode,
+    Bass,
+    Treble,
+    CenterLevel,
+    SubwooferLevel,
+    Dimmer,
+    TunerFrequency,
+    TunerPreset,
+    AudioSignal,
+    VideoSignal,
+    LinkQuality,
+    Connectivity,
+    Unknown,
+};
+constexpr std::size_t kChannelIdCount = static_cast<std::size_t>(ChannelId::Unknown);
+
+const std::string &channelName(ChannelId id)
+{
+    static const std::array<std::string, kChannelIdCount + 1> names{
+        kChannelPower,
+        kChannelVolume,
+        kChannelMute,
+        kChannelInput,
+        kChannelListeningMode,
+        kChannelBass,
+        kChannelTreble,
+        kChannelCenterLevel,
+        kChannelSubwooferLevel,
+        kChannelDimmer,
+        kChannelTunerFrequency,
+        kChannelTunerPreset,
+        kChannelAudioSignal,
+        kChannelVideoSignal,
+        kChannelLinkQuality,
+        kChannelConnectivity,
+        std::string(),
+    };
+    return names[static_cast<std::size_t>(id)];
+}
+
+const QString &channelQName(ChannelId id)
+{
+    static const std::array<QString, kChannelIdCount + 1> names{
+        QString::fromLatin1(kChannelPower),
+        QString::fromLatin1(kChannelVolume),
+        QString::fromLatin1(kChannelMute),
+        QString::fromLatin1(kChannelInput),
+        QString::fromLatin1(kChannelListeningMode),
+        QString::fromLatin1(kChannelBass),
+        QString::fromLatin1(kChannelTreble),
+        QString::fromLatin1(kChannelCenterLevel),
+        QString::fromLatin1(kChannelSubwooferLevel),
+        QString::fromLatin1(kChannelDimmer),
+        QString::fromLatin1(kChannelTunerFrequency),
+        QString::fromLatin1(kChannelTunerPreset),
+        QString::fromLatin1(kChannelAudioSignal),
+        QString::fromLatin1(kChannelVideoSignal),
+        QString::fromLatin1(kChannelLinkQuality),
+        QString::fromLatin1(kChannelConnectivity),
+        QString(),
+    };
+    return names[static_cast<std::size_t>(id)];
+}
+
+ChannelId channelIdFromName(std::string_view name)
+{
+    for (std::size_t i = 0; i < kChannelIdCount; ++i) {
+        const ChannelId id = static_cast<ChannelId>(i);
+        if (channelName(id) == name)
+            return id;
+    }
+    return ChannelId::Unknown;
+}
+
+bool isWritableChannel(ChannelId id)
+{
+    return id != ChannelId::AudioSignal && id != ChannelId::VideoSignal && id != ChannelId::LinkQuality
+        && id != ChannelId::Connectivity && id != ChannelId::Unknown;
+}
+
+// Listening mode, tone, levels and dimmer are only queried on demand; see OnkyoIpcInstance::isChannelWarm.
+bool isExtendedChannel(ChannelId id)
+{
+    switch (id) {
+    case ChannelId::ListeningMode:
+    case ChannelId::Bass:
+    case ChannelId::Treble:
+    case ChannelId::CenterLevel:
+    case ChannelId::SubwooferLevel:
+    case ChannelId::Dimmer:
+    case ChannelId::TunerFrequency:
+    case ChannelId::TunerPreset:
+        return true;
+    default:
+        return false;
+    }
+}
+
+QByteArray channelQueryCommand(ChannelId id)
+{
+    switch (id) {
+    case ChannelId::Power:
+        return QByteArrayLiteral("PWRQSTN");
+    case ChannelId::Volume:
+        return QByteArrayLiteral("MVLQSTN");
+    case ChannelId::Mute:
+        return QByteArrayLiteral("AMTQSTN");
+    case ChannelId::Input:
+        return QByteArrayLiteral("SLIQSTN");
+    case ChannelId::ListeningMode:
+        return QByteArrayLiteral("LMDQSTN");
+    case ChannelId::Bass:
+    case ChannelId::Treble:
+        return QByteArrayLiteral("TFRQSTN");
+    case ChannelId::CenterLevel:
+        return QByteArrayLiteral("CTLQSTN");
+    case ChannelId::SubwooferLevel:
+        return QByteArrayLiteral("SWLQSTN");
+    case ChannelId::Dimmer:
+        return QByteArrayLiteral("DIMQSTN");
+    case ChannelId::TunerFrequency:
+        return QByteArrayLiteral("TUNQSTN");
+    case ChannelId::TunerPreset:
+        return QByteArrayLiteral("PRSQSTN");
+    case ChannelId::AudioSignal:
+        return QByteArrayLiteral("IFAQSTN");
+    case ChannelId::VideoSignal:
+        return QByteArrayLiteral("IFVQSTN");
+    default:
+        return {};
+    }
+}
 
 std::atomic_bool g_running{true};
 
@@ -78,9 +303,17 @@ void trace(const QString &message)
     std::cerr << "[" << nowMs() << "] onkyo-ipc: " << message.toStdString() << '\n';
 }
 
+// PHI_ONKYO_TIMING_LOG=0 turns timing logs off at runtime. Hot paths test this before building a message,
+// so a disabled log costs no formatting.
+bool timingLogEnabled()
+{
+    static const bool enabled = kTimingLogsEnabled && qEnvironmentVariable("PHI_ONKYO_TIMING_LOG") != QStringLiteral("0");
+    return enabled;
+}
+
 void timingLog(const QString &message)
 {
-    if (!kTimingLogsEnabled)
+    if (!timingLogEnabled())
         return;
     std::cerr << "[" << nowMs() << "] onkyo-ipc[timing]: " << message.toStdString() << '\n';
 }
@@ -142,6 +375,137 @@ QString normalizeSliCode(QString raw)
     return code;
 }
 
+// Signed ISCP levels are a sign plus hex digits, zero is "00": "+A", "-3", "00".
+QByteArray signedIscpLevel(int value)
+{
+    if (value == 0)
+        return QByteArrayLiteral("00");
+    return (value > 0 ? QByteArrayLiteral("+") : QByteArrayLiteral("-"))
+        + QByteArray::number(std::abs(value), 16).toUpper();
+}
+
+std::optional<int> parseSignedIscpLevel(const QByteArray &text)
+{
+    if (text.isEmpty())
+        return std::nullopt;
+    const bool negative = text.startsWith('-');
+    const QByteArray digits = (negative || text.startsWith('+')) ? text.mid(1) : text;
+    bool ok = false;
+    const int magnitude = digits.toInt(&ok, 16);
+    if (!ok)
+        return std::nullopt;
+    return negative ? -magnitude : magnitude;
+}
+
+// IFA/IFV replies are comma-separated positional fields; models append fields over time, so anything past
+// the known names lands in "extra".
+QJsonObject parseSignalInfo(const QByteArray &payload, bool video)
+{
+    static const std::array<const char *, 7> kAudioFields{
+        "inputPort",
+        "inputFormat",
+        "samplingFrequency",
+        "inputChannels",
+        "listeningMode",
+        "outputChannels",
+        "outputSamplingFrequency",
+    };
+    static const std::array<const char *, 9> kVideoFields{
+        "inputPort",
+        "inputResolution",
+        "inputColorSpace",
+        "inputColorDepth",
+        "outputPort",
+        "outputResolution",
+        "outputColorSpace",
+        "outputColorDepth",
+        "pictureMode",
+    };
+
+    QJsonObject info;
+    QJsonArray extra;
+    const QList<QByteArray> parts = payload.split(',');
+    for (qsizetype i = 0; i < parts.size(); ++i) {
+        const QString value = QString::fromLatin1(parts.at(i)).trimmed();
+        const std::size_t index = static_cast<std::size_t>(i);
+        const char *name = nullptr;
+        if (video && index < kVideoFields.size())
+            name = kVideoFields[index];
+        else if (!video && index < kAudioFields.size())
+            name = kAudioFields[index];
+        if (name) {
+            info.insert(QString::fromLatin1(name), value);
+        } else if (!value.isEmpty()) {
+            extra.append(value);
+        }
+    }
+    if (!extra.isEmpty())
+        info.insert(QStringLiteral("extra"), extra);
+    return info;
+}
+
+// SLI codes of the tuner sources: FM, AM, generic tuner, DAB.
+bool isTunerInput(const QString &code)
+{
+    return code == QLatin1String("24") || code == QLatin1String("25") || code == QLatin1String("26")
+        || code == QLatin1String("33");
+}
+
+v1::AdapterConfigOptionList listeningModeChoices()
+{
+    static const std::array<std::pair<const char *, const char *>, 20> kModes{{
+        {"00", "Stereo"},
+        {"01", "Direct"},
+        {"02", "Surround"},
+        {"03", "Film"},
+        {"04", "THX"},
+        {"05", "Action"},
+        {"06", "Musical"},
+        {"08", "Orchestra"},
+        {"09", "Unplugged"},
+        {"0A", "Studio-Mix"},
+        {"0B", "TV Logic"},
+        {"0C", "All Channel Stereo"},
+        {"0D", "Theater-Dimensional"},
+        {"0F", "Mono"},
+        {"11", "Pure Audio"},
+        {"13", "Full Mono"},
+        {"40", "Straight Decode"},
+        {"80", "Dolby Surround / PLII Movie"},
+        {"82", "DTS Neural:X / Neo:6 Cinema"},
+        {"86", "PLII Game"},
+    }};
+    v1::AdapterConfigOptionList choices;
+    choices.reserve(kModes.size());
+    for (const auto &[code, label] : kModes) {
+        v1::AdapterConfigOption option;
+        option.value = code;
+        option.label = label;
+        choices.push_back(std::move(option));
+    }
+    return choices;
+}
+
+v1::AdapterConfigOptionList dimmerChoices()
+{
+    static const std::array<std::pair<const char *, const char *>, 5> kLevels{{
+        {"00", "Bright"},
+        {"01", "Dim"},
+        {"02", "Dark"},
+        {"03", "Off"},
+        {"08", "Bright, LED off"},
+    }};
+    v1::AdapterConfigOptionList choices;
+    choices.reserve(kLevels.size());
+    for (const auto &[code, label] : kLevels) {
+        v1::AdapterConfigOption option;
+        option.value = code;
+        option.label = label;
+        choices.push_back(std::move(option));
+    }
+    return choices;
+}
+
 QString formatSliDisplayLabel(const QString &code, const QString &mappedLabel)
 {
     const QString normalizedCode = normalizeSliCode(code);
@@ -214,26 +578,26 @@ QString inferModelFromIdentifier(const QString &raw)
     return {};
 }
 
-QByteArray buildEiscpFrame(const QByteArray &command)
+using onkyo::EiscpFraming;
+using onkyo::RawIscpFraming;
+
+using FramingPolicy = std::variant<EiscpFraming, RawIscpFraming<false>, RawIscpFraming<true>>;
+
+QByteArray encodeIscpFrame(const FramingPolicy &framing, const QByteArray &command)
 {
-    const QByteArray terminator = kUseCrlf ? QByteArrayLiteral("\r\n") : QByteArrayLiteral("\r");
-    const QByteArray payload = QByteArrayLiteral("!1") + command + terminator;
-    const quint32 dataSize = static_cast<quint32>(payload.size());
-
-    QByteArray frame;
-    frame.append("ISCP", 4);
-    auto appendInt = [&frame](quint32 value) {
-        frame.append(static_cast<char>((value >> 24) & 0xFF));
-        frame.append(static_cast<char>((value >> 16) & 0xFF));
-        frame.append(static_cast<char>((value >> 8) & 0xFF));
-        frame.append(static_cast<char>(value & 0xFF));
-    };
-    appendInt(16);
-    appendInt(dataSize);
-    frame.append(char(1));
-    frame.append(QByteArray(3, '\0'));
-    frame.append(payload);
-    return frame;
+    return std::visit([&command](const auto &policy) { return policy.encode(command); }, framing);
+}
+
+QString framingName(const FramingPolicy &framing)
+{
+    switch (framing.index()) {
+    case 1:
+        return QStringLiteral("cr");
+    case 2:
+        return QStringLiteral("crlf");
+    default:
+        return QStringLiteral("eiscp");
+    }
 }
 
 std::uint16_t normalizedPort(int value)
@@ -317,6 +681,191 @@ QString scalarToQString(const v1::ScalarValue &value)
     return {};
 }
 
+v1::ScalarValue jsonToScalar(const QJsonValue &value)
+{
+    if (value.isBool())
+        return value.toBool();
+    if (value.isDouble()) {
+        const double number = value.toDouble();
+        if (number == static_cast<double>(static_cast<std::int64_t>(number)))
+            return static_cast<std::int64_t>(number);
+        return number;
+    }
+    if (value.isString())
+        return value.toString().toStdString();
+    return std::monostate{};
+}
+
+QJsonValue scalarToJson(const v1::ScalarValue &value)
+{
+    if (const auto *v = std::get_if<bool>(&value))
+        return *v;
+    if (const auto *v = std::get_if<std::int64_t>(&value))
+        return static_cast<double>(*v);
+    if (const auto *v = std::get_if<double>(&value))
+        return *v;
+    if (const auto *v = std::get_if<v1::Utf8String>(&value))
+        return QString::fromStdString(*v);
+    return QJsonValue();
+}
+
+// Process-wide cache of hostname lookups shared by all instances.
+// Lookups run asynchronously on the main thread and are deduplicated per host. Callers get whatever is cached
+// right now, so DNS never sits on the command path; stale entries are served while a refresh runs.
+class HostResolver
+{
+public:
+    using ChangeCallback = std::function<void(const QString &host)>;
+
+    static HostResolver &instance()
+    {
+        static HostResolver resolver;
+        return resolver;
+    }
+
+    // Thread-safe and non-blocking. Empty while the first lookup is pending or the host did not resolve.
+    QStringList addresses(const QString &host)
+    {
+        const QString key = host.trimmed().toLower();
+        if (key.isEmpty())
+            return {};
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Entry &entry = m_entries[key];
+        if (!entry.pending && nowMs() >= entry.refreshAtMs)
+            startLookupLocked(key, entry);
+        return entry.addresses;
+    }
+
+    // Main thread only: `done` gets the addresses right away when cached, otherwise once the pending lookup
+    // finishes, or an empty list after timeoutMs. Used by the probe action; never spins an event loop.
+    void resolveAsync(const QString &host, int timeoutMs, std::function<void(const QStringList &)> done)
+    {
+        const QString key = host.trimmed().toLower();
+        const QStringList cached = addresses(key);
+        if (!cached.isEmpty() || !isPending(key)) {
+            done(cached);
+            return;
+        }
+        auto callback = std::make_shared<std::function<void(const QStringList &)>>(std::move(done));
+        Waiter finish = [callback](const QStringList &result) {
+            if (!*callback)
+                return;
+            const std::function<void(const QStringList &)> once = std::move(*callback);
+            *callback = nullptr;
+            once(result);
+        };
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries[key].waiters.push_back(finish);
+        }
+        QTimer::singleShot(timeoutMs, QCoreApplication::instance(), [finish]() { finish({}); });
+    }
+
+    // Callbacks run on the main thread whenever the address list of a host changes.
+    void subscribe(const std::string &key, ChangeCallback callback)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_subscribers[key] = std::move(callback);
+    }
+
+    void unsubscribe(const std::string &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_subscribers.erase(key);
+    }
+
+private:
+    static constexpr int kPositiveTtlMs = 300000;
+    static constexpr int kRefreshAfterMs = 240000;
+    static constexpr int kNegativeTtlMs = 30000;
+
+    using Waiter = std::function<void(const QStringList &)>;
+
+    struct Entry
+    {
+        QStringList addresses;
+        std::vector<Waiter> waiters;
+        std::int64_t refreshAtMs = 0;
+        std::int64_t expiresAtMs = 0;
+        std::int64_t lookupStartedMs = 0;
+        bool pending = false;
+    };
+
+    bool isPending(const QString &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.constFind(key);
+        return it != m_entries.constEnd() && it->pending;
+    }
+
+    void startLookupLocked(const QString &key, Entry &entry)
+    {
+        entry.pending = true;
+        entry.lookupStartedMs = nowMs();
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [this, key]() {
+                QHostInfo::lookupHost(key, QCoreApplication::instance(), [this, key](const QHostInfo &info) {
+                    onLookupFinished(key, info);
+                });
+            },
+            Qt::QueuedConnection);
+    }
+
+    void onLookupFinished(const QString &key, const QHostInfo &info)
+    {
+        QStringList resolved;
+        if (info.error() == QHostInfo::NoError) {
+            for (const QHostAddress &address : info.addresses()) {
+                const QString text = address.toString();
+                if (!resolved.contains(text))
+                    resolved.push_back(text);
+            }
+        }
+
+        std::vector<ChangeCallback> callbacks;
+        std::vector<Waiter> waiters;
+        QStringList served;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Entry &entry = m_entries[key];
+            const std::int64_t now = nowMs();
+            entry.pending = false;
+            waiters.swap(entry.waiters);
+            served = resolved.isEmpty() && now < entry.expiresAtMs ? entry.addresses : resolved;
+            timingLog(QStringLiteral("dns.lookup host=%1 addresses=%2 elapsedMs=%3 error=%4")
+                          .arg(key)
+                          .arg(resolved.join(QLatin1Char(',')))
+                          .arg(now - entry.lookupStartedMs)
+                          .arg(info.error() == QHostInfo::NoError ? QString() : info.errorString()));
+            bool changed = true;
+            if (resolved.isEmpty()) {
+                // Negative result: retry soon, but keep serving the last good addresses until they expire.
+                entry.refreshAtMs = now + kNegativeTtlMs;
+                if (now < entry.expiresAtMs || entry.addresses.isEmpty())
+                    changed = false;
+            } else {
+                entry.refreshAtMs = now + kRefreshAfterMs;
+                entry.expiresAtMs = now + kPositiveTtlMs;
+            }
+            if (changed && entry.addresses != resolved) {
+                entry.addresses = resolved;
+                callbacks.reserve(m_subscribers.size());
+                for (const auto &subscriber : m_subscribers)
+                    callbacks.push_back(subscriber.second);
+            }
+        }
+        for (const Waiter &waiter : waiters)
+            waiter(served);
+        for (const ChangeCallback &callback : callbacks)
+            callback(key);
+    }
+
+    std::mutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    std::unordered_map<std::string, ChangeCallback> m_subscribers;
+};
+
 QStringList resolveProbeHosts(const QJsonObject &params)
 {
     QStringList ips;
@@ -367,14 +916,24 @@ std::uint16_t resolveProbePort(const QJsonObject &params)
     return parsePort(params.value(QStringLiteral("iscpPort")));
 }
 
-bool probeEndpoint(const QString &host, std::uint16_t port, QString *errorMessage)
+// `address` is the literal host or its first resolved address; empty when the name did not resolve.
+bool probeEndpoint(const QString &host, const QString &address, std::uint16_t port, QString *errorMessage)
 {
     QElapsedTimer timer;
     timer.start();
     timingLog(QStringLiteral("factory.probe.start host=%1 port=%2").arg(host).arg(port));
     trace(QStringLiteral("factory probe start host=%1 port=%2").arg(host).arg(port));
+    if (address.isEmpty()) {
+        timingLog(QStringLiteral("factory.probe.end status=failure host=%1 port=%2 elapsedMs=%3 error=unresolved")
+                      .arg(host)
+                      .arg(port)
+                      .arg(timer.elapsed()));
+        if (errorMessage)
+            *errorMessage = QStringLiteral("Host not found");
+        return false;
+    }
     QTcpSocket socket;
-    socket.connectToHost(host, port);
+    socket.connectToHost(address, port);
     if (!socket.waitForConnected(900)) {
         timingLog(QStringLiteral("factory.probe.end status=failure host=%1 port=%2 elapsedMs=%3 error=%4")
                       .arg(host)
@@ -484,6 +1043,47 @@ QJsonObject buildConfigSchemaObject(const QHash<QString, QString> &labels)
                                QStringLiteral("Port"),
                                QStringLiteral("ISCP Port"),
                                60128));
+    factoryFields.append(field(QStringLiteral("transport"),
+                               QStringLiteral("Select"),
+                               QStringLiteral("Transport"),
+                               QStringLiteral("tcp"),
+                               QString(),
+                               QString(),
+                               QString(),
+                               QJsonArray(),
+                               QJsonArray{
+                                   QJsonObject{{QStringLiteral("value"), QStringLiteral("tcp")},
+                                               {QStringLiteral("label"), QStringLiteral("TCP (host/port)")}},
+                                   QJsonObject{{QStringLiteral("value"), QStringLiteral("serial")},
+                                               {QStringLiteral("label"), QStringLiteral("Serial device / pty")}},
+                                   QJsonObject{{QStringLiteral("value"), QStringLiteral("unix")},
+                                               {QStringLiteral("label"), QStringLiteral("Unix socket")}},
+                               }));
+    factoryFields.append(field(QStringLiteral("devicePath"),
+                               QStringLiteral("String"),
+                               QStringLiteral("Serial device or socket path")));
+    factoryFields.append(field(QStringLiteral("baudRate"),
+                               QStringLiteral("Integer"),
+                               QStringLiteral("Serial baud rate"),
+                               9600));
+    factoryFields.append(field(QStringLiteral("framing"),
+                               QStringLiteral("Select"),
+                               QStringLiteral("Framing"),
+                               QStringLiteral("auto"),
+                               QString(),
+                               QString(),
+                               QString(),
+                               QJsonArray(),
+                               QJsonArray{
+                                   QJsonObject{{QStringLiteral("value"), QStringLiteral("auto")},
+                                               {QStringLiteral("label"), QStringLiteral("Auto (eISCP on TCP, CR otherwise)")}},
+                                   QJsonObject{{QStringLiteral("value"), QStringLiteral("eiscp")},
+                                               {QStringLiteral("label"), QStringLiteral("eISCP")}},
+                                   QJsonObject{{QStringLiteral("value"), QStringLiteral("cr")},
+                                               {QStringLiteral("label"), QStringLiteral("ISCP, CR")}},
+                                   QJsonObject{{QStringLiteral("value"), QStringLiteral("crlf")},
+                                               {QStringLiteral("label"), QStringLiteral("ISCP, CR LF")}},
+                               }));
     factoryFields.append(field(QStringLiteral("pollIntervalMs"),
                                QStringLiteral("Integer"),
                                QStringLiteral("Poll interval"),
@@ -492,6 +1092,57 @@ QJsonObject buildConfigSchemaObject(const QHash<QString, QString> &labels)
                                QStringLiteral("Integer"),
                                QStringLiteral("Retry interval"),
                                10000));
+    factoryFields.append(field(QStringLiteral("sessionIdleTimeoutMs"),
+                               QStringLiteral("Integer"),
+                               QStringLiteral("Session idle timeout (0 = connect per command)"),
+                               60000));
+    factoryFields.append(field(QStringLiteral("ipcGraceMs"),
+                               QStringLiteral("Integer"),
+                               QStringLiteral("Core reconnect grace (0 = off)"),
+                               30000));
+    factoryFields.append(field(QStringLiteral("heartbeatIntervalMs"),
+                               QStringLiteral("Integer"),
+                               QStringLiteral("Heartbeat interval (0 = off)"),
+                               0));
+    factoryFields.append(field(QStringLiteral("extendedChannelIdleMs"),
+                               QStringLiteral("Integer"),
+                               QStringLiteral("Extended channel idle time"),
+                               600000));
+    factoryFields.append(field(QStringLiteral("tcpKeepAliveIdleS"),
+                               QStringLiteral("Integer"),
+                               QStringLiteral("TCP keepalive idle (s)"),
+                               10));
+    factoryFields.append(field(QStringLiteral("tcpKeepAliveIntervalS"),
+                               QStringLiteral("Integer"),
+                               QStringLiteral("TCP keepalive interval (s)"),
+                               2));
+    factoryFields.append(field(QStringLiteral("tcpKeepAliveCount"),
+                               QStringLiteral("Integer"),
+                               QStringLiteral("TCP keepalive probes"),
+                               3));
+    factoryFields.append(field(QStringLiteral("tcpUserTimeoutMs"),
+                               QStringLiteral("Integer"),
+                               QStringLiteral("TCP user timeout"),
+                               5000));
+    factoryFields.append(field(QStringLiteral("wakeOnLan"),
+                               QStringLiteral("Bool"),
+                               QStringLiteral("Wake-on-LAN on power on"),
+                               false));
+    factoryFields.append(field(QStringLiteral("macAddress"),
+                               QStringLiteral("String"),
+                               QStringLiteral("MAC address (learned when empty)")));
+    factoryFields.append(field(QStringLiteral("wolBroadcast"),
+                               QStringLiteral("String"),
+                               QStringLiteral("Wake-on-LAN target address"),
+                               QStringLiteral("255.255.255.255")));
+    factoryFields.append(field(QStringLiteral("wolPort"),
+                               QStringLiteral("Integer"),
+                               QStringLiteral("Wake-on-LAN port"),
+                               kWakeDefaultPort));
+    factoryFields.append(field(QStringLiteral("wakeTimeoutMs"),
+                               QStringLiteral("Integer"),
+                               QStringLiteral("Wake timeout"),
+                               kWakeDefaultTimeoutMs));
 
     const QJsonArray inputChoices = schemaInputChoices(labels);
 
@@ -603,388 +1254,2958 @@ QJsonObject buildConfigSchemaObject(const QHash<QString, QString> &labels)
     return schema;
 }
 
-class OnkyoIpcInstance final : public sdk::AdapterInstance
+using onkyo::CancellationToken;
+using onkyo::OperationContext;
+using onkyo::waitForSocket;
+using onkyo::waitUntil;
+using onkyo::WaitStatus;
+
+// RFC 8305 style connection race. Candidate i starts kConnectAttemptDelayMs after candidate i-1, or at once
+// when every earlier attempt has already failed. Returns the index of the first socket to connect, or -1;
+// all other sockets are aborted.
+int raceConnect(const std::vector<QTcpSocket *> &sockets,
+                const QStringList &hosts,
+                std::uint16_t port,
+                std::int64_t deadlineMs,
+                const CancellationToken &token)
+{
+    const int count = static_cast<int>(sockets.size());
+    QEventLoop loop;
+    QTimer deadlineTimer;
+    deadlineTimer.setSingleShot(true);
+    deadlineTimer.setTimerType(Qt::PreciseTimer);
+    QTimer staggerTimer;
+    staggerTimer.setSingleShot(true);
+    staggerTimer.setTimerType(Qt::PreciseTimer);
+    int started = 0;
+    int winner = -1;
+
+    auto startNext = [&]() {
+        if (started >= count)
+            return;
+        sockets[static_cast<std::size_t>(started)]->connectToHost(hosts.at(started), port);
+        ++started;
+        if (started < count)
+            staggerTimer.start(kConnectAttemptDelayMs);
+    };
+    auto allStartedFailed = [&]() {
+        for (int i = 0; i < started; ++i) {
+            if (sockets[static_cast<std::size_t>(i)]->state() != QAbstractSocket::UnconnectedState)
+                return false;
+        }
+        return true;
+    };
+
+    QObject::connect(&deadlineTimer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(&staggerTimer, &QTimer::timeout, &loop, startNext);
+    for (int i = 0; i < count; ++i) {
+        QTcpSocket *socket = sockets[static_cast<std::size_t>(i)];
+        QObject::connect(socket, &QAbstractSocket::connected, &loop, [&, i]() {
+            if (winner < 0)
+                winner = i;
+            loop.quit();
+        });
+        QObject::connect(socket, &QAbstractSocket::errorOccurred, &loop, [&]() {
+            if (!allStartedFailed())
+                return;
+            if (started < count) {
+                staggerTimer.stop();
+                startNext();
+            } else {
+                loop.quit();
+            }
+        });
+    }
+
+    startNext();
+    for (;;) {
+        if (winner >= 0 || token.isCancelled())
+            break;
+        if (started >= count && allStartedFailed())
+            break;
+        const std::int64_t remainingMs = deadlineMs - nowMs();
+        if (remainingMs <= 0)
+            break;
+        deadlineTimer.start(onkyo::remainingTimerMs(remainingMs));
+        token.exec(loop);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (i != winner)
+            sockets[static_cast<std::size_t>(i)]->abort();
+    }
+    return winner;
+}
+
+// Moves the connection of `source` into `target` so the session keeps its socket object and signal wiring.
+bool adoptConnectedSocket(QTcpSocket &target, QTcpSocket &source)
+{
+#ifdef Q_OS_UNIX
+    const int fd = ::dup(static_cast<int>(source.socketDescriptor()));
+    source.abort();
+    if (fd < 0)
+        return false;
+    target.abort();
+    if (!target.setSocketDescriptor(fd, QAbstractSocket::ConnectedState, QIODevice::ReadWrite)) {
+        ::close(fd);
+        return false;
+    }
+    return true;
+#else
+    // Without descriptor duplication the session reconnects to the winning address, which is known to answer.
+    const QHostAddress address = source.peerAddress();
+    const quint16 port = source.peerPort();
+    source.abort();
+    target.abort();
+    target.connectToHost(address, port);
+    return target.waitForConnected(1000);
+#endif
+}
+
+enum class TransportKind {
+    Tcp,
+    Serial,
+    UnixSocket,
+};
+
+// Where an instance talks to its receiver: host/port over TCP, or a local serial device, pty or Unix socket.
+struct TransportConfig
+{
+    TransportKind kind = TransportKind::Tcp;
+    QString path;
+    int baudRate = 9600;
+    FramingPolicy framing = EiscpFraming{};
+};
+
+#ifdef Q_OS_LINUX
+using onkyo::fillUnixAddress;
+
+using onkyo::SerialBridge;
+#endif
+
+// One session to the receiver plus the bytes of a not yet complete frame.
+// seenCommands collects reply prefixes since the last write, whoever read them off the socket.
+// Local transports hand a Unix socket (or the session end of a serial bridge) to the same QTcpSocket.
+struct ControlSession
+{
+    QTcpSocket socket;
+    QByteArray rxBuffer;
+    QSet<QByteArray> seenCommands;
+    QString host;
+    QString endpoint;
+    FramingPolicy framing = EiscpFraming{};
+#ifdef Q_OS_LINUX
+    std::unique_ptr<SerialBridge> bridge;
+    bool bridged() const { return bridge != nullptr; }
+#else
+    bool bridged() const { return false; }
+#endif
+};
+
+// Kernel limits for noticing a dead receiver on an open session.
+// Idle sessions are detected after idleSec + intervalSec * probeCount, unacknowledged writes after userTimeoutMs.
+struct KeepAliveSettings
+{
+    int idleSec = 10;
+    int intervalSec = 2;
+    int probeCount = 3;
+    int userTimeoutMs = 5000;
+};
+
+void applyTcpKeepAlive(QAbstractSocket &socket, const KeepAliveSettings &settings)
+{
+    socket.setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+#ifdef Q_OS_LINUX
+    const int fd = static_cast<int>(socket.socketDescriptor());
+    if (fd < 0)
+        return;
+    auto setOption = [fd](int name, int value, const char *label) {
+        if (::setsockopt(fd, IPPROTO_TCP, name, &value, sizeof(value)) != 0)
+            trace(QStringLiteral("setsockopt %1=%2 failed").arg(QString::fromLatin1(label)).arg(value));
+    };
+    setOption(TCP_KEEPIDLE, settings.idleSec, "TCP_KEEPIDLE");
+    setOption(TCP_KEEPINTVL, settings.intervalSec, "TCP_KEEPINTVL");
+    setOption(TCP_KEEPCNT, settings.probeCount, "TCP_KEEPCNT");
+#ifdef TCP_USER_TIMEOUT
+    setOption(TCP_USER_TIMEOUT, settings.userTimeoutMs, "TCP_USER_TIMEOUT");
+#endif
+#else
+    Q_UNUSED(settings);
+#endif
+}
+
+// One channel write fanned out to several instances by the factory `groupInvoke` action.
+struct GroupCommand
+{
+    std::string channelId;
+    v1::ScalarValue value;
+    std::int64_t deadlineMs = 0;
+};
+
+struct GroupMemberResult
+{
+    std::string externalId;
+    v1::CmdStatus status = v1::CmdStatus::Failure;
+    v1::Utf8String error;
+    v1::ScalarValue finalValue;
+    std::int64_t writeMs = 0;
+};
+
+using GroupResultCallback = std::function<void(GroupMemberResult)>;
+
+using onkyo::closeHandoffDescriptor;
+using onkyo::HandoffRecord;
+
+// Process-wide shared-memory state table, opened on first use when PHI_ONKYO_STATE_SHM names the object
+// (e.g. "/phi-onkyo-state"); PHI_ONKYO_STATE_SHM_RECORDS sizes it. Null when publishing is off or the region
+// could not be mapped.
+onkyo::statetable::Writer *sharedStateTable()
+{
+    static onkyo::statetable::Writer *table = []() -> onkyo::statetable::Writer * {
+        const QByteArray name = qgetenv("PHI_ONKYO_STATE_SHM").trimmed();
+        if (name.isEmpty())
+            return nullptr;
+        bool ok = false;
+        const int records = qEnvironmentVariableIntValue("PHI_ONKYO_STATE_SHM_RECORDS", &ok);
+        static onkyo::statetable::Writer writer;
+        std::string error;
+        if (!writer.open(name.toStdString(),
+                         ok && records > 0 ? static_cast<std::size_t>(records) : onkyo::statetable::kDefaultRecordCapacity,
+                         &error)) {
+            std::cerr << "state table unavailable at " << name.constData() << ": " << error << '\n';
+            return nullptr;
+        }
+        timingLog(QStringLiteral("statetable.open name=%1 records=%2 bytes=%3")
+                      .arg(QString::fromLatin1(name))
+                      .arg(static_cast<qulonglong>(writer.capacity()))
+                      .arg(static_cast<qulonglong>(writer.mappedBytes())));
+        return &writer;
+    }();
+    return table;
+}
+
+#ifdef Q_OS_LINUX
+// Read-only fan-out of state changes to local tools over a Unix stream socket. Each message is a 4-byte
+// big-endian length plus compact JSON: {"t":"d"} carries one changed channel, {"t":"r"} a removed instance,
+// {"t":"s"} the full state of all instances. Subscribers get a snapshot on connect; one whose buffer overflows
+// loses its queued deltas and gets a fresh snapshot instead, so a slow reader never holds back an instance.
+class StateStreamServer
 {
 public:
-    explicit OnkyoIpcInstance(QHash<QString, QString> bootstrapInputLabels)
-        : m_defaultInputLabelMap(std::move(bootstrapInputLabels))
+    StateStreamServer()
+        : m_context(std::make_unique<QObject>())
     {
     }
 
-    ~OnkyoIpcInstance() override
+    ~StateStreamServer()
     {
-        stopPollingTimer();
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            if (s_instance == this)
+                s_instance = nullptr;
+        }
+        m_retryTimer.reset();
+        m_subscribers.clear();
+        m_listenNotifier.reset();
+        if (m_listenFd >= 0) {
+            // Unlinked while still bound, so the path never names a socket a successor has bound meanwhile.
+            ::unlink(QFile::encodeName(m_path).constData());
+            ::close(m_listenFd);
+        }
     }
 
-protected:
-    bool start() override
+    // A path another process still accepts on is left alone. With retryMs (after --takeover, while the
+    // predecessor is on its way out) binding is retried until that much time has passed.
+    bool listen(const QString &path, int retryMs = 0)
     {
-        constexpr int kInitialQueryDelayMs = 1500;
-        m_operationQueue.clear();
-        m_operationRunning = false;
-        m_queuePumpScheduled = false;
-        m_pollQueued = false;
-        m_pollRunning = false;
-        m_started = true;
-        m_stopping = false;
-        m_synced = false;
-        m_lastConnectLogMs = 0;
-        m_lastConnectError.clear();
-        m_lastReportedPower.reset();
-        m_lastReportedMute.reset();
-        m_lastReportedVolume.reset();
-        m_lastReportedInput.clear();
-        m_hasLastReportedInput = false;
-        m_powerState = PowerState::Unknown;
-        m_consecutiveConnectFailures = 0;
-        setConnected(false);
-        QTimer::singleShot(kInitialQueryDelayMs, [this]() {
-            enqueuePollOperation(true);
+        if (bindPath(path))
+            return true;
+        if (retryMs <= 0)
+            return false;
+        const std::int64_t untilMs = nowMs() + retryMs;
+        m_retryTimer = std::make_unique<QTimer>();
+        m_retryTimer->setInterval(kStateStreamRetryMs);
+        QObject::connect(m_retryTimer.get(), &QTimer::timeout, [this, path, untilMs]() {
+            if (bindPath(path)) {
+                timingLog(QStringLiteral("stream.listen path=%1 retried=1").arg(path));
+            } else if (nowMs() < untilMs) {
+                return;
+            } else {
+                std::cerr << "state stream unavailable at " << path.toStdString() << '\n';
+            }
+            m_retryTimer.release()->deleteLater();
         });
-        startPollingTimer();
+        m_retryTimer->start();
         return true;
     }
 
-    void stop() override
+    // Thread-safe; runs on instance threads and only hands the change over. Everything else, including the
+    // latest-state map and the subscriber buffers, belongs to the main thread.
+    static void publish(const std::string &externalId, const std::string &channel, const v1::ScalarValue &value)
     {
-        m_stopping = true;
-        m_started = false;
-        m_synced = false;
-        m_lastReportedPower.reset();
-        m_lastReportedMute.reset();
-        m_lastReportedVolume.reset();
-        m_lastReportedInput.clear();
-        m_hasLastReportedInput = false;
-        m_powerState = PowerState::Unknown;
-        m_consecutiveConnectFailures = 0;
-        m_pollRunning = false;
-        flushPendingOperations("Instance stopped");
-        setConnected(false);
-        stopPollingTimer();
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (!s_instance)
+            return;
+        s_instance->m_pending.push_back(Change{externalId, channel, value, nowMs()});
+        s_instance->scheduleFlush();
     }
 
-    void onConfigChanged(const sdk::ConfigChangedRequest &request) override
+    // Thread-safe; the instance is gone, so snapshots stop carrying it and subscribers are told.
+    static void forget(const std::string &externalId)
     {
-        const QStringList previousHosts = effectiveHosts();
-        const std::uint16_t previousPort = m_controlPort;
-        const bool wasConnected = m_connected;
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (!s_instance)
+            return;
+        s_instance->m_pending.push_back(Change{externalId, std::string(), std::nullopt, nowMs()});
+        s_instance->scheduleFlush();
+    }
 
-        m_info = request.adapter;
-        m_meta = parseJsonObject(request.adapter.metaJson);
+private:
+    static constexpr int kStateStreamRetryMs = 250;
 
-        QJsonObject normalizedPatch;
-        const QJsonValue rawActiveCodes = m_meta.value(QStringLiteral("activeSliCodes"));
-        const QJsonArray normalizedCodes = normalizeActiveSliCodesArray(rawActiveCodes);
-        const bool hadRawActiveCodes = !rawActiveCodes.isUndefined() && !rawActiveCodes.isNull();
-        if (hadRawActiveCodes) {
-            if (!rawActiveCodes.isArray() || normalizedCodes != rawActiveCodes.toArray()) {
-                m_meta.insert(QStringLiteral("activeSliCodes"), normalizedCodes);
-                normalizedPatch.insert(QStringLiteral("activeSliCodes"), normalizedCodes);
-            }
-        }
+    // One handed-over change; no channel means the instance was removed.
+    struct Change
+    {
+        std::string externalId;
+        std::string channel;
+        std::optional<v1::ScalarValue> value;
+        std::int64_t tsMs = 0;
+    };
 
-        if (!normalizedPatch.isEmpty()) {
-            m_info.metaJson = toJson(m_meta);
-            v1::Utf8String err;
-            if (!sendAdapterMetaUpdated(toJson(normalizedPatch), &err))
-                std::cerr << "failed to send adapterMetaUpdated(config.normalize): " << err << '\n';
+    struct Subscriber
+    {
+        ~Subscriber()
+        {
+            readNotifier.reset();
+            writeNotifier.reset();
+            if (fd >= 0)
+                ::close(fd);
         }
 
-        applyConfig();
-        const QStringList nextHosts = effectiveHosts();
-        const bool endpointChanged = (previousPort != m_controlPort) || (previousHosts != nextHosts);
-        m_synced = false;
-        m_deviceId = resolveDeviceId();
-        m_lastConnectLogMs = 0;
-        m_lastConnectError.clear();
-        m_lastReportedPower.reset();
-        m_lastReportedMute.reset();
-        m_lastReportedVolume.reset();
-        m_lastReportedInput.clear();
-        m_hasLastReportedInput = false;
-        m_powerState = PowerState::Unknown;
-        m_consecutiveConnectFailures = 0;
-        m_stopping = false;
-        m_started = true;
-        m_pollRunning = false;
-        flushPendingOperations("Config changed");
+        int fd = -1;
+        std::deque<QByteArray> messages;
+        qsizetype headOffset = 0;
+        qsizetype queuedBytes = 0;
+        bool needsSnapshot = true;
+        bool dropped = false;
+        std::unique_ptr<QSocketNotifier> readNotifier;
+        std::unique_ptr<QSocketNotifier> writeNotifier;
+    };
 
-        if (endpointChanged || !wasConnected)
-            setConnected(false);
-        emitDeviceSnapshot();
-        enqueuePollOperation(true);
-        startPollingTimer();
+    bool bindPath(const QString &path)
+    {
+        sockaddr_un address{};
+        if (!fillUnixAddress(path, &address) || !onkyo::releaseStaleSocketPath(path, SOCK_STREAM))
+            return false;
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (fd < 0)
+            return false;
+        if (::bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 || ::listen(fd, 8) != 0) {
+            ::close(fd);
+            return false;
+        }
+        m_listenFd = fd;
+        m_path = path;
+        m_listenNotifier = std::make_unique<QSocketNotifier>(m_listenFd, QSocketNotifier::Read);
+        QObject::connect(m_listenNotifier.get(), &QSocketNotifier::activated, [this]() { onIncoming(); });
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_instance = this;
+        return true;
+    }
 
-        std::cerr << "onkyo-ipc config.changed adapterId=" << request.adapterId
-                  << " externalId=" << request.adapter.externalId
-                  << " pluginType=" << request.adapter.pluginType << '\n';
+    static QByteArray frame(const QJsonObject &message)
+    {
+        const QByteArray body = QJsonDocument(message).toJson(QJsonDocument::Compact);
+        const quint32 size = static_cast<quint32>(body.size());
+        QByteArray out;
+        out.reserve(body.size() + 4);
+        out.append(static_cast<char>((size >> 24) & 0xFF));
+        out.append(static_cast<char>((size >> 16) & 0xFF));
+        out.append(static_cast<char>((size >> 8) & 0xFF));
+        out.append(static_cast<char>(size & 0xFF));
+        out.append(body);
+        return out;
     }
 
-    void onDisconnected() override
+    void applyChange(const Change &change)
     {
-        m_stopping = true;
-        m_started = false;
-        m_synced = false;
-        m_lastReportedPower.reset();
-        m_lastReportedMute.reset();
-        m_lastReportedVolume.reset();
-        m_lastReportedInput.clear();
-        m_hasLastReportedInput = false;
-        m_powerState = PowerState::Unknown;
-        m_consecutiveConnectFailures = 0;
-        m_pollRunning = false;
-        flushPendingOperations("Instance disconnected");
-        setConnected(false);
-        stopPollingTimer();
+        const QString id = QString::fromStdString(change.externalId);
+        if (!change.value.has_value() && m_latest.erase(id) == 0)
+            return;
+        ++m_sequence;
+        QJsonObject message{
+            {QStringLiteral("seq"), static_cast<double>(m_sequence)},
+            {QStringLiteral("id"), id},
+            {QStringLiteral("ts"), static_cast<double>(change.tsMs)},
+        };
+        if (change.value.has_value()) {
+            const QString name = QString::fromStdString(change.channel);
+            const QJsonValue json = scalarToJson(*change.value);
+            m_latest[id].insert(name, json);
+            message.insert(QStringLiteral("t"), QStringLiteral("d"));
+            message.insert(QStringLiteral("ch"), name);
+            message.insert(QStringLiteral("v"), json);
+        } else {
+            message.insert(QStringLiteral("t"), QStringLiteral("r"));
+        }
+        if (m_subscribers.empty())
+            return;
+        const QByteArray framed = frame(message);
+        for (const std::unique_ptr<Subscriber> &subscriber : m_subscribers) {
+            if (subscriber->needsSnapshot)
+                continue;
+            if (subscriber->queuedBytes + framed.size() > kStateStreamBufferBytes) {
+                dropToSnapshot(*subscriber);
+                continue;
+            }
+            subscriber->messages.push_back(framed);
+            subscriber->queuedBytes += framed.size();
+        }
     }
 
-    void onChannelInvoke(const sdk::ChannelInvokeRequest &request) override
+    // Keeps only the part of a message already on the wire, so the stream stays framed.
+    void dropToSnapshot(Subscriber &subscriber)
     {
-        timingLog(QStringLiteral("cmd.recv type=channel.invoke cmdId=%1 externalId=%2 device=%3 channel=%4 value=%5")
-                      .arg(request.cmdId)
-                      .arg(QString::fromStdString(request.externalId))
-                      .arg(QString::fromStdString(request.deviceExternalId))
-                      .arg(QString::fromStdString(request.channelExternalId))
-                      .arg(scalarToDebugString(request.value)));
-        enqueueChannelInvokeOperation(request);
+        timingLog(QStringLiteral("stream.drop-to-snapshot total=%1").arg(++m_droppedToSnapshot));
+        if (subscriber.headOffset > 0) {
+            QByteArray head = std::move(subscriber.messages.front());
+            subscriber.messages.clear();
+            subscriber.queuedBytes = head.size() - subscriber.headOffset;
+            subscriber.messages.push_back(std::move(head));
+        } else {
+            subscriber.messages.clear();
+            subscriber.queuedBytes = 0;
+        }
+        subscriber.needsSnapshot = true;
+        subscriber.dropped = true;
     }
 
-    void onAdapterActionInvoke(const sdk::AdapterActionInvokeRequest &request) override
+    QByteArray snapshotMessage(bool resync) const
     {
-        timingLog(QStringLiteral("cmd.recv type=adapter.action.invoke cmdId=%1 externalId=%2 action=%3")
-                      .arg(request.cmdId)
-                      .arg(QString::fromStdString(request.externalId))
-                      .arg(QString::fromStdString(request.actionId)));
-        if (request.actionId == "probeCurrentInput") {
-            enqueueProbeCurrentOperation(request);
+        QJsonObject state;
+        for (const auto &[id, channels] : m_latest)
+            state.insert(id, channels);
+        return frame(QJsonObject{
+            {QStringLiteral("t"), QStringLiteral("s")},
+            {QStringLiteral("seq"), static_cast<double>(m_sequence)},
+            {QStringLiteral("resync"), resync},
+            {QStringLiteral("state"), state},
+            {QStringLiteral("ts"), static_cast<double>(nowMs())},
+        });
+    }
+
+    // Called with s_mutex held.
+    void scheduleFlush()
+    {
+        if (m_flushScheduled)
             return;
+        m_flushScheduled = true;
+        QMetaObject::invokeMethod(m_context.get(), [this]() { flush(); }, Qt::QueuedConnection);
+    }
+
+    void onIncoming()
+    {
+        for (;;) {
+            const int fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd < 0)
+                break;
+            auto subscriber = std::make_unique<Subscriber>();
+            subscriber->fd = fd;
+            Subscriber *raw = subscriber.get();
+            // Subscribers never send anything; readable means closed.
+            subscriber->readNotifier = std::make_unique<QSocketNotifier>(fd, QSocketNotifier::Read);
+            QObject::connect(subscriber->readNotifier.get(), &QSocketNotifier::activated, [this, raw]() {
+                char buffer[256];
+                const ssize_t n = ::recv(raw->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))
+                    removeSubscriber(raw);
+            });
+            subscriber->writeNotifier = std::make_unique<QSocketNotifier>(fd, QSocketNotifier::Write);
+            subscriber->writeNotifier->setEnabled(false);
+            QObject::connect(subscriber->writeNotifier.get(), &QSocketNotifier::activated, [this]() { flush(); });
+            m_subscribers.push_back(std::move(subscriber));
+            timingLog(QStringLiteral("stream.subscriber.add count=%1").arg(m_subscribers.size()));
         }
-        submitActionResult(handleAdapterActionInvoke(request), "adapter.action.invoke");
+        flush();
     }
 
-    void onDeviceNameUpdate(const sdk::DeviceNameUpdateRequest &request) override
+    void removeSubscriber(Subscriber *subscriber)
     {
-        submitCmdResult(handleDeviceNameUpdate(request), "device.name.update");
+        auto it = std::find_if(m_subscribers.begin(), m_subscribers.end(),
+                               [subscriber](const std::unique_ptr<Subscriber> &s) { return s.get() == subscriber; });
+        if (it == m_subscribers.end())
+            return;
+        // Either notifier may be the one whose signal got us here; it goes once the handler returned.
+        for (QSocketNotifier *notifier : {(*it)->readNotifier.release(), (*it)->writeNotifier.release()}) {
+            notifier->setEnabled(false);
+            notifier->deleteLater();
+        }
+        m_subscribers.erase(it);
+        timingLog(QStringLiteral("stream.subscriber.remove count=%1").arg(m_subscribers.size()));
     }
 
-    void onDeviceEffectInvoke(const sdk::DeviceEffectInvokeRequest &request) override
+    // Main thread. The lock is only held to take the handed-over changes; sends never block a publisher.
+    void flush()
     {
-        submitCmdResult(handleDeviceEffectInvoke(request), "device.effect.invoke");
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            m_flushScheduled = false;
+            m_applying.swap(m_pending);
+        }
+        for (const Change &change : m_applying)
+            applyChange(change);
+        m_applying.clear();
+
+        std::vector<Subscriber *> closed;
+        for (const std::unique_ptr<Subscriber> &subscriber : m_subscribers) {
+            if (!writeSubscriber(*subscriber))
+                closed.push_back(subscriber.get());
+        }
+        for (Subscriber *subscriber : closed)
+            removeSubscriber(subscriber);
     }
 
-    void onSceneInvoke(const sdk::SceneInvokeRequest &request) override
+    // Non-blocking; what the kernel does not take waits for the write notifier.
+    bool writeSubscriber(Subscriber &subscriber)
     {
-        submitCmdResult(handleSceneInvoke(request), "scene.invoke");
+        for (;;) {
+            // A pending snapshot goes out as soon as no message is half written.
+            if (subscriber.needsSnapshot && subscriber.headOffset == 0) {
+                subscriber.messages.clear();
+                subscriber.messages.push_back(snapshotMessage(subscriber.dropped));
+                subscriber.queuedBytes = subscriber.messages.back().size();
+                subscriber.needsSnapshot = false;
+                subscriber.dropped = false;
+            }
+            if (subscriber.messages.empty())
+                break;
+            const QByteArray &head = subscriber.messages.front();
+            const ssize_t n = ::send(subscriber.fd,
+                                     head.constData() + subscriber.headOffset,
+                                     static_cast<size_t>(head.size() - subscriber.headOffset),
+                                     MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                    break;
+                return false;
+            }
+            subscriber.headOffset += n;
+            subscriber.queuedBytes -= n;
+            if (subscriber.headOffset < head.size())
+                break;
+            subscriber.messages.pop_front();
+            subscriber.headOffset = 0;
+        }
+        subscriber.writeNotifier->setEnabled(!subscriber.messages.empty());
+        return true;
     }
 
-private:
-    enum class PowerState {
-        Unknown,
-        Off,
-        On,
+    // Guards s_instance, m_pending and m_flushScheduled only.
+    static inline std::mutex s_mutex;
+    static inline StateStreamServer *s_instance = nullptr;
+
+    std::unique_ptr<QObject> m_context;
+    std::unique_ptr<QTimer> m_retryTimer;
+    int m_listenFd = -1;
+    QString m_path;
+    std::unique_ptr<QSocketNotifier> m_listenNotifier;
+    std::vector<Change> m_pending;
+    std::vector<Change> m_applying;
+    std::vector<std::unique_ptr<Subscriber>> m_subscribers;
+    std::map<QString, QJsonObject> m_latest;
+    std::uint64_t m_sequence = 0;
+    std::uint64_t m_droppedToSnapshot = 0;
+    bool m_flushScheduled = false;
+};
+#endif
+
+// Timed channel writes of all instances on one timer. Entries are ordered by due time in a multimap and the
+// timer always points at the earliest; a due entry runs as a group command on its instance, so it takes the
+// normal queue without a trip through core. The schedule is saved to a JSON file after every change.
+// Thread-safe; the timer lives on the main thread.
+class CommandScheduler
+{
+public:
+    struct Entry
+    {
+        QString id;
+        std::string externalId;
+        std::string channelId;
+        v1::ScalarValue value;
+        std::int64_t dueMs = 0;
+        bool daily = false;
+        // Handed to the receiver's own sleep timer; nothing to send when it comes due.
+        bool native = false;
     };
 
-    struct PendingOperation
+    using Dispatch = std::function<bool(const std::string &externalId, GroupCommand command, GroupResultCallback callback)>;
+
+    static CommandScheduler &instance()
     {
-        enum class Kind {
-            Poll,
-            ChannelInvoke,
-            ProbeCurrentInput,
+        static CommandScheduler scheduler;
+        return scheduler;
+    }
+
+    // Main thread, once: loads the saved schedule and arms the timer.
+    void start(const QString &path, Dispatch dispatch)
+    {
+        m_context = std::make_unique<QObject>();
+        m_timer = std::make_unique<QTimer>();
+        m_timer->setSingleShot(true);
+        m_timer->setTimerType(Qt::PreciseTimer);
+        QObject::connect(m_timer.get(), &QTimer::timeout, m_context.get(), [this]() { fire(); });
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_path = path;
+            m_dispatch = std::move(dispatch);
+            load();
+        }
+        arm();
+    }
+
+    Entry add(Entry entry)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            entry.id = QString::number(++m_nextId);
+            m_due.emplace(entry.dueMs, entry.id);
+            m_entries.insert(entry.id, entry);
+            save();
+        }
+        requestArm();
+        return entry;
+    }
+
+    std::optional<Entry> find(const std::string &externalId, const QString &id) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.constFind(id);
+        if (it == m_entries.constEnd() || it->externalId != externalId)
+            return std::nullopt;
+        return *it;
+    }
+
+    bool remove(const std::string &externalId, const QString &id)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_entries.find(id);
+            if (it == m_entries.end() || it->externalId != externalId)
+                return false;
+            unlinkDue(it->dueMs, id);
+            m_entries.erase(it);
+            save();
+        }
+        requestArm();
+        return true;
+    }
+
+    std::vector<Entry> list(const std::string &externalId) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<Entry> entries;
+        for (const auto &[dueMs, id] : m_due) {
+            const Entry &entry = m_entries[id];
+            if (entry.externalId == externalId)
+                entries.push_back(entry);
+        }
+        return entries;
+    }
+
+    static QJsonObject toJsonObject(const Entry &entry)
+    {
+        return QJsonObject{
+            {QStringLiteral("id"), entry.id},
+            {QStringLiteral("channel"), QString::fromStdString(entry.channelId)},
+            {QStringLiteral("value"), scalarToJson(entry.value)},
+            {QStringLiteral("dueMs"), static_cast<double>(entry.dueMs)},
+            {QStringLiteral("daily"), entry.daily},
+            {QStringLiteral("native"), entry.native},
         };
+    }
 
-        Kind kind = Kind::Poll;
-        bool pollWasRunning = false;
-        std::int64_t enqueuedMs = 0;
-        sdk::ChannelInvokeRequest channelRequest;
-        sdk::AdapterActionInvokeRequest actionRequest;
-    };
+private:
+    static std::int64_t nextDailyDue(std::int64_t dueMs)
+    {
+        // Local calendar day, so a DST switch keeps the wall-clock time.
+        return QDateTime::fromMSecsSinceEpoch(dueMs).addDays(1).toMSecsSinceEpoch();
+    }
 
-    void removeQueuedPollOperations()
+    void unlinkDue(std::int64_t dueMs, const QString &id)
     {
-        for (auto it = m_operationQueue.begin(); it != m_operationQueue.end();) {
-            if (it->kind == PendingOperation::Kind::Poll) {
-                it = m_operationQueue.erase(it);
+        auto [first, last] = m_due.equal_range(dueMs);
+        for (auto it = first; it != last; ++it) {
+            if (it->second == id) {
+                m_due.erase(it);
+                return;
+            }
+        }
+    }
+
+    void requestArm()
+    {
+        if (!m_context)
+            return;
+        QMetaObject::invokeMethod(m_context.get(), [this]() { arm(); }, Qt::QueuedConnection);
+    }
+
+    void arm()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_due.empty()) {
+            m_timer->stop();
+            return;
+        }
+        // Capped so a wall-clock jump is noticed within kScheduleMaxSleepMs.
+        const std::int64_t delayMs = qBound<std::int64_t>(0, m_due.begin()->first - nowMs(), kScheduleMaxSleepMs);
+        m_timer->start(static_cast<int>(delayMs));
+    }
+
+    void fire()
+    {
+        std::vector<Entry> due;
+        Dispatch dispatch;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const std::int64_t now = nowMs();
+            while (!m_due.empty() && m_due.begin()->first <= now) {
+                const QString id = m_due.begin()->second;
+                m_due.erase(m_due.begin());
+                auto it = m_entries.find(id);
+                if (it == m_entries.end())
+                    continue;
+                due.push_back(*it);
+                if (it->daily) {
+                    std::int64_t next = nextDailyDue(it->dueMs);
+                    while (next <= now)
+                        next = nextDailyDue(next);
+                    it->dueMs = next;
+                    m_due.emplace(next, id);
+                } else {
+                    m_entries.erase(it);
+                }
+            }
+            if (!due.empty())
+                save();
+            dispatch = m_dispatch;
+        }
+        for (Entry &entry : due) {
+            const QString id = entry.id;
+            timingLog(QStringLiteral("schedule.fire id=%1 externalId=%2 channel=%3 native=%4 lateMs=%5")
+                          .arg(id)
+                          .arg(QString::fromStdString(entry.externalId))
+                          .arg(QString::fromStdString(entry.channelId))
+                          .arg(entry.native ? 1 : 0)
+                          .arg(nowMs() - entry.dueMs));
+            if (entry.native || !dispatch)
+                continue;
+            GroupCommand command{entry.channelId, std::move(entry.value), nowMs() + kScheduleDispatchTimeoutMs};
+            const bool posted = dispatch(entry.externalId, std::move(command), [id](GroupMemberResult result) {
+                timingLog(QStringLiteral("schedule.result id=%1 status=%2 error=%3")
+                              .arg(id)
+                              .arg(static_cast<int>(result.status))
+                              .arg(QString::fromStdString(result.error)));
+            });
+            if (!posted)
+                timingLog(QStringLiteral("schedule.skip id=%1 reason=instance-not-running").arg(id));
+        }
+        arm();
+    }
+
+    // Entries missed by more than kScheduleLateGraceMs while no sidecar ran are dropped (daily ones move on).
+    void load()
+    {
+        QFile file(m_path);
+        if (m_path.isEmpty() || !file.open(QIODevice::ReadOnly))
+            return;
+        const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+        const std::int64_t now = nowMs();
+        for (const QJsonValue &value : root.value(QStringLiteral("entries")).toArray()) {
+            const QJsonObject object = value.toObject();
+            Entry entry;
+            entry.id = object.value(QStringLiteral("id")).toString();
+            entry.externalId = object.value(QStringLiteral("externalId")).toString().toStdString();
+            entry.channelId = object.value(QStringLiteral("channel")).toString().toStdString();
+            entry.value = jsonToScalar(object.value(QStringLiteral("value")));
+            entry.dueMs = static_cast<std::int64_t>(object.value(QStringLiteral("dueMs")).toDouble());
+            entry.daily = object.value(QStringLiteral("daily")).toBool();
+            entry.native = object.value(QStringLiteral("native")).toBool();
+            if (entry.id.isEmpty() || entry.externalId.empty() || entry.channelId.empty())
                 continue;
+            m_nextId = std::max(m_nextId, entry.id.toULongLong());
+            if (entry.dueMs < now - kScheduleLateGraceMs) {
+                if (!entry.daily)
+                    continue;
+                while (entry.dueMs <= now)
+                    entry.dueMs = nextDailyDue(entry.dueMs);
             }
-            ++it;
+            m_due.emplace(entry.dueMs, entry.id);
+            m_entries.insert(entry.id, entry);
         }
-        m_pollQueued = false;
+        m_nextId = std::max<std::uint64_t>(m_nextId,
+                                           static_cast<std::uint64_t>(root.value(QStringLiteral("nextId")).toDouble()));
+        timingLog(QStringLiteral("schedule.load path=%1 entries=%2").arg(m_path).arg(m_entries.size()));
+    }
+
+    void save() const
+    {
+        if (m_path.isEmpty())
+            return;
+        QJsonArray entries;
+        for (const auto &[dueMs, id] : m_due) {
+            const Entry &entry = m_entries[id];
+            QJsonObject object = toJsonObject(entry);
+            object.insert(QStringLiteral("externalId"), QString::fromStdString(entry.externalId));
+            entries.append(object);
+        }
+        QSaveFile file(m_path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cerr << "schedule: cannot write " << m_path.toStdString() << '\n';
+            return;
+        }
+        file.write(QJsonDocument(QJsonObject{
+                                     {QStringLiteral("version"), 1},
+                                     {QStringLiteral("nextId"), static_cast<double>(m_nextId)},
+                                     {QStringLiteral("entries"), entries},
+                                 })
+                       .toJson(QJsonDocument::Compact));
+        if (!file.commit())
+            std::cerr << "schedule: cannot save " << m_path.toStdString() << '\n';
+    }
+
+    mutable std::mutex m_mutex;
+    QString m_path;
+    Dispatch m_dispatch;
+    std::multimap<std::int64_t, QString> m_due;
+    QHash<QString, Entry> m_entries;
+    std::uint64_t m_nextId = 0;
+    std::unique_ptr<QObject> m_context;
+    std::unique_ptr<QTimer> m_timer;
+};
+
+// Records waiting for their instance to start: received through `--takeover`, or parked by an instance
+// destroyed during the IPC grace period.
+class HandoffStore
+{
+public:
+    static HandoffStore &instance()
+    {
+        static HandoffStore store;
+        return store;
+    }
+
+    void put(HandoffRecord record)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_records.find(record.externalId);
+        if (it != m_records.end())
+            closeHandoffDescriptor(it->second.fd);
+        m_records[record.externalId] = std::move(record);
+    }
+
+    std::optional<HandoffRecord> take(const std::string &externalId)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_records.find(externalId);
+        if (it == m_records.end())
+            return std::nullopt;
+        HandoffRecord record = std::move(it->second);
+        m_records.erase(it);
+        if (nowMs() >= record.expiresAtMs) {
+            closeHandoffDescriptor(record.fd);
+            return std::nullopt;
+        }
+        return record;
+    }
+
+    // Runs closeExpired() on the main thread after delayMs; safe to call from any thread.
+    static void scheduleExpiry(std::int64_t delayMs)
+    {
+        const int delay = static_cast<int>(qBound<std::int64_t>(0, delayMs, std::numeric_limits<int>::max()));
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [delay]() {
+                QTimer::singleShot(delay, QCoreApplication::instance(), []() {
+                    HandoffStore::instance().closeExpired();
+                });
+            },
+            Qt::QueuedConnection);
+    }
+
+    // Sessions nobody claimed in time, e.g. of instances dropped from the configuration, are closed.
+    void closeExpired()
+    {
+        const std::int64_t now = nowMs();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_records.begin(); it != m_records.end();) {
+            if (now < it->second.expiresAtMs) {
+                ++it;
+                continue;
+            }
+            timingLog(QStringLiteral("handoff.unclaimed externalId=%1").arg(QString::fromStdString(it->first)));
+            closeHandoffDescriptor(it->second.fd);
+            it = m_records.erase(it);
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::unordered_map<std::string, HandoffRecord> m_records;
+};
+
+class OnkyoIpcInstance final : public sdk::AdapterInstance
+{
+public:
+    OnkyoIpcInstance(std::string externalId, QHash<QString, QString> bootstrapInputLabels)
+        : m_externalId(std::move(externalId))
+        , m_defaultInputLabelMap(std::move(bootstrapInputLabels))
+    {
+    }
+
+    // The Qt execution backend destroys an instance on its worker thread, the thread that owns its socket and
+    // timers; everything below relies on that.
+    ~OnkyoIpcInstance() override
+    {
+        // Destroyed by an event delivered inside a wait of the running operation: that wait throws
+        // OperationAbandoned instead of returning into frames of this object.
+        if (m_operationRunning)
+            m_operationToken.abandon();
+        HostResolver::instance().unsubscribe(m_externalId);
+#ifdef Q_OS_LINUX
+        StateStreamServer::forget(m_externalId);
+#endif
+        {
+            std::lock_guard<std::mutex> lock(s_registryMutex);
+            auto it = s_registry.find(m_externalId);
+            if (it != s_registry.end() && it->second == this)
+                s_registry.erase(it);
+            // Under the registry lock, so nothing new gets posted: deleting the context discards the lambdas
+            // already posted to it, so none of them can run against a half-destroyed instance from a nested
+            // wait below.
+            m_dispatchContext.reset();
+        }
+        // Destroyed inside the IPC grace period: park the session for the instance core recreates.
+        if (m_ipcDown && m_sessionEstablished) {
+            HandoffRecord record = exportSession();
+            record.expiresAtMs = m_ipcGraceUntilMs;
+            HandoffStore::instance().put(std::move(record));
+            HandoffStore::scheduleExpiry(m_ipcGraceUntilMs - nowMs());
+        }
+        if (m_session)
+            QObject::disconnect(&m_session->socket, nullptr, nullptr, nullptr);
+        stopPollingTimer();
+        if (onkyo::statetable::Writer *table = sharedStateTable(); table && m_stateRecord >= 0)
+            table->releaseRecord(m_stateRecord);
+    }
+
+    // Thread-safe: hands the command to the instance worker thread. The callback runs there too.
+    static bool postGroupCommand(const std::string &externalId,
+                                 GroupCommand command,
+                                 GroupResultCallback callback)
+    {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        auto it = s_registry.find(externalId);
+        if (it == s_registry.end() || !it->second->m_dispatchContext)
+            return false;
+        OnkyoIpcInstance *instance = it->second;
+        return QMetaObject::invokeMethod(
+            instance->m_dispatchContext.get(),
+            [instance, command = std::move(command), callback = std::move(callback)]() mutable {
+                instance->enqueueGroupOperation(std::move(command), std::move(callback));
+            },
+            Qt::QueuedConnection);
+    }
+
+    static void postHostChanged(const std::string &externalId, const QString &host)
+    {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        auto it = s_registry.find(externalId);
+        if (it == s_registry.end() || !it->second->m_dispatchContext)
+            return;
+        OnkyoIpcInstance *instance = it->second;
+        QMetaObject::invokeMethod(
+            instance->m_dispatchContext.get(),
+            [instance, host]() { instance->onHostAddressesChanged(host); },
+            Qt::QueuedConnection);
+    }
+
+    // Main thread: asks every instance to stop and export its session. `done` runs on the main thread with
+    // all records once every instance answered or timeoutMs passed.
+    static void collectHandoff(int timeoutMs, std::function<void(std::vector<HandoffRecord>)> done)
+    {
+        struct Collection
+        {
+            std::vector<HandoffRecord> records;
+            std::size_t expected = 0;
+            bool finished = false;
+            std::function<void(std::vector<HandoffRecord>)> done;
+        };
+        auto collection = std::make_shared<Collection>();
+        collection->done = std::move(done);
+        auto finish = [collection]() {
+            if (collection->finished)
+                return;
+            collection->finished = true;
+            collection->done(std::move(collection->records));
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(s_registryMutex);
+            for (const auto &entry : s_registry) {
+                OnkyoIpcInstance *instance = entry.second;
+                if (!instance->m_dispatchContext)
+                    continue;
+                ++collection->expected;
+                QMetaObject::invokeMethod(
+                    instance->m_dispatchContext.get(),
+                    [instance, collection, finish]() {
+                        instance->prepareHandoff([collection, finish](HandoffRecord record) {
+                            QMetaObject::invokeMethod(
+                                QCoreApplication::instance(),
+                                [collection, finish, record = std::move(record)]() mutable {
+                                    if (collection->finished) {
+                                        closeHandoffDescriptor(record.fd);
+                                        return;
+                                    }
+                                    collection->records.push_back(std::move(record));
+                                    if (collection->records.size() >= collection->expected)
+                                        finish();
+                                },
+                                Qt::QueuedConnection);
+                        });
+                    },
+                    Qt::QueuedConnection);
+            }
+        }
+        if (collection->expected == 0) {
+            finish();
+            return;
+        }
+        QTimer::singleShot(timeoutMs, QCoreApplication::instance(), finish);
+    }
+
+protected:
+    // Registration happens at once, so a start() that arrives during an operation is already visible to
+    // resolver, group commands and the state table; only resetting and restarting the queue waits for that
+    // operation to unwind.
+    bool start() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_registryMutex);
+            if (!m_dispatchContext)
+                m_dispatchContext = std::make_unique<QObject>();
+            s_registry[m_externalId] = this;
+        }
+        HostResolver::instance().subscribe(m_externalId, [externalId = m_externalId](const QString &host) {
+            postHostChanged(externalId, host);
+        });
+        if (onkyo::statetable::Writer *table = sharedStateTable(); table && m_stateRecord < 0) {
+            m_stateRecord = table->acquireRecord(m_externalId);
+            if (m_stateRecord < 0)
+                std::cerr << "state table full (" << table->capacity() << " records), not publishing " << m_externalId
+                          << "; raise PHI_ONKYO_STATE_SHM_RECORDS\n";
+        }
+        if (deferWhileOperationRuns([this]() { beginOperations(); }))
+            timingLog(QStringLiteral("lifecycle.deferred call=start externalId=%1").arg(QString::fromStdString(m_externalId)));
+        else
+            beginOperations();
+        return true;
+    }
+
+    void beginOperations()
+    {
+        constexpr int kInitialQueryDelayMs = 1500;
+        if (m_ipcDown) {
+            resumeAfterIpcGrace();
+            return;
+        }
+        m_operationQueue.clear();
+        m_operationRunning = false;
+        m_queuePumpScheduled = false;
+        m_pollQueued = false;
+        m_pollRunning = false;
+        m_started = true;
+        m_stopping = false;
+        m_synced = false;
+        m_lastConnectLogMs = 0;
+        m_lastConnectError.clear();
+        m_lastReportedPower.reset();
+        m_lastReportedMute.reset();
+        m_lastReportedVolume.reset();
+        m_lastReportedInput.clear();
+        m_hasLastReportedInput = false;
+        m_powerState = PowerState::Unknown;
+        m_consecutiveConnectFailures = 0;
+        setConnected(false);
+        if (std::optional<HandoffRecord> record = HandoffStore::instance().take(m_externalId))
+            adoptHandoff(std::move(*record));
+        QTimer::singleShot(kInitialQueryDelayMs, m_dispatchContext.get(), [this]() {
+            enqueuePollOperation(true);
+        });
+        startPollingTimer();
+    }
+
+    void stop() override
+    {
+        if (deferWhileOperationRuns([this]() { stop(); }))
+            return;
+        m_stopping = true;
+        m_started = false;
+        m_synced = false;
+        m_lastReportedPower.reset();
+        m_lastReportedMute.reset();
+        m_lastReportedVolume.reset();
+        m_lastReportedInput.clear();
+        m_hasLastReportedInput = false;
+        m_powerState = PowerState::Unknown;
+        m_consecutiveConnectFailures = 0;
+        m_pollRunning = false;
+        flushPendingOperations("Instance stopped");
+        dropSession();
+        m_livenessSocket.reset();
+        setConnected(false);
+        stopPollingTimer();
+    }
+
+    void onConfigChanged(const sdk::ConfigChangedRequest &request) override
+    {
+        if (deferWhileOperationRuns([this, request]() { onConfigChanged(request); }))
+            return;
+        const QString previousHost = transportEndpoint();
+        const std::uint16_t previousPort = m_controlPort;
+        const bool wasConnected = m_connected;
+
+        m_info = request.adapter;
+        m_meta = parseJsonObject(request.adapter.metaJson);
+
+        QJsonObject normalizedPatch;
+        const QJsonValue rawActiveCodes = m_meta.value(QStringLiteral("activeSliCodes"));
+        const QJsonArray normalizedCodes = normalizeActiveSliCodesArray(rawActiveCodes);
+        const bool hadRawActiveCodes = !rawActiveCodes.isUndefined() && !rawActiveCodes.isNull();
+        if (hadRawActiveCodes) {
+            if (!rawActiveCodes.isArray() || normalizedCodes != rawActiveCodes.toArray()) {
+                m_meta.insert(QStringLiteral("activeSliCodes"), normalizedCodes);
+                normalizedPatch.insert(QStringLiteral("activeSliCodes"), normalizedCodes);
+            }
+        }
+
+        if (!normalizedPatch.isEmpty()) {
+            m_info.metaJson = toJson(m_meta);
+            v1::Utf8String err;
+            if (!sendAdapterMetaUpdated(toJson(normalizedPatch), &err))
+                std::cerr << "failed to send adapterMetaUpdated(config.normalize): " << err << '\n';
+        }
+
+        applyConfig();
+        const bool endpointChanged = (previousPort != m_controlPort) || (previousHost != transportEndpoint());
+        // A live session survives when it still points at the configured receiver with the same framing;
+        // new keepalive limits are applied to it in place.
+        const bool keepSession = m_session && m_sessionEstablished
+            && m_session->framing.index() == m_transport.framing.index()
+            && (isTcpTransport()
+                    ? (m_session->endpoint == configuredHost() || effectiveHosts().contains(m_session->host))
+                        && m_session->socket.peerPort() == m_controlPort
+                    : m_session->endpoint == transportEndpoint());
+        m_deviceId = resolveDeviceId();
+        if (m_resumePending && keepSession) {
+            // Warm resume after a core reconnect or an upgrade: one snapshot from the cache, no cold poll.
+            m_resumePending = false;
+            m_stopping = false;
+            m_started = true;
+            if (isTcpTransport())
+                applyTcpKeepAlive(m_session->socket, m_keepAlive);
+            emitResumeSnapshot();
+            startPollingTimer();
+            std::cerr << "onkyo-ipc config.changed adapterId=" << request.adapterId
+                      << " externalId=" << request.adapter.externalId
+                      << " resumed=1\n";
+            return;
+        }
+        m_resumePending = false;
+        m_synced = false;
+        m_lastConnectLogMs = 0;
+        m_lastConnectError.clear();
+        // Core that speaks delta resync still has these values; only real changes are emitted again.
+        if (!m_resyncNegotiated) {
+            m_lastReportedPower.reset();
+            m_lastReportedMute.reset();
+            m_lastReportedVolume.reset();
+            m_lastReportedInput.clear();
+            m_hasLastReportedInput = false;
+        }
+        m_powerState = PowerState::Unknown;
+        m_consecutiveConnectFailures = 0;
+        m_stopping = false;
+        m_started = true;
+        m_pollRunning = false;
+        flushPendingOperations("Config changed");
+        m_recentCommands.clear();
+        if (!keepSession)
+            dropSession();
+        else if (isTcpTransport())
+            applyTcpKeepAlive(m_session->socket, m_keepAlive);
+
+        if (!keepSession && (endpointChanged || !wasConnected))
+            setConnected(false);
+        emitDeviceSnapshot();
+        enqueuePollOperation(true);
+        startPollingTimer();
+
+        std::cerr << "onkyo-ipc config.changed adapterId=" << request.adapterId
+                  << " externalId=" << request.adapter.externalId
+                  << " pluginType=" << request.adapter.pluginType << '\n';
+    }
+
+    void onDisconnected() override
+    {
+        if (deferWhileOperationRuns([this]() { onDisconnected(); }))
+            return;
+        if (m_ipcGraceMs > 0 && m_started && !m_stopping) {
+            enterIpcGrace();
+            return;
+        }
+        teardownAfterDisconnect();
+    }
+
+    void onChannelInvoke(const sdk::ChannelInvokeRequest &request) override
+    {
+        if (timingLogEnabled()) {
+            timingLog(QStringLiteral("cmd.recv type=channel.invoke cmdId=%1 externalId=%2 device=%3 channel=%4 value=%5")
+                          .arg(request.cmdId)
+                          .arg(QString::fromStdString(request.externalId))
+                          .arg(QString::fromStdString(request.deviceExternalId))
+                          .arg(QString::fromStdString(request.channelExternalId))
+                          .arg(scalarToDebugString(request.value)));
+        }
+        if (replayRecentCommand(request.cmdId))
+            return;
+        enqueueChannelInvokeOperation(request);
+    }
+
+    void onAdapterActionInvoke(const sdk::AdapterActionInvokeRequest &request) override
+    {
+        timingLog(QStringLiteral("cmd.recv type=adapter.action.invoke cmdId=%1 externalId=%2 action=%3")
+                      .arg(request.cmdId)
+                      .arg(QString::fromStdString(request.externalId))
+                      .arg(QString::fromStdString(request.actionId)));
+        if (request.actionId == "probeCurrentInput") {
+            enqueueProbeCurrentOperation(request);
+            return;
+        }
+        if (request.actionId == "readChannel") {
+            handleReadChannel(request);
+            return;
+        }
+        if (request.actionId == "refreshSignalInfo") {
+            enqueueSignalInfoOperation(request);
+            return;
+        }
+        if (request.actionId == "netBrowseOpen" || request.actionId == "netBrowsePage"
+            || request.actionId == "netBrowseSelect") {
+            enqueueBrowseOperation(request);
+            return;
+        }
+        if (request.actionId == "scheduleAdd" || request.actionId == "scheduleRemove"
+            || request.actionId == "scheduleList") {
+            handleScheduleAction(request);
+            return;
+        }
+        if (request.actionId == "deferredInvoke") {
+            submitActionResult(handleDeferredInvoke(request), "adapter.action.invoke");
+            return;
+        }
+        submitActionResult(handleAdapterActionInvoke(request), "adapter.action.invoke");
+    }
+
+    void onDeviceNameUpdate(const sdk::DeviceNameUpdateRequest &request) override
+    {
+        submitCmdResult(handleDeviceNameUpdate(request), "device.name.update");
+    }
+
+    void onDeviceEffectInvoke(const sdk::DeviceEffectInvokeRequest &request) override
+    {
+        timingLog(QStringLiteral("cmd.recv type=device.effect.invoke cmdId=%1 externalId=%2 device=%3")
+                      .arg(request.cmdId)
+                      .arg(QString::fromStdString(request.externalId))
+                      .arg(QString::fromStdString(request.deviceExternalId)));
+        // Accepted effects report their single result when they finish or get cancelled.
+        if (std::optional<v1::CmdResponse> rejected = handleDeviceEffectInvoke(request))
+            submitCmdResult(std::move(*rejected), "device.effect.invoke");
+    }
+
+    void onSceneInvoke(const sdk::SceneInvokeRequest &request) override
+    {
+        timingLog(QStringLiteral("cmd.recv type=scene.invoke cmdId=%1 externalId=%2")
+                      .arg(request.cmdId)
+                      .arg(QString::fromStdString(request.externalId)));
+        enqueueSceneOperation(request);
+    }
+
+private:
+    using CmdId = decltype(v1::CmdResponse::id);
+
+    enum class PowerState {
+        Unknown,
+        Off,
+        On,
+    };
+
+    // Channel write validated at enqueue time; holds no strings for boolean and numeric channels.
+    struct ChannelWrite
+    {
+        CmdId cmdId{};
+        ChannelId channel = ChannelId::Unknown;
+        v1::ScalarValue value;
+    };
+
+    // Parked write of deferredInvoke; seq tells a flushed entry from one replaced while the flush ran.
+    struct DeferredWrite
+    {
+        v1::ScalarValue value;
+        std::int64_t expiresMs = 0;
+        std::uint64_t seq = 0;
+    };
+
+    struct WakeStats
+    {
+        int count = 0;
+        std::int64_t lastMs = 0;
+        std::int64_t totalMs = 0;
+        std::int64_t maxMs = 0;
+    };
+
+    struct LinkQualityStats
+    {
+        double srttUs = -1.0;
+        // Outcome of the last kLinkQualityWindow reply waits; true for a timeout.
+        std::array<bool, kLinkQualityWindow> timedOut{};
+        std::size_t next = 0;
+        std::size_t filled = 0;
+        std::size_t timeouts = 0;
+        std::deque<std::int64_t> reconnectsMs;
+        // -1 while the emitted value carried no RTT yet.
+        double emittedRttMs = -1.0;
+        double emittedTimeoutRatio = 0.0;
+        int emittedReconnects = 0;
+        int emittedWakes = 0;
+        std::int64_t emittedMs = 0;
+    };
+
+    struct GroupInvocation
+    {
+        GroupCommand command;
+        GroupResultCallback callback;
+    };
+
+    // NET/USB list browsing. Only the current list's header and a few recently used pages are kept, so
+    // deep libraries cost constant memory; NLS windows are the fallback for receivers without NLA.
+    struct BrowseCursor
+    {
+        struct Page
+        {
+            int index = 0;
+            QJsonArray items;
+        };
+
+        bool open = false;
+        bool xml = true;
+        std::uint16_t sequence = 0;
+        int layer = 0;
+        int totalItems = -1;
+        int pageSize = kBrowseDefaultPageSize;
+        QString title;
+        std::list<Page> pages;
+        QByteArray reply;
+        std::array<QString, kNlsWindowLines> nlsLines;
+    };
+
+    // One entry of the NRI preset list; band 1 is FM, 2 AM and 3 DAB.
+    struct TunerPreset
+    {
+        QString code;
+        int band = 0;
+        QString frequency;
+        QString name;
+    };
+
+    struct PendingOperation
+    {
+        enum class Kind {
+            Poll,
+            ChannelInvoke,
+            ProbeCurrentInput,
+            Scene,
+            EffectStep,
+            GroupInvoke,
+            Heartbeat,
+            ReadChannel,
+            SignalInfo,
+            Browse,
+            PresetList,
+            SleepTimer,
+            DeferredFlush,
+        };
+
+        Kind kind = Kind::Poll;
+        bool pollWasRunning = false;
+        std::int64_t enqueuedMs = 0;
+        // Only what the kind needs: ChannelInvoke carries a ChannelWrite, ProbeCurrentInput, ReadChannel and
+        // Browse the action request, Scene the scene request and GroupInvoke a GroupInvocation. SignalInfo carries
+        // the action request when refreshSignalInfo asked for it and nothing when a change triggered it.
+        std::variant<std::monostate, ChannelWrite, sdk::AdapterActionInvokeRequest, sdk::SceneInvokeRequest,
+                     GroupInvocation>
+            payload;
+    };
+    using OperationQueue = std::list<PendingOperation>;
+    using OperationPool = onkyo::OperationPool<PendingOperation, kOperationPoolSize>;
+    using RecentCommands = onkyo::RecentCommandRing<CmdId, v1::CmdResponse, kRecentCommandCapacity>;
+
+    // Setter writes for distinct channels that go out in one pipelined write.
+    struct WriteBatch
+    {
+        std::array<ChannelWrite, kChannelIdCount> writes;
+        std::size_t size = 0;
+    };
+
+    // Target values of one scene; unset members are left untouched on the receiver.
+    struct SceneTargets
+    {
+        std::optional<bool> power;
+        std::optional<double> volume;
+        std::optional<bool> mute;
+        QString input;
+
+        bool isEmpty() const
+        {
+            return !power.has_value() && !volume.has_value() && !mute.has_value() && input.isEmpty();
+        }
+    };
+
+    // Volume effect executed locally as a sequence of linear segments.
+    struct VolumeEffect
+    {
+        enum class Type {
+            Ramp,
+            FadeIn,
+            FadeOut,
+            Duck,
+        };
+
+        struct Segment
+        {
+            double fromPercent = 0.0;
+            double toPercent = 0.0;
+            int durationMs = 0;
+        };
+
+        CmdId cmdId{};
+        Type type = Type::Ramp;
+        double targetPercent = 0.0;
+        int durationMs = 0;
+        int holdMs = 0;
+        int restoreMs = 0;
+        bool started = false;
+        std::int64_t startedMs = 0;
+        std::vector<Segment> segments;
+        QByteArray lastCommand;
+    };
+
+    static void clearOperation(PendingOperation &op)
+    {
+        op.payload = std::monostate{};
+    }
+
+    // Queue nodes are recycled through m_operationPool, so steady-state enqueues do not allocate.
+    PendingOperation &queueOperation(PendingOperation::Kind kind, bool front)
+    {
+        PendingOperation &op =
+            m_operationPool.acquire(m_operationQueue, front ? m_operationQueue.begin() : m_operationQueue.end());
+        op.kind = kind;
+        op.pollWasRunning = false;
+        op.enqueuedMs = nowMs();
+        return op;
+    }
+
+    OperationQueue::iterator recycleOperation(OperationQueue::iterator it)
+    {
+        return m_operationPool.release(m_operationQueue, it, clearOperation);
+    }
+
+    // Power changes and preset recalls (which may need an input switch first) keep their own operation.
+    static bool isBatchableWrite(const ChannelWrite &write)
+    {
+        return write.channel != ChannelId::Power && write.channel != ChannelId::TunerPreset;
+    }
+
+    // The first write plus the run of setters queued right behind it, one per channel. Power writes and
+    // anything sent while the receiver is not known to be on keep their own operation.
+    WriteBatch takeWriteBatch(ChannelWrite first)
+    {
+        WriteBatch batch;
+        batch.writes[batch.size++] = std::move(first);
+        if (m_powerState != PowerState::On || !isBatchableWrite(batch.writes[0]))
+            return batch;
+        while (!m_operationQueue.empty() && m_operationQueue.front().kind == PendingOperation::Kind::ChannelInvoke) {
+            ChannelWrite &next = std::get<ChannelWrite>(m_operationQueue.front().payload);
+            const auto end = batch.writes.begin() + static_cast<std::ptrdiff_t>(batch.size);
+            if (!isBatchableWrite(next)
+                || std::any_of(batch.writes.begin(), end, [&next](const ChannelWrite &queued) {
+                       return queued.channel == next.channel;
+                   })) {
+                break;
+            }
+            batch.writes[batch.size++] = std::move(next);
+            recycleOperation(m_operationQueue.begin());
+        }
+        return batch;
+    }
+
+    // A core retry reuses the cmdId: a finished command gets its result again, a running one is left to answer
+    // both. Returns false for a new cmdId, which is remembered as in flight.
+    bool replayRecentCommand(CmdId cmdId)
+    {
+        if (cmdId == CmdId{})
+            return false;
+        const RecentCommands::Entry *recent = m_recentCommands.find(cmdId);
+        if (!recent) {
+            m_recentCommands.remember(cmdId);
+            return false;
+        }
+        timingLog(QStringLiteral("cmd.dedupe cmdId=%1 state=%2")
+                      .arg(cmdId)
+                      .arg(recent->completed ? QStringLiteral("completed") : QStringLiteral("in-flight")));
+        if (recent->completed)
+            sendCmdResponse(recent->response, "channel.invoke.replay");
+        return true;
+    }
+
+    void removeQueuedPollOperations()
+    {
+        for (auto it = m_operationQueue.begin(); it != m_operationQueue.end();) {
+            if (it->kind == PendingOperation::Kind::Poll) {
+                it = recycleOperation(it);
+                continue;
+            }
+            ++it;
+        }
+        m_pollQueued = false;
+    }
+
+    void enqueueChannelInvokeOperation(const sdk::ChannelInvokeRequest &request)
+    {
+        // Requests the instance cannot serve are answered right away instead of taking a queue slot.
+        const ChannelId channel = channelIdFromName(request.channelExternalId);
+        if (request.deviceExternalId != m_deviceId || !isWritableChannel(channel)) {
+            v1::CmdResponse resp;
+            resp.id = request.cmdId;
+            resp.tsMs = nowMs();
+            resp.status = v1::CmdStatus::NotSupported;
+            resp.error = (request.deviceExternalId != m_deviceId) ? "Unknown device" : "Channel not supported";
+            submitCmdResult(std::move(resp), "channel.invoke");
+            return;
+        }
+
+        // Command writes should not wait behind stale queued poll work.
+        removeQueuedPollOperations();
+        if (channel == ChannelId::Volume || channel == ChannelId::Mute || channel == ChannelId::Power)
+            cancelDeviceEffect("Cancelled by user write");
+
+        if (channel == ChannelId::Volume) {
+            for (auto it = m_operationQueue.begin(); it != m_operationQueue.end();) {
+                if (it->kind == PendingOperation::Kind::ChannelInvoke
+                    && std::get<ChannelWrite>(it->payload).channel == ChannelId::Volume) {
+                    v1::CmdResponse coalesced;
+                    coalesced.id = std::get<ChannelWrite>(it->payload).cmdId;
+                    coalesced.tsMs = nowMs();
+                    coalesced.status = v1::CmdStatus::Success;
+                    submitCmdResult(std::move(coalesced), "channel.invoke.coalesced");
+                    it = recycleOperation(it);
+                    continue;
+                }
+                ++it;
+            }
+        }
+
+        touchChannel(channel);
+        PendingOperation &op = queueOperation(PendingOperation::Kind::ChannelInvoke, false);
+        op.payload = ChannelWrite{request.cmdId, channel, request.value};
+        if (timingLogEnabled()) {
+            timingLog(QStringLiteral("cmd.queue type=channel.invoke cmdId=%1 queueSize=%2")
+                          .arg(request.cmdId)
+                          .arg(static_cast<int>(m_operationQueue.size())));
+        }
+        preemptRunningPoll();
+        scheduleQueuePump();
+    }
+
+    void enqueueProbeCurrentOperation(const sdk::AdapterActionInvokeRequest &request)
+    {
+        PendingOperation &op = queueOperation(PendingOperation::Kind::ProbeCurrentInput, true);
+        op.pollWasRunning = m_pollRunning;
+        op.payload = request;
+        timingLog(QStringLiteral("cmd.queue type=adapter.action.invoke cmdId=%1 action=%2 queueSize=%3")
+                      .arg(request.cmdId)
+                      .arg(QString::fromStdString(request.actionId))
+                      .arg(static_cast<int>(m_operationQueue.size())));
+        preemptRunningPoll();
+        scheduleQueuePump();
+    }
+
+    // Extended channels count as used for extendedChannelIdleMs after every read or write.
+    void touchChannel(ChannelId channel)
+    {
+        if (isExtendedChannel(channel))
+            m_channelLastUseMs[static_cast<std::size_t>(channel)] = nowMs();
+    }
+
+    // Warm channels have a value that push frames and echoes keep current, so reads need no round trip.
+    // Extended channels go dormant after extendedChannelIdleMs without use or when the link drops.
+    bool isChannelWarm(ChannelId channel) const
+    {
+        const std::size_t index = static_cast<std::size_t>(channel);
+        // Computed locally; there is nothing to query.
+        if (channel == ChannelId::LinkQuality)
+            return true;
+        if (m_stateJournal[index].seq == 0)
+            return false;
+        if (channel == ChannelId::AudioSignal || channel == ChannelId::VideoSignal)
+            return m_signalInfoFresh;
+        if (!isExtendedChannel(channel))
+            return true;
+        return m_channelLastUseMs[index] > 0 && nowMs() - m_channelLastUseMs[index] < m_extendedIdleMs;
+    }
+
+    void handleReadChannel(const sdk::AdapterActionInvokeRequest &request)
+    {
+        const QJsonObject params = parseJsonObject(request.paramsJson);
+        const ChannelId channel =
+            channelIdFromName(params.value(QStringLiteral("channel")).toString().trimmed().toStdString());
+        if (channel == ChannelId::Unknown || channel == ChannelId::Connectivity) {
+            v1::ActionResponse resp;
+            resp.id = request.cmdId;
+            resp.tsMs = nowMs();
+            resp.status = v1::CmdStatus::InvalidArgument;
+            resp.error = "readChannel requires a readable channel";
+            resp.resultType = v1::ActionResultType::None;
+            submitActionResult(std::move(resp), "adapter.action.invoke");
+            return;
+        }
+        const bool warm = isChannelWarm(channel);
+        touchChannel(channel);
+        if (warm) {
+            submitActionResult(channelReadResult(request, channel), "adapter.action.invoke");
+            return;
+        }
+
+        PendingOperation &op = queueOperation(PendingOperation::Kind::ReadChannel, false);
+        op.payload = request;
+        timingLog(QStringLiteral("cmd.queue type=channel.read cmdId=%1 channel=%2 queueSize=%3")
+                      .arg(request.cmdId)
+                      .arg(channelQName(channel))
+                      .arg(static_cast<int>(m_operationQueue.size())));
+        preemptRunningPoll();
+        scheduleQueuePump();
+    }
+
+    // Dormant channel: one query on the receiver; the reply lands in the journal through handleIscpPayload.
+    // A stale signal channel refreshes both: IFA and IFV go out in one pipelined write, like refreshSignalInfo.
+    v1::ActionResponse runReadChannel(const sdk::AdapterActionInvokeRequest &request, const OperationContext &ctx)
+    {
+        const QJsonObject params = parseJsonObject(request.paramsJson);
+        const ChannelId channel =
+            channelIdFromName(params.value(QStringLiteral("channel")).toString().trimmed().toStdString());
+        if (channel == ChannelId::AudioSignal || channel == ChannelId::VideoSignal) {
+            if (!runSignalInfoRefresh(ctx))
+                return signalInfoResult(request, false);
+            touchChannel(channel);
+            return channelReadResult(request, channel);
+        }
+        if (!sendIscpCommand(channelQueryCommand(channel), true, kPollQueryTimeoutMs, ctx)) {
+            v1::ActionResponse resp;
+            resp.id = request.cmdId;
+            resp.tsMs = nowMs();
+            resp.status = unavailableCommandStatus();
+            resp.error = unavailableCommandMessage();
+            resp.resultType = v1::ActionResultType::None;
+            return resp;
+        }
+        touchChannel(channel);
+        return channelReadResult(request, channel);
+    }
+
+    v1::ActionResponse channelReadResult(const sdk::AdapterActionInvokeRequest &request, ChannelId channel) const
+    {
+        v1::ActionResponse resp;
+        resp.id = request.cmdId;
+        resp.tsMs = nowMs();
+        const JournalEntry &entry = m_stateJournal[static_cast<std::size_t>(channel)];
+        if (entry.seq == 0) {
+            resp.status = v1::CmdStatus::Failure;
+            resp.error = "No value reported";
+            resp.resultType = v1::ActionResultType::None;
+            return resp;
+        }
+        resp.status = v1::CmdStatus::Success;
+        resp.resultType = v1::ActionResultType::String;
+        resp.resultValue = scalarToQString(entry.value).toStdString();
+        return resp;
+    }
+
+    static v1::ActionResponse scheduleResponse(const sdk::AdapterActionInvokeRequest &request,
+                                               v1::CmdStatus status,
+                                               v1::Utf8String error,
+                                               const QJsonValue &result = QJsonValue())
+    {
+        v1::ActionResponse resp;
+        resp.id = request.cmdId;
+        resp.tsMs = nowMs();
+        resp.status = status;
+        resp.error = std::move(error);
+        resp.resultType = v1::ActionResultType::None;
+        if (result.isObject() || result.isArray()) {
+            resp.resultType = v1::ActionResultType::String;
+            resp.resultValue = (result.isObject() ? QJsonDocument(result.toObject()) : QJsonDocument(result.toArray()))
+                                   .toJson(QJsonDocument::Compact)
+                                   .toStdString();
+        }
+        return resp;
+    }
+
+    // Due time from params: `at` (epoch ms), `inMs`, or `time` ("HH:MM" local, next occurrence).
+    static std::optional<std::int64_t> scheduleDueMs(const QJsonObject &params)
+    {
+        const std::int64_t now = nowMs();
+        if (params.value(QStringLiteral("at")).isDouble())
+            return static_cast<std::int64_t>(params.value(QStringLiteral("at")).toDouble());
+        if (params.value(QStringLiteral("inMs")).isDouble())
+            return now + static_cast<std::int64_t>(params.value(QStringLiteral("inMs")).toDouble());
+        const QTime time = QTime::fromString(params.value(QStringLiteral("time")).toString().trimmed(), QStringLiteral("H:mm"));
+        if (!time.isValid())
+            return std::nullopt;
+        QDateTime due(QDate::currentDate(), time);
+        if (due.toMSecsSinceEpoch() <= now)
+            due = due.addDays(1);
+        return due.toMSecsSinceEpoch();
+    }
+
+    // A one-shot power-off within the receiver's 90 minute range goes to its SLP timer: nothing has to wake
+    // the sidecar or the queue at the due time. Minute resolution.
+    bool usesSleepTimer(const CommandScheduler::Entry &entry, bool allowNative) const
+    {
+        if (!allowNative || entry.daily || entry.channelId != kChannelPower || m_powerState != PowerState::On)
+            return false;
+        const std::optional<bool> on = scalarToBool(entry.value);
+        const std::int64_t delayMs = entry.dueMs - nowMs();
+        return on.has_value() && !*on && delayMs >= 60000 && delayMs <= kSleepTimerMaxMinutes * 60000LL;
+    }
+
+    // The receiver has a single SLP timer, so an instance keeps at most one pending native entry; setting the
+    // timer for a second one would silently replace the first.
+    bool hasNativeSleepTimer() const
+    {
+        const std::int64_t now = nowMs();
+        for (const CommandScheduler::Entry &entry : CommandScheduler::instance().list(m_externalId)) {
+            if (entry.native && entry.dueMs > now)
+                return true;
+        }
+        return false;
+    }
+
+    void handleScheduleAction(const sdk::AdapterActionInvokeRequest &request)
+    {
+        const QJsonObject params = parseJsonObject(request.paramsJson);
+        CommandScheduler &scheduler = CommandScheduler::instance();
+        if (request.actionId == "scheduleList") {
+            QJsonArray entries;
+            for (const CommandScheduler::Entry &entry : scheduler.list(m_externalId))
+                entries.append(CommandScheduler::toJsonObject(entry));
+            submitActionResult(scheduleResponse(request, v1::CmdStatus::Success, {}, entries), "adapter.action.invoke");
+            return;
+        }
+        if (request.actionId == "scheduleRemove") {
+            const QString id = params.value(QStringLiteral("id")).toVariant().toString();
+            const std::optional<CommandScheduler::Entry> entry = scheduler.find(m_externalId, id);
+            if (!entry.has_value()) {
+                submitActionResult(scheduleResponse(request, v1::CmdStatus::InvalidArgument, "Unknown schedule id"),
+                                   "adapter.action.invoke");
+                return;
+            }
+            if (entry->native) {
+                enqueueSleepTimerOperation(request);
+                return;
+            }
+            scheduler.remove(m_externalId, id);
+            submitActionResult(scheduleResponse(request, v1::CmdStatus::Success, {}, CommandScheduler::toJsonObject(*entry)),
+                               "adapter.action.invoke");
+            return;
+        }
+
+        CommandScheduler::Entry entry;
+        entry.externalId = m_externalId;
+        const ChannelId channel =
+            channelIdFromName(params.value(QStringLiteral("channel")).toString().trimmed().toStdString());
+        const std::optional<std::int64_t> dueMs = scheduleDueMs(params);
+        if (!isWritableChannel(channel) || !params.contains(QStringLiteral("value")) || !dueMs.has_value()) {
+            submitActionResult(scheduleResponse(request,
+                                                v1::CmdStatus::InvalidArgument,
+                                                "scheduleAdd requires a writable channel, a value and at/inMs/time"),
+                               "adapter.action.invoke");
+            return;
+        }
+        entry.channelId = channelName(channel);
+        entry.value = jsonToScalar(params.value(QStringLiteral("value")));
+        entry.dueMs = *dueMs;
+        entry.daily = params.value(QStringLiteral("repeat")).toString() == QLatin1String("daily");
+        if (usesSleepTimer(entry, params.value(QStringLiteral("native")).toBool(true)) && !hasNativeSleepTimer()) {
+            enqueueSleepTimerOperation(request);
+            return;
+        }
+        const CommandScheduler::Entry added = scheduler.add(std::move(entry));
+        submitActionResult(scheduleResponse(request, v1::CmdStatus::Success, {}, CommandScheduler::toJsonObject(added)),
+                           "adapter.action.invoke");
+    }
+
+    void enqueueSleepTimerOperation(const sdk::AdapterActionInvokeRequest &request)
+    {
+        PendingOperation &op = queueOperation(PendingOperation::Kind::SleepTimer, false);
+        op.payload = request;
+        timingLog(QStringLiteral("cmd.queue type=sleep.timer cmdId=%1 action=%2 queueSize=%3")
+                      .arg(request.cmdId)
+                      .arg(QString::fromStdString(request.actionId))
+                      .arg(static_cast<int>(m_operationQueue.size())));
+        preemptRunningPoll();
+        scheduleQueuePump();
+    }
+
+    // Sets or clears the receiver's SLP timer for a native schedule. A failed set falls back to a local entry.
+    v1::ActionResponse runSleepTimerAction(const sdk::AdapterActionInvokeRequest &request, const OperationContext &ctx)
+    {
+        const QJsonObject params = parseJsonObject(request.paramsJson);
+        CommandScheduler &scheduler = CommandScheduler::instance();
+        if (request.actionId == "scheduleRemove") {
+            const QString id = params.value(QStringLiteral("id")).toVariant().toString();
+            const std::optional<CommandScheduler::Entry> entry = scheduler.find(m_externalId, id);
+            if (!entry.has_value())
+                return scheduleResponse(request, v1::CmdStatus::InvalidArgument, "Unknown schedule id");
+            if (entry->dueMs > nowMs() && !sendIscpCommand(QByteArrayLiteral("SLPOFF"), false, 0, ctx))
+                return scheduleResponse(request, unavailableCommandStatus(), unavailableCommandMessage());
+            scheduler.remove(m_externalId, id);
+            return scheduleResponse(request, v1::CmdStatus::Success, {}, CommandScheduler::toJsonObject(*entry));
+        }
+
+        CommandScheduler::Entry entry;
+        entry.externalId = m_externalId;
+        entry.channelId = kChannelPower;
+        entry.value = false;
+        entry.dueMs = scheduleDueMs(params).value_or(nowMs());
+        if (hasNativeSleepTimer()) {
+            // Another native add ran first while this one was queued; the receiver's timer is taken.
+            const CommandScheduler::Entry added = scheduler.add(std::move(entry));
+            return scheduleResponse(request, v1::CmdStatus::Success, {}, CommandScheduler::toJsonObject(added));
+        }
+        const int minutes =
+            qBound(1, static_cast<int>(qRound(static_cast<double>(entry.dueMs - nowMs()) / 60000.0)), kSleepTimerMaxMinutes);
+        const QByteArray command =
+            QByteArrayLiteral("SLP") + QByteArray::number(minutes, 16).rightJustified(2, '0').toUpper();
+        if (sendIscpCommand(command, false, 0, ctx)) {
+            entry.native = true;
+            entry.dueMs = nowMs() + minutes * 60000LL;
+        }
+        timingLog(QStringLiteral("schedule.sleep-timer minutes=%1 native=%2").arg(minutes).arg(entry.native ? 1 : 0));
+        const CommandScheduler::Entry added = scheduler.add(std::move(entry));
+        return scheduleResponse(request, v1::CmdStatus::Success, {}, CommandScheduler::toJsonObject(added));
+    }
+
+    // Store-and-forward write: parked latest-wins per channel until ttlMs passes, delivered by the next flush.
+    // Only the scene channels qualify, since the flush runs them as one scene.
+    v1::ActionResponse handleDeferredInvoke(const sdk::AdapterActionInvokeRequest &request)
+    {
+        v1::ActionResponse resp;
+        resp.id = request.cmdId;
+        resp.tsMs = nowMs();
+        resp.resultType = v1::ActionResultType::None;
+        const QJsonObject params = parseJsonObject(request.paramsJson);
+        const QString channelKey = params.value(QStringLiteral("channel")).toString().trimmed();
+        const ChannelId channel = channelIdFromName(channelKey.toStdString());
+        SceneTargets probe;
+        QString parseError;
+        if (channel != ChannelId::Power && channel != ChannelId::Volume && channel != ChannelId::Mute
+            && channel != ChannelId::Input) {
+            resp.status = v1::CmdStatus::InvalidArgument;
+            resp.error = "deferredInvoke supports power, volume, mute and input";
+            return resp;
+        }
+        if (!params.contains(QStringLiteral("value"))
+            || !parseSceneTargets(QJsonObject{{channelKey, params.value(QStringLiteral("value"))}}, &probe, &parseError)) {
+            resp.status = v1::CmdStatus::InvalidArgument;
+            resp.error = parseError.isEmpty() ? "deferredInvoke requires a value" : parseError.toStdString();
+            return resp;
+        }
+        const int ttlMs = qBound(1000, params.value(QStringLiteral("ttlMs")).toInt(kDeferredDefaultTtlMs), 86400000);
+        DeferredWrite &write = m_deferredWrites[static_cast<std::size_t>(channel)].emplace();
+        write.value = jsonToScalar(params.value(QStringLiteral("value")));
+        write.expiresMs = nowMs() + ttlMs;
+        write.seq = ++m_deferredSeq;
+        if (m_connected)
+            enqueueDeferredFlush();
+        timingLog(QStringLiteral("deferred.park cmdId=%1 channel=%2 ttlMs=%3 connected=%4")
+                      .arg(request.cmdId)
+                      .arg(channelKey)
+                      .arg(ttlMs)
+                      .arg(m_connected ? 1 : 0));
+        resp.status = v1::CmdStatus::Success;
+        resp.resultType = v1::ActionResultType::String;
+        resp.resultValue = toJson(QJsonObject{
+            {QStringLiteral("deferred"), !m_connected},
+            {QStringLiteral("expiresMs"), static_cast<double>(write.expiresMs)},
+        });
+        return resp;
+    }
+
+    void enqueueDeferredFlush()
+    {
+        for (const PendingOperation &queued : m_operationQueue) {
+            if (queued.kind == PendingOperation::Kind::DeferredFlush)
+                return;
+        }
+        queueOperation(PendingOperation::Kind::DeferredFlush, false);
+        preemptRunningPoll();
+        scheduleQueuePump();
+    }
+
+    // Delivers every live parked write as one scene: power first, then the setters in a single pipelined write.
+    // Entries stay parked when the receiver is still unreachable.
+    void runDeferredFlush(const OperationContext &ctx)
+    {
+        const std::int64_t now = nowMs();
+        SceneTargets targets;
+        std::array<std::uint64_t, kChannelIdCount> flushedSeq{};
+        for (std::size_t i = 0; i < m_deferredWrites.size(); ++i) {
+            std::optional<DeferredWrite> &write = m_deferredWrites[i];
+            if (!write.has_value())
+                continue;
+            if (write->expiresMs <= now) {
+                timingLog(QStringLiteral("deferred.expire channel=%1").arg(channelQName(static_cast<ChannelId>(i))));
+                write.reset();
+                continue;
+            }
+            flushedSeq[i] = write->seq;
+            switch (static_cast<ChannelId>(i)) {
+            case ChannelId::Power:
+                targets.power = scalarToBool(write->value);
+                break;
+            case ChannelId::Volume:
+                targets.volume = scalarToDouble(write->value);
+                break;
+            case ChannelId::Mute:
+                targets.mute = scalarToBool(write->value);
+                break;
+            case ChannelId::Input:
+                targets.input = resolveInputCode(scalarToQString(write->value));
+                break;
+            default:
+                break;
+            }
+        }
+        if (targets.isEmpty())
+            return;
+
+        v1::CmdStatus status = v1::CmdStatus::Success;
+        v1::Utf8String error;
+        runScene(targets, &status, &error, ctx);
+        const bool retryLater = status == v1::CmdStatus::TemporarilyOffline || ctx.isCancelled();
+        if (!retryLater) {
+            for (std::size_t i = 0; i < m_deferredWrites.size(); ++i) {
+                if (flushedSeq[i] != 0 && m_deferredWrites[i].has_value() && m_deferredWrites[i]->seq == flushedSeq[i])
+                    m_deferredWrites[i].reset();
+            }
+        }
+        timingLog(QStringLiteral("deferred.flush status=%1 error=%2 kept=%3")
+                      .arg(static_cast<int>(status))
+                      .arg(QString::fromStdString(error))
+                      .arg(retryLater ? 1 : 0));
+    }
+
+    bool hasDeferredWrites() const
+    {
+        return std::any_of(m_deferredWrites.begin(), m_deferredWrites.end(),
+                           [](const std::optional<DeferredWrite> &write) { return write.has_value(); });
+    }
+
+    void enqueueBrowseOperation(const sdk::AdapterActionInvokeRequest &request)
+    {
+        PendingOperation &op = queueOperation(PendingOperation::Kind::Browse, false);
+        op.payload = request;
+        timingLog(QStringLiteral("cmd.queue type=browse cmdId=%1 action=%2 queueSize=%3")
+                      .arg(request.cmdId)
+                      .arg(QString::fromStdString(request.actionId))
+                      .arg(static_cast<int>(m_operationQueue.size())));
+        preemptRunningPoll();
+        scheduleQueuePump();
+    }
+
+    v1::ActionResponse runBrowseAction(const sdk::AdapterActionInvokeRequest &request, const OperationContext &ctx)
+    {
+        v1::ActionResponse resp;
+        resp.id = request.cmdId;
+        resp.tsMs = nowMs();
+        resp.resultType = v1::ActionResultType::None;
+        auto fail = [&resp](v1::CmdStatus status, v1::Utf8String error) {
+            resp.status = status;
+            resp.error = std::move(error);
+            return resp;
+        };
+
+        const QJsonObject params = parseJsonObject(request.paramsJson);
+        const bool opening = (request.actionId == "netBrowseOpen");
+        if (!opening && !m_browse.open)
+            return fail(v1::CmdStatus::Failure, "No list open; call netBrowseOpen first");
+        if (m_powerState == PowerState::Off)
+            return fail(v1::CmdStatus::Failure, "Standby");
+
+        // NLA addresses items with four hex digits, so neither a page start nor an index may pass 0xFFFF.
+        const int lastIndex = (m_browse.totalItems > 0) ? std::min(m_browse.totalItems, 0x10000) - 1 : 0xFFFF;
+        int page = 0;
+        if (request.actionId == "netBrowsePage") {
+            page = params.value(QStringLiteral("page")).toInt(0);
+            if (page < 0 || page > lastIndex / m_browse.pageSize)
+                return fail(v1::CmdStatus::InvalidArgument,
+                            "page must be 0.." + std::to_string(lastIndex / m_browse.pageSize));
+        } else if (request.actionId == "netBrowseSelect" && !params.value(QStringLiteral("back")).toBool(false)) {
+            const int index = params.value(QStringLiteral("index")).toInt(-1);
+            if (index < 0 || index > lastIndex)
+                return fail(v1::CmdStatus::InvalidArgument, "index must be 0.." + std::to_string(lastIndex));
+        }
+
+        bool reused = false;
+        ControlSession *session = acquireSession(1500, QByteArrayLiteral("browse"), ctx, &reused);
+        if (!session)
+            return fail(unavailableCommandStatus(), unavailableCommandMessage());
+        if (!reused)
+            markConnectSuccess();
+
+        bool ok = true;
+        if (opening) {
+            ok = browseOpen(*session, params, ctx);
+        } else if (request.actionId == "netBrowseSelect") {
+            ok = browseSelect(*session, params, ctx);
+        }
+        std::optional<QJsonArray> items;
+        if (ok)
+            items = browsePage(*session, page, ctx);
+        releaseSession();
+        if (!items.has_value())
+            return fail(ctx.isCancelled() ? v1::CmdStatus::Failure : v1::CmdStatus::TemporarilyOffline,
+                        "Receiver did not return a list");
+
+        const int pageCount = (m_browse.totalItems >= 0)
+            ? std::max(1, (m_browse.totalItems + m_browse.pageSize - 1) / m_browse.pageSize)
+            : 1;
+        resp.status = v1::CmdStatus::Success;
+        resp.resultType = v1::ActionResultType::String;
+        resp.resultValue = toJson(QJsonObject{
+            {QStringLiteral("title"), m_browse.title},
+            {QStringLiteral("layer"), m_browse.layer},
+            {QStringLiteral("totalItems"), m_browse.totalItems},
+            {QStringLiteral("page"), m_browse.xml ? page : 0},
+            {QStringLiteral("pageSize"), m_browse.xml ? m_browse.pageSize : kNlsWindowLines},
+            {QStringLiteral("pageCount"), m_browse.xml ? pageCount : 1},
+            {QStringLiteral("source"), m_browse.xml ? QStringLiteral("nla") : QStringLiteral("nls")},
+            {QStringLiteral("items"), *items},
+        });
+        return resp;
+    }
+
+    // Starts a fresh cursor on the list the receiver shows, or on the NET top menu when params.top is set.
+    bool browseOpen(ControlSession &session, const QJsonObject &params, const OperationContext &ctx)
+    {
+        const bool xml = m_browse.xml;
+        m_browse = BrowseCursor();
+        m_browse.xml = xml;
+        m_browse.pageSize = qBound(1, params.value(QStringLiteral("pageSize")).toInt(kBrowseDefaultPageSize), 100);
+        if (params.value(QStringLiteral("top")).toBool(false) && !writeIscpCommands(session, {QByteArrayLiteral("NTCTOP")}))
+            return false;
+        if (!queryOnSession(session, QByteArrayLiteral("NLTQSTN"), kBrowseReplyTimeoutMs, ctx))
+            return false;
+        m_browse.open = true;
+        return true;
+    }
+
+    // Enters the item at the absolute list index (or goes up with params.back) and moves the cursor there.
+    bool browseSelect(ControlSession &session, const QJsonObject &params, const OperationContext &ctx)
+    {
+        QByteArray command;
+        if (params.value(QStringLiteral("back")).toBool(false)) {
+            command = QByteArrayLiteral("NTCRETURN");
+        } else {
+            const int index = params.value(QStringLiteral("index")).toInt(-1);
+            if (index < 0)
+                return false;
+            if (m_browse.xml) {
+                const std::optional<QByteArray> layer = hexField(m_browse.layer, 2);
+                const std::optional<QByteArray> item = hexField(index, 4);
+                if (!layer || !item)
+                    return false;
+                command = QByteArrayLiteral("NLAI") + *hexField(++m_browse.sequence, 4) + *layer + *item;
+            } else {
+                command = QByteArrayLiteral("NLSL") + QByteArray::number(index % kNlsWindowLines);
+            }
+        }
+        m_browse.pages.clear();
+        m_browse.nlsLines = {};
+        if (!writeIscpCommands(session, {command}))
+            return false;
+        // The receiver announces the new list with an NLT push; ask explicitly in case it does not.
+        QSet<QByteArray> pending{QByteArrayLiteral("NLT")};
+        if (awaitIscpReplies(session, pending, kBrowseReplyTimeoutMs, ctx))
+            return true;
+        return queryOnSession(session, QByteArrayLiteral("NLTQSTN"), kBrowseReplyTimeoutMs, ctx);
+    }
+
+    std::optional<QJsonArray> browsePage(ControlSession &session, int page, const OperationContext &ctx)
+    {
+        if (!m_browse.xml)
+            return browseNlsWindow(session, ctx);
+
+        for (auto it = m_browse.pages.begin(); it != m_browse.pages.end(); ++it) {
+            if (it->index != page)
+                continue;
+            m_browse.pages.splice(m_browse.pages.begin(), m_browse.pages, it);
+            return m_browse.pages.front().items;
+        }
+
+        const std::optional<QByteArray> layer = hexField(m_browse.layer, 2);
+        const std::optional<QByteArray> start = hexField(page * m_browse.pageSize, 4);
+        if (!layer || !start)
+            return std::nullopt;
+        m_browse.reply.clear();
+        const QByteArray command = QByteArrayLiteral("NLAL") + *hexField(++m_browse.sequence, 4) + *layer + *start
+            + *hexField(m_browse.pageSize, 4);
+        const std::int64_t replyDeadlineMs = ctx.stepDeadline(kBrowseReplyTimeoutMs);
+        bool replied = queryOnSession(session, command, kBrowseReplyTimeoutMs, ctx);
+        // A late reply to an earlier request satisfies the wait too but is dropped; keep waiting for ours.
+        while (replied && m_browse.reply.isEmpty() && nowMs() < replyDeadlineMs) {
+            session.seenCommands.remove(QByteArrayLiteral("NLA"));
+            QSet<QByteArray> pending{QByteArrayLiteral("NLA")};
+            replied = awaitIscpReplies(session, pending, static_cast<int>(replyDeadlineMs - nowMs()), ctx);
+        }
+        if (!replied || m_browse.reply.isEmpty()) {
+            // A lost or late reply says nothing about NLA support; fail this page and keep NLA.
+            timingLog(QStringLiteral("browse.nla.no-reply page=%1").arg(page));
+            return std::nullopt;
+        }
+        if (m_browse.reply == "N/A") {
+            timingLog(QStringLiteral("browse.nla.unsupported fallback=nls"));
+            m_browse.xml = false;
+            return browseNlsWindow(session, ctx);
+        }
+
+        std::optional<QJsonArray> items = parseBrowseReply(m_browse.reply);
+        m_browse.reply.clear();
+        if (!items.has_value())
+            return std::nullopt;
+        m_browse.pages.push_front(BrowseCursor::Page{page, *items});
+        if (m_browse.pages.size() > kBrowsePageCacheSize)
+            m_browse.pages.pop_back();
+        return items;
+    }
+
+    // Older receivers only push the visible ten-line window as NLS lines.
+    std::optional<QJsonArray> browseNlsWindow(ControlSession &session, const OperationContext &ctx)
+    {
+        QSet<QByteArray> pending{QByteArrayLiteral("NLS")};
+        if (std::all_of(m_browse.nlsLines.begin(), m_browse.nlsLines.end(), [](const QString &line) {
+                return line.isEmpty();
+            })) {
+            if (!queryOnSession(session, QByteArrayLiteral("NLTQSTN"), kBrowseReplyTimeoutMs, ctx))
+                return std::nullopt;
+            awaitIscpReplies(session, pending, kBrowseReplyTimeoutMs, ctx);
+        }
+        QJsonArray items;
+        for (int i = 0; i < kNlsWindowLines; ++i) {
+            const QString &title = m_browse.nlsLines[static_cast<std::size_t>(i)];
+            if (!title.isEmpty())
+                items.append(QJsonObject{{QStringLiteral("index"), i}, {QStringLiteral("title"), title}});
+        }
+        return items;
+    }
+
+    // True for the reply to the request last sent: NLA echoes that request's sequence number.
+    bool isCurrentBrowseReply(const QByteArray &reply) const
+    {
+        return reply.size() >= 5 && reply.mid(1, 4).toUpper() == *hexField(m_browse.sequence, 4);
+    }
+
+    // NLA reply: type, 4-digit sequence, status, UI type, 2 reserved, then the XML list.
+    std::optional<QJsonArray> parseBrowseReply(const QByteArray &reply)
+    {
+        if (reply.size() < 9 || reply.at(5) != 'S' || !isCurrentBrowseReply(reply))
+            return std::nullopt;
+        QJsonArray items;
+        QXmlStreamReader xml(reply.mid(9));
+        int offset = 0;
+        while (!xml.atEnd()) {
+            if (xml.readNext() != QXmlStreamReader::StartElement)
+                continue;
+            const QXmlStreamAttributes attributes = xml.attributes();
+            if (xml.name() == QLatin1String("items")) {
+                bool ok = false;
+                offset = attributes.value(QLatin1String("offset")).toInt(&ok, 16);
+                const int total = attributes.value(QLatin1String("totalitems")).toInt(&ok, 16);
+                if (ok)
+                    m_browse.totalItems = total;
+            } else if (xml.name() == QLatin1String("item")) {
+                items.append(QJsonObject{
+                    {QStringLiteral("index"), offset + static_cast<int>(items.size())},
+                    {QStringLiteral("title"), attributes.value(QLatin1String("title")).toString()},
+                    {QStringLiteral("iconId"), attributes.value(QLatin1String("iconid")).toString()},
+                });
+            }
+        }
+        if (xml.hasError()) {
+            timingLog(QStringLiteral("browse.nla.parse-error error=%1").arg(xml.errorString()));
+            return std::nullopt;
+        }
+        return items;
+    }
+
+    // NLT: service, UI type, layer type, cursor, item count, layer count, reserved, icons, status, title.
+    void handleBrowseTitle(const QByteArray &value)
+    {
+        if (value.size() < 22)
+            return;
+        bool ok = false;
+        const int items = value.mid(8, 4).toInt(&ok, 16);
+        if (ok)
+            m_browse.totalItems = items;
+        const int layer = value.mid(12, 2).toInt(&ok, 16);
+        if (ok && layer != m_browse.layer) {
+            m_browse.layer = layer;
+            m_browse.pages.clear();
+        }
+        m_browse.title = QString::fromUtf8(value.mid(22)).trimmed();
+    }
+
+    // Fixed-width upper-case hex; empty when the value does not fit, instead of silently dropping digits.
+    static std::optional<QByteArray> hexField(int value, int width)
+    {
+        const QByteArray digits = QByteArray::number(value, 16).toUpper();
+        if (value < 0 || digits.size() > width)
+            return std::nullopt;
+        return digits.rightJustified(width, '0');
+    }
+
+    // Input change or power-on: the receiver needs a moment to lock onto the new signal before IFA/IFV
+    // say anything useful, and a burst of changes only needs one fetch.
+    void scheduleSignalInfoRefresh()
+    {
+        if (!m_signalInfoTimer) {
+            m_signalInfoTimer = std::make_unique<QTimer>();
+            m_signalInfoTimer->setSingleShot(true);
+            QObject::connect(m_signalInfoTimer.get(), &QTimer::timeout, [this]() {
+                if (m_started && !m_stopping && !m_ipcDown)
+                    enqueueSignalInfoOperation(std::nullopt);
+            });
+        }
+        m_signalInfoTimer->start(kSignalInfoSettleMs);
+    }
+
+    void invalidateSignalInfo()
+    {
+        m_signalInfoFresh = false;
+        m_signalInfoRaw = {};
+    }
+
+    void enqueueSignalInfoOperation(std::optional<sdk::AdapterActionInvokeRequest> request)
+    {
+        if (!request.has_value()) {
+            for (const PendingOperation &queued : m_operationQueue) {
+                if (queued.kind == PendingOperation::Kind::SignalInfo)
+                    return;
+            }
+        }
+        PendingOperation &op = queueOperation(PendingOperation::Kind::SignalInfo, false);
+        if (request.has_value())
+            op.payload = std::move(*request);
+        else
+            op.payload = std::monostate{};
+        scheduleQueuePump();
+    }
+
+    // Both diagnostics in one pipelined exchange; the replies are parsed in handleIscpPayload.
+    bool runSignalInfoRefresh(const OperationContext &ctx)
+    {
+        if (m_powerState != PowerState::On)
+            return false;
+        bool reused = false;
+        ControlSession *session = acquireSession(1500, QByteArrayLiteral("signal-info"), ctx, &reused);
+        if (!session)
+            return false;
+        QSet<QByteArray> pending{QByteArrayLiteral("IFA"), QByteArrayLiteral("IFV")};
+        if (writeIscpCommands(*session, {QByteArrayLiteral("IFAQSTN"), QByteArrayLiteral("IFVQSTN")}))
+            awaitIscpReplies(*session, pending, kSignalInfoReplyTimeoutMs, ctx);
+        // Silence on a kept-open session means it is probably dead; the next operation reconnects.
+        if (reused && pending.size() == 2 && !ctx.isCancelled())
+            dropSession();
+        else
+            releaseSession();
+        timingLog(QStringLiteral("signal-info.refresh missing=%1").arg(pending.size()));
+        return pending.size() < 2;
+    }
+
+    v1::ActionResponse signalInfoResult(const sdk::AdapterActionInvokeRequest &request, bool fetched) const
+    {
+        v1::ActionResponse resp;
+        resp.id = request.cmdId;
+        resp.tsMs = nowMs();
+        if (!fetched) {
+            resp.status = (m_powerState == PowerState::On) ? unavailableCommandStatus() : v1::CmdStatus::Failure;
+            resp.error = (m_powerState == PowerState::On) ? unavailableCommandMessage() : "Receiver not powered on";
+            resp.resultType = v1::ActionResultType::None;
+            return resp;
+        }
+        QJsonObject result;
+        for (const ChannelId id : {ChannelId::AudioSignal, ChannelId::VideoSignal}) {
+            const JournalEntry &entry = m_stateJournal[static_cast<std::size_t>(id)];
+            if (entry.seq != 0)
+                result.insert(channelQName(id), parseJsonObject(scalarToQString(entry.value).toStdString()));
+        }
+        resp.status = v1::CmdStatus::Success;
+        resp.resultType = v1::ActionResultType::String;
+        resp.resultValue = toJson(result);
+        return resp;
+    }
+
+    void enqueueSceneOperation(const sdk::SceneInvokeRequest &request)
+    {
+        // A scene is a user write as well: stale queued polls must not delay it.
+        removeQueuedPollOperations();
+        cancelDeviceEffect("Cancelled by scene");
+
+        PendingOperation &op = queueOperation(PendingOperation::Kind::Scene, false);
+        op.payload = request;
+        timingLog(QStringLiteral("cmd.queue type=scene.invoke cmdId=%1 queueSize=%2")
+                      .arg(request.cmdId)
+                      .arg(static_cast<int>(m_operationQueue.size())));
+        preemptRunningPoll();
+        scheduleQueuePump();
+    }
+
+    void preemptRunningPoll()
+    {
+        if (!m_pollRunning || m_operationToken.isCancelled())
+            return;
+        m_preemptRequestedMs = nowMs();
+        m_operationToken.cancel();
+    }
+
+    void enqueueGroupOperation(GroupCommand command, GroupResultCallback callback)
+    {
+        if (!m_started || m_stopping) {
+            GroupMemberResult result;
+            result.externalId = m_externalId;
+            result.error = "Instance not running";
+            callback(std::move(result));
+            return;
+        }
+
+        removeQueuedPollOperations();
+        if (command.channelId == kChannelVolume
+            || command.channelId == kChannelMute
+            || command.channelId == kChannelPower) {
+            cancelDeviceEffect("Cancelled by group command");
+        }
+
+        // Group members run ahead of local work to keep the skew across receivers small.
+        const QString channelId = QString::fromStdString(command.channelId);
+        PendingOperation &op = queueOperation(PendingOperation::Kind::GroupInvoke, true);
+        op.payload = GroupInvocation{std::move(command), std::move(callback)};
+        timingLog(QStringLiteral("cmd.queue type=group.invoke channel=%1 queueSize=%2")
+                      .arg(channelId)
+                      .arg(static_cast<int>(m_operationQueue.size())));
+        preemptRunningPoll();
+        scheduleQueuePump();
+    }
+
+    void enqueueEffectStep()
+    {
+        if (!m_effect.has_value() || m_effectStepQueued)
+            return;
+        queueOperation(PendingOperation::Kind::EffectStep, true);
+        m_effectStepQueued = true;
+        preemptRunningPoll();
+        scheduleQueuePump();
+    }
+
+    void enqueueHeartbeatOperation()
+    {
+        // Anything already queued talks to the receiver anyway.
+        if (!m_started || m_stopping || m_operationRunning || !m_operationQueue.empty())
+            return;
+        queueOperation(PendingOperation::Kind::Heartbeat, false);
+        scheduleQueuePump();
+    }
+
+    void enqueuePollOperation(bool prioritize)
+    {
+        if (!m_started || m_stopping)
+            return;
+        // Background polls would only stretch effect steps; the effect refreshes state when done.
+        if (!prioritize && m_effect.has_value())
+            return;
+
+        // Keep exactly one queued poll operation at any time.
+        removeQueuedPollOperations();
+
+        queueOperation(PendingOperation::Kind::Poll, prioritize);
+        m_pollQueued = true;
+        scheduleQueuePump();
+    }
+
+    void scheduleQueuePump()
+    {
+        if (m_queuePumpScheduled)
+            return;
+        m_queuePumpScheduled = true;
+        QTimer::singleShot(0, m_dispatchContext.get(), [this]() {
+            m_queuePumpScheduled = false;
+            pumpQueue();
+        });
+    }
+
+    void pumpQueue()
+    {
+        if (m_operationRunning || m_stopping)
+            return;
+        if (m_operationQueue.empty())
+            return;
+
+        m_operationRunning = true;
+        PendingOperation op = std::move(m_operationQueue.front());
+        recycleOperation(m_operationQueue.begin());
+        if (op.kind == PendingOperation::Kind::Poll)
+            m_pollQueued = false;
+        const std::int64_t startedMs = nowMs();
+        const std::int64_t waitMs = (op.enqueuedMs > 0) ? (startedMs - op.enqueuedMs) : -1;
+
+        // Writes are bounded from the time core handed them over, so queueing counts against the budget.
+        OperationContext ctx;
+        switch (op.kind) {
+        case PendingOperation::Kind::Poll:
+            ctx.deadlineMs = startedMs + kPollDeadlineMs;
+            break;
+        case PendingOperation::Kind::GroupInvoke:
+            ctx.deadlineMs = std::get<GroupInvocation>(op.payload).command.deadlineMs;
+            break;
+        case PendingOperation::Kind::EffectStep:
+            ctx.deadlineMs = startedMs + kCommandDeadlineMs;
+            break;
+        default:
+            ctx.deadlineMs = ((op.enqueuedMs > 0) ? op.enqueuedMs : startedMs) + kCommandDeadlineMs;
+            break;
+        }
+        m_operationToken = ctx.token;
+        try {
+            runOperation(op, ctx, startedMs, waitMs);
+        } catch (const onkyo::OperationAbandoned &) {
+            // Destroyed by an event delivered during one of the waits: `this` is gone, so unwind untouched.
+            return;
+        }
+
+        m_operationRunning = false;
+        m_effectStepRunning = false;
+        runDeferredLifecycle();
+        if (m_handoffCallback) {
+            finishHandoff();
+            return;
+        }
+        if (!m_operationQueue.empty())
+            scheduleQueuePump();
+    }
+
+    void runOperation(PendingOperation &op, const OperationContext &ctx, std::int64_t startedMs, std::int64_t waitMs)
+    {
+        switch (op.kind) {
+        case PendingOperation::Kind::Poll:
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.start type=poll waitMs=%1 queueSize=%2")
+                              .arg(waitMs)
+                              .arg(static_cast<int>(m_operationQueue.size())));
+            }
+            m_pollRunning = true;
+            m_preemptRequestedMs = 0;
+            if (m_started && !m_stopping && !probeLivenessInstead())
+                requestInitialState(ctx);
+            m_pollRunning = false;
+            if (m_preemptRequestedMs > 0 && timingLogEnabled())
+                timingLog(QStringLiteral("poll.preempt latencyMs=%1").arg(nowMs() - m_preemptRequestedMs));
+            resetPollTimerCountdown();
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.end type=poll durationMs=%1")
+                              .arg(nowMs() - startedMs));
+            }
+            break;
+        case PendingOperation::Kind::ChannelInvoke: {
+            WriteBatch batch = takeWriteBatch(std::move(std::get<ChannelWrite>(op.payload)));
+            if (batch.size > 1) {
+                runWriteBatch(batch, ctx);
+                if (timingLogEnabled()) {
+                    timingLog(QStringLiteral("cmd.end type=channel.invoke.batch writes=%1 durationMs=%2")
+                                  .arg(static_cast<int>(batch.size))
+                                  .arg(nowMs() - startedMs));
+                }
+                break;
+            }
+            const ChannelWrite &write = batch.writes[0];
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.start type=channel.invoke cmdId=%1 channel=%2 waitMs=%3 queueSize=%4")
+                              .arg(write.cmdId)
+                              .arg(channelQName(write.channel))
+                              .arg(waitMs)
+                              .arg(static_cast<int>(m_operationQueue.size())));
+            }
+            v1::CmdResponse response = handleChannelInvoke(write, ctx);
+            const bool isPowerInvoke = (write.channel == ChannelId::Power);
+            const bool cmdSuccess = (response.status == v1::CmdStatus::Success);
+            submitCmdResult(std::move(response), "channel.invoke");
+            if (!isPowerInvoke && cmdSuccess) {
+                resetPollTimerCountdown();
+                QTimer::singleShot(1000, m_dispatchContext.get(), [this]() {
+                    if (m_started && !m_stopping)
+                        enqueuePollOperation(true);
+                });
+            }
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.end type=channel.invoke cmdId=%1 durationMs=%2")
+                              .arg(write.cmdId)
+                              .arg(nowMs() - startedMs));
+            }
+            break;
+        }
+        case PendingOperation::Kind::ProbeCurrentInput: {
+            const sdk::AdapterActionInvokeRequest &actionRequest =
+                std::get<sdk::AdapterActionInvokeRequest>(op.payload);
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.start type=adapter.action.invoke cmdId=%1 action=%2 waitMs=%3 queueSize=%4")
+                              .arg(actionRequest.cmdId)
+                              .arg(QString::fromStdString(actionRequest.actionId))
+                              .arg(waitMs)
+                              .arg(static_cast<int>(m_operationQueue.size())));
+            }
+            v1::ActionResponse response =
+                handleProbeCurrentInput(actionRequest, op.pollWasRunning, ctx);
+            submitActionResult(std::move(response), "adapter.action.invoke");
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.end type=adapter.action.invoke cmdId=%1 action=%2 durationMs=%3")
+                              .arg(actionRequest.cmdId)
+                              .arg(QString::fromStdString(actionRequest.actionId))
+                              .arg(nowMs() - startedMs));
+            }
+            break;
+        }
+        case PendingOperation::Kind::ReadChannel: {
+            const sdk::AdapterActionInvokeRequest &readRequest =
+                std::get<sdk::AdapterActionInvokeRequest>(op.payload);
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.start type=channel.read cmdId=%1 waitMs=%2 queueSize=%3")
+                              .arg(readRequest.cmdId)
+                              .arg(waitMs)
+                              .arg(static_cast<int>(m_operationQueue.size())));
+            }
+            submitActionResult(runReadChannel(readRequest, ctx), "adapter.action.invoke");
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.end type=channel.read cmdId=%1 durationMs=%2")
+                              .arg(readRequest.cmdId)
+                              .arg(nowMs() - startedMs));
+            }
+            break;
+        }
+        case PendingOperation::Kind::PresetList:
+            runPresetListFetch(ctx);
+            break;
+        case PendingOperation::Kind::DeferredFlush:
+            runDeferredFlush(ctx);
+            break;
+        case PendingOperation::Kind::SleepTimer: {
+            const sdk::AdapterActionInvokeRequest &timerRequest =
+                std::get<sdk::AdapterActionInvokeRequest>(op.payload);
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.start type=sleep.timer cmdId=%1 waitMs=%2")
+                              .arg(timerRequest.cmdId)
+                              .arg(waitMs));
+            }
+            submitActionResult(runSleepTimerAction(timerRequest, ctx), "adapter.action.invoke");
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.end type=sleep.timer cmdId=%1 durationMs=%2")
+                              .arg(timerRequest.cmdId)
+                              .arg(nowMs() - startedMs));
+            }
+            break;
+        }
+        case PendingOperation::Kind::Browse: {
+            const sdk::AdapterActionInvokeRequest &browseRequest =
+                std::get<sdk::AdapterActionInvokeRequest>(op.payload);
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.start type=browse cmdId=%1 action=%2 waitMs=%3")
+                              .arg(browseRequest.cmdId)
+                              .arg(QString::fromStdString(browseRequest.actionId))
+                              .arg(waitMs));
+            }
+            submitActionResult(runBrowseAction(browseRequest, ctx), "adapter.action.invoke");
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.end type=browse cmdId=%1 durationMs=%2")
+                              .arg(browseRequest.cmdId)
+                              .arg(nowMs() - startedMs));
+            }
+            break;
+        }
+        case PendingOperation::Kind::SignalInfo: {
+            const bool fetched = runSignalInfoRefresh(ctx);
+            if (const auto *request = std::get_if<sdk::AdapterActionInvokeRequest>(&op.payload))
+                submitActionResult(signalInfoResult(*request, fetched), "adapter.action.invoke");
+            break;
+        }
+        case PendingOperation::Kind::EffectStep:
+            m_effectStepQueued = false;
+            m_effectStepRunning = true;
+            runEffectStep(ctx);
+            break;
+        case PendingOperation::Kind::Heartbeat:
+            runHeartbeat(ctx);
+            break;
+        case PendingOperation::Kind::GroupInvoke: {
+            GroupInvocation &group = std::get<GroupInvocation>(op.payload);
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.start type=group.invoke channel=%1 waitMs=%2 queueSize=%3")
+                              .arg(QString::fromStdString(group.command.channelId))
+                              .arg(waitMs)
+                              .arg(static_cast<int>(m_operationQueue.size())));
+            }
+            GroupMemberResult result = runGroupCommand(group.command, ctx);
+            const bool cmdSuccess = (result.status == v1::CmdStatus::Success);
+            const bool isPowerInvoke = (group.command.channelId == kChannelPower);
+            group.callback(std::move(result));
+            if (!isPowerInvoke && cmdSuccess) {
+                resetPollTimerCountdown();
+                QTimer::singleShot(1000, m_dispatchContext.get(), [this]() {
+                    if (m_started && !m_stopping)
+                        enqueuePollOperation(true);
+                });
+            }
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.end type=group.invoke durationMs=%1").arg(nowMs() - startedMs));
+            }
+            break;
+        }
+        case PendingOperation::Kind::Scene: {
+            const sdk::SceneInvokeRequest &sceneRequest = std::get<sdk::SceneInvokeRequest>(op.payload);
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.start type=scene.invoke cmdId=%1 waitMs=%2 queueSize=%3")
+                              .arg(sceneRequest.cmdId)
+                              .arg(waitMs)
+                              .arg(static_cast<int>(m_operationQueue.size())));
+            }
+            v1::CmdResponse response = handleSceneInvoke(sceneRequest, ctx);
+            const bool cmdSuccess = (response.status == v1::CmdStatus::Success);
+            submitCmdResult(std::move(response), "scene.invoke");
+            if (cmdSuccess)
+                resetPollTimerCountdown();
+            if (timingLogEnabled()) {
+                timingLog(QStringLiteral("cmd.end type=scene.invoke cmdId=%1 durationMs=%2")
+                              .arg(sceneRequest.cmdId)
+                              .arg(nowMs() - startedMs));
+            }
+            break;
+        }
+        }
+    }
+
+    // Waits run nested event loops, so lifecycle calls can arrive in the middle of an operation. They are
+    // parked, the operation is cancelled, and pumpQueue replays them in order once it has unwound.
+    bool deferWhileOperationRuns(std::function<void()> handler)
+    {
+        if (!m_operationRunning)
+            return false;
+        m_deferredLifecycle.push_back(std::move(handler));
+        m_operationToken.cancel();
+        return true;
+    }
+
+    void runDeferredLifecycle()
+    {
+        std::vector<std::function<void()>> handlers;
+        handlers.swap(m_deferredLifecycle);
+        for (std::function<void()> &handler : handlers)
+            handler();
+    }
+
+    // Core link dropped: keep the receiver session and state cache for ipcGraceMs so a reconnecting core
+    // gets a snapshot instead of a rediscovery. Updates keep landing in the cache meanwhile.
+    void enterIpcGrace()
+    {
+        m_ipcDown = true;
+        m_synced = false;
+        stopPollingTimer();
+        flushPendingOperations("Core disconnected");
+        if (!m_ipcGraceTimer) {
+            m_ipcGraceTimer = std::make_unique<QTimer>();
+            m_ipcGraceTimer->setSingleShot(true);
+            QObject::connect(m_ipcGraceTimer.get(), &QTimer::timeout, [this]() {
+                if (deferWhileOperationRuns([this]() { teardownAfterDisconnect(); }))
+                    return;
+                timingLog(QStringLiteral("ipc.grace.expired externalId=%1").arg(QString::fromStdString(m_externalId)));
+                teardownAfterDisconnect();
+            });
+        }
+        m_ipcGraceTimer->start(m_ipcGraceMs);
+        m_ipcGraceUntilMs = nowMs() + m_ipcGraceMs;
+        timingLog(QStringLiteral("ipc.grace.start externalId=%1 graceMs=%2 session=%3")
+                      .arg(QString::fromStdString(m_externalId))
+                      .arg(m_ipcGraceMs)
+                      .arg(m_sessionEstablished ? 1 : 0));
+    }
+
+    void resumeAfterIpcGrace()
+    {
+        if (m_ipcGraceTimer)
+            m_ipcGraceTimer->stop();
+        m_ipcDown = false;
+        m_resumePending = true;
+        m_started = true;
+        m_stopping = false;
+        // A restarted core numbers its commands afresh; its cmdIds must not hit results meant for the old one.
+        m_recentCommands.clear();
+        v1::Utf8String err;
+        if (!sendConnectionStateChanged(m_connected, &err))
+            std::cerr << "failed to send connectionStateChanged: " << err << '\n';
+        emitResumeSnapshot();
+        startPollingTimer();
+        timingLog(QStringLiteral("ipc.grace.resume externalId=%1 session=%2")
+                      .arg(QString::fromStdString(m_externalId))
+                      .arg(m_sessionEstablished ? 1 : 0));
+    }
+
+    // Device plus every cached channel value in one go.
+    void emitResumeSnapshot()
+    {
+        if (m_deviceId.empty())
+            return;
+        m_synced = false;
+        emitDeviceSnapshot();
+        // With delta resync in use only what core has not acknowledged is sent.
+        const std::uint64_t sinceSeq = m_resyncNegotiated ? m_ackedSeq : 0;
+        if (sinceSeq == 0)
+            emitChannelState(ChannelId::Connectivity,
+                             static_cast<std::int64_t>(m_connected ? v1::ConnectivityStatus::Connected
+                                                                   : v1::ConnectivityStatus::Disconnected));
+        for (std::size_t i = 0; i < kChannelIdCount; ++i) {
+            if (m_stateJournal[i].seq > sinceSeq)
+                emitChannelState(static_cast<ChannelId>(i), m_stateJournal[i].value);
+        }
+        resetPollTimerCountdown();
     }
 
-    void enqueueChannelInvokeOperation(const sdk::ChannelInvokeRequest &request)
+    void teardownAfterDisconnect()
     {
-        // Command writes should not wait behind stale queued poll work.
-        removeQueuedPollOperations();
-
-        if (request.channelExternalId == kChannelVolume) {
-            for (auto it = m_operationQueue.begin(); it != m_operationQueue.end();) {
-                if (it->kind == PendingOperation::Kind::ChannelInvoke
-                    && it->channelRequest.deviceExternalId == request.deviceExternalId
-                    && it->channelRequest.channelExternalId == kChannelVolume) {
-                    v1::CmdResponse coalesced;
-                    coalesced.id = it->channelRequest.cmdId;
-                    coalesced.tsMs = nowMs();
-                    coalesced.status = v1::CmdStatus::Success;
-                    submitCmdResult(std::move(coalesced), "channel.invoke.coalesced");
-                    it = m_operationQueue.erase(it);
-                    continue;
-                }
-                ++it;
-            }
-        }
-
-        PendingOperation op;
-        op.kind = PendingOperation::Kind::ChannelInvoke;
-        op.enqueuedMs = nowMs();
-        op.channelRequest = request;
-        m_operationQueue.push_back(std::move(op));
-        timingLog(QStringLiteral("cmd.queue type=channel.invoke cmdId=%1 queueSize=%2")
-                      .arg(request.cmdId)
-                      .arg(static_cast<int>(m_operationQueue.size())));
-        scheduleQueuePump();
+        m_ipcDown = false;
+        m_resumePending = false;
+        if (m_ipcGraceTimer)
+            m_ipcGraceTimer->stop();
+        m_stopping = true;
+        m_started = false;
+        m_synced = false;
+        m_lastReportedPower.reset();
+        m_lastReportedMute.reset();
+        m_lastReportedVolume.reset();
+        m_lastReportedInput.clear();
+        m_hasLastReportedInput = false;
+        m_powerState = PowerState::Unknown;
+        m_consecutiveConnectFailures = 0;
+        m_pollRunning = false;
+        flushPendingOperations("Instance disconnected");
+        m_recentCommands.clear();
+        dropSession();
+        setConnected(false);
+        stopPollingTimer();
     }
 
-    void enqueueProbeCurrentOperation(const sdk::AdapterActionInvokeRequest &request)
+    void prepareHandoff(std::function<void(HandoffRecord)> callback)
     {
-        PendingOperation op;
-        op.kind = PendingOperation::Kind::ProbeCurrentInput;
-        op.pollWasRunning = m_pollRunning;
-        op.enqueuedMs = nowMs();
-        op.actionRequest = request;
-        m_operationQueue.push_front(std::move(op));
-        timingLog(QStringLiteral("cmd.queue type=adapter.action.invoke cmdId=%1 action=%2 queueSize=%3")
-                      .arg(request.cmdId)
-                      .arg(QString::fromStdString(request.actionId))
-                      .arg(static_cast<int>(m_operationQueue.size())));
-        scheduleQueuePump();
+        m_handoffCallback = std::move(callback);
+        if (m_operationRunning) {
+            // pumpQueue finishes the export once the running operation has unwound.
+            m_operationToken.cancel();
+            return;
+        }
+        finishHandoff();
     }
 
-    void enqueuePollOperation(bool prioritize)
+    // Stops all work and exports the open session without closing it; the connection lives on in the
+    // duplicated descriptor until the new process adopts it.
+    void finishHandoff()
     {
-        if (!m_started || m_stopping)
-            return;
+        std::function<void(HandoffRecord)> callback = std::move(m_handoffCallback);
+        m_handoffCallback = nullptr;
 
-        // Keep exactly one queued poll operation at any time.
-        removeQueuedPollOperations();
+        HandoffRecord record = exportSession();
 
-        PendingOperation op;
-        op.kind = PendingOperation::Kind::Poll;
-        op.enqueuedMs = nowMs();
-        if (prioritize)
-            m_operationQueue.push_front(std::move(op));
-        else
-            m_operationQueue.push_back(std::move(op));
-        m_pollQueued = true;
-        scheduleQueuePump();
+        m_stopping = true;
+        m_started = false;
+        stopPollingTimer();
+        stopSessionTimers();
+        flushPendingOperations("Sidecar upgrade in progress");
+        timingLog(QStringLiteral("handoff.export externalId=%1 session=%2")
+                      .arg(QString::fromStdString(m_externalId))
+                      .arg(record.fd >= 0 ? 1 : 0));
+        callback(std::move(record));
     }
 
-    void scheduleQueuePump()
+    // Detaches the open session into a duplicated descriptor and serializes the state cache. Runs on the
+    // instance's worker thread, which owns the socket it reads and deletes.
+    HandoffRecord exportSession()
     {
-        if (m_queuePumpScheduled)
-            return;
-        m_queuePumpScheduled = true;
-        QTimer::singleShot(0, [this]() {
-            m_queuePumpScheduled = false;
-            pumpQueue();
-        });
+        HandoffRecord record;
+        record.externalId = m_externalId;
+        QJsonObject state;
+        state.insert(QStringLiteral("preferredHost"), m_preferredHost);
+        state.insert(QStringLiteral("lastInputCode"), m_lastInputCode);
+        if (m_powerState != PowerState::Unknown)
+            state.insert(QStringLiteral("power"), m_powerState == PowerState::On);
+        if (m_lastReportedVolume.has_value())
+            state.insert(QStringLiteral("volume"), static_cast<double>(*m_lastReportedVolume));
+        if (m_lastReportedMute.has_value())
+            state.insert(QStringLiteral("mute"), *m_lastReportedMute);
+        if (m_hasLastReportedInput)
+            state.insert(QStringLiteral("input"), m_lastReportedInput);
+#ifdef Q_OS_UNIX
+        // A serial bridge dies with this process; the successor reopens the device instead.
+        if (m_session && m_sessionEstablished && m_session->socket.state() == QAbstractSocket::ConnectedState
+            && !m_session->bridged()) {
+            QObject::disconnect(&m_session->socket, nullptr, nullptr, nullptr);
+            // Bytes Qt already read off the descriptor travel in the record; the rest stays in the kernel.
+            m_session->rxBuffer.append(m_session->socket.readAll());
+            record.fd = ::dup(static_cast<int>(m_session->socket.socketDescriptor()));
+            state.insert(QStringLiteral("host"), m_session->host);
+            state.insert(QStringLiteral("endpoint"), m_session->endpoint);
+            state.insert(QStringLiteral("framing"), static_cast<int>(m_session->framing.index()));
+            state.insert(QStringLiteral("rx"), QString::fromLatin1(m_session->rxBuffer.toBase64()));
+            m_sessionEstablished = false;
+            m_session.reset();
+        }
+#endif
+        record.state = state;
+        return record;
     }
 
-    void pumpQueue()
+    void adoptHandoff(HandoffRecord record)
     {
-        if (m_operationRunning || m_stopping)
-            return;
-        if (m_operationQueue.empty())
+        const QJsonObject &state = record.state;
+        m_preferredHost = state.value(QStringLiteral("preferredHost")).toString();
+        m_lastInputCode = state.value(QStringLiteral("lastInputCode")).toString();
+        const QJsonValue power = state.value(QStringLiteral("power"));
+        if (power.isBool()) {
+            m_powerState = power.toBool() ? PowerState::On : PowerState::Off;
+            m_lastReportedPower = power.toBool();
+        }
+        if (state.value(QStringLiteral("volume")).isDouble())
+            m_lastReportedVolume = static_cast<std::int64_t>(state.value(QStringLiteral("volume")).toDouble());
+        if (state.value(QStringLiteral("mute")).isBool())
+            m_lastReportedMute = state.value(QStringLiteral("mute")).toBool();
+        if (state.value(QStringLiteral("input")).isString()) {
+            m_lastReportedInput = state.value(QStringLiteral("input")).toString();
+            m_hasLastReportedInput = true;
+        }
+        if (m_lastReportedPower.has_value())
+            journalChannelState(ChannelId::Power, *m_lastReportedPower);
+        if (m_lastReportedVolume.has_value())
+            journalChannelState(ChannelId::Volume, *m_lastReportedVolume);
+        if (m_lastReportedMute.has_value())
+            journalChannelState(ChannelId::Mute, *m_lastReportedMute);
+        if (m_hasLastReportedInput)
+            journalChannelState(ChannelId::Input, m_lastReportedInput.toStdString());
+        if (record.fd < 0)
             return;
 
-        m_operationRunning = true;
-        PendingOperation op = std::move(m_operationQueue.front());
-        m_operationQueue.pop_front();
-        if (op.kind == PendingOperation::Kind::Poll)
-            m_pollQueued = false;
-        const std::int64_t startedMs = nowMs();
-        const std::int64_t waitMs = (op.enqueuedMs > 0) ? (startedMs - op.enqueuedMs) : -1;
-
-        switch (op.kind) {
-        case PendingOperation::Kind::Poll:
-            timingLog(QStringLiteral("cmd.start type=poll waitMs=%1 queueSize=%2")
-                          .arg(waitMs)
-                          .arg(static_cast<int>(m_operationQueue.size())));
-            m_pollRunning = true;
-            if (m_started && !m_stopping)
-                requestInitialState();
-            m_pollRunning = false;
-            resetPollTimerCountdown();
-            timingLog(QStringLiteral("cmd.end type=poll durationMs=%1")
-                          .arg(nowMs() - startedMs));
+        ensureSession();
+        if (!m_session->socket.setSocketDescriptor(record.fd, QAbstractSocket::ConnectedState, QIODevice::ReadWrite)) {
+            timingLog(QStringLiteral("handoff.adopt.failed externalId=%1 err=%2")
+                          .arg(QString::fromStdString(m_externalId))
+                          .arg(m_session->socket.errorString()));
+            closeHandoffDescriptor(record.fd);
+            return;
+        }
+        m_session->host = state.value(QStringLiteral("host")).toString();
+        m_session->endpoint = state.value(QStringLiteral("endpoint")).toString();
+        switch (state.value(QStringLiteral("framing")).toInt(0)) {
+        case 1:
+            m_session->framing = RawIscpFraming<false>{};
             break;
-        case PendingOperation::Kind::ChannelInvoke: {
-            timingLog(QStringLiteral("cmd.start type=channel.invoke cmdId=%1 channel=%2 waitMs=%3 queueSize=%4")
-                          .arg(op.channelRequest.cmdId)
-                          .arg(QString::fromStdString(op.channelRequest.channelExternalId))
-                          .arg(waitMs)
-                          .arg(static_cast<int>(m_operationQueue.size())));
-            v1::CmdResponse response = handleChannelInvoke(op.channelRequest);
-            const bool isPowerInvoke = (op.channelRequest.channelExternalId == kChannelPower);
-            const bool cmdSuccess = (response.status == v1::CmdStatus::Success);
-            submitCmdResult(std::move(response), "channel.invoke");
-            if (!isPowerInvoke && cmdSuccess) {
-                resetPollTimerCountdown();
-                QTimer::singleShot(1000, [this]() {
-                    if (m_started && !m_stopping)
-                        enqueuePollOperation(true);
-                });
-            }
-            timingLog(QStringLiteral("cmd.end type=channel.invoke cmdId=%1 durationMs=%2")
-                          .arg(op.channelRequest.cmdId)
-                          .arg(nowMs() - startedMs));
+        case 2:
+            m_session->framing = RawIscpFraming<true>{};
             break;
-        }
-        case PendingOperation::Kind::ProbeCurrentInput: {
-            timingLog(QStringLiteral("cmd.start type=adapter.action.invoke cmdId=%1 action=%2 waitMs=%3 queueSize=%4")
-                          .arg(op.actionRequest.cmdId)
-                          .arg(QString::fromStdString(op.actionRequest.actionId))
-                          .arg(waitMs)
-                          .arg(static_cast<int>(m_operationQueue.size())));
-            v1::ActionResponse response =
-                handleProbeCurrentInput(op.actionRequest, op.pollWasRunning);
-            submitActionResult(std::move(response), "adapter.action.invoke");
-            timingLog(QStringLiteral("cmd.end type=adapter.action.invoke cmdId=%1 action=%2 durationMs=%3")
-                          .arg(op.actionRequest.cmdId)
-                          .arg(QString::fromStdString(op.actionRequest.actionId))
-                          .arg(nowMs() - startedMs));
+        default:
+            m_session->framing = EiscpFraming{};
             break;
         }
-        }
-
-        m_operationRunning = false;
-        if (!m_operationQueue.empty())
-            scheduleQueuePump();
+        m_session->rxBuffer = QByteArray::fromBase64(state.value(QStringLiteral("rx")).toString().toLatin1());
+        m_session->seenCommands.clear();
+        m_sessionEstablished = true;
+        m_resumePending = true;
+        markConnectSuccess();
+        noteSessionActivity();
+        // Frames that arrived while neither process was reading are still queued in the kernel.
+        readIscpSession(*m_session);
+        timingLog(QStringLiteral("handoff.adopt externalId=%1 host=%2")
+                      .arg(QString::fromStdString(m_externalId))
+                      .arg(m_session->host));
     }
 
     void flushPendingOperations(const v1::Utf8String &reason)
     {
+        // The running operation ends at its next wait instead of finishing its retries.
+        m_operationToken.cancel();
+        cancelDeviceEffect(reason);
         if (m_operationQueue.empty()) {
             m_pollQueued = false;
             return;
         }
 
-        std::deque<PendingOperation> pending;
+        OperationQueue pending;
         pending.swap(m_operationQueue);
         m_pollQueued = false;
 
         for (PendingOperation &op : pending) {
-            if (op.kind == PendingOperation::Kind::ChannelInvoke) {
+            if (op.kind == PendingOperation::Kind::ChannelInvoke
+                || op.kind == PendingOperation::Kind::Scene) {
                 v1::CmdResponse response;
-                response.id = op.channelRequest.cmdId;
+                response.id = (op.kind == PendingOperation::Kind::Scene)
+                    ? std::get<sdk::SceneInvokeRequest>(op.payload).cmdId
+                    : std::get<ChannelWrite>(op.payload).cmdId;
                 response.tsMs = nowMs();
                 response.status = v1::CmdStatus::Failure;
                 response.error = reason;
-                submitCmdResult(std::move(response), "channel.invoke.flush");
+                // Not cached: a retry of a flushed write should run, not replay the flush failure.
+                m_recentCommands.forget(response.id);
+                sendCmdResponse(response,
+                                (op.kind == PendingOperation::Kind::Scene) ? "scene.invoke.flush"
+                                                                           : "channel.invoke.flush");
+                continue;
+            }
+            if (op.kind == PendingOperation::Kind::GroupInvoke) {
+                GroupMemberResult result;
+                result.externalId = m_externalId;
+                result.error = reason;
+                std::get<GroupInvocation>(op.payload).callback(std::move(result));
                 continue;
             }
-            if (op.kind == PendingOperation::Kind::ProbeCurrentInput) {
+            if (op.kind == PendingOperation::Kind::ProbeCurrentInput
+                || op.kind == PendingOperation::Kind::ReadChannel
+                || op.kind == PendingOperation::Kind::Browse
+                || op.kind == PendingOperation::Kind::SleepTimer
+                || (op.kind == PendingOperation::Kind::SignalInfo
+                    && std::holds_alternative<sdk::AdapterActionInvokeRequest>(op.payload))) {
                 v1::ActionResponse response;
-                response.id = op.actionRequest.cmdId;
+                response.id = std::get<sdk::AdapterActionInvokeRequest>(op.payload).cmdId;
                 response.tsMs = nowMs();
                 response.status = v1::CmdStatus::Failure;
                 response.error = reason;
@@ -992,6 +4213,7 @@ private:
                 submitActionResult(std::move(response), "adapter.action.invoke.flush");
             }
         }
+        m_operationPool.reclaim(pending, clearOperation);
     }
 
     void resetPollTimerCountdown()
@@ -1004,19 +4226,13 @@ private:
         m_pollTimer->start();
     }
 
-    v1::CmdResponse handleChannelInvoke(const sdk::ChannelInvokeRequest &request)
+    v1::CmdResponse handleChannelInvoke(const ChannelWrite &request, const OperationContext &ctx)
     {
         v1::CmdResponse resp;
         resp.id = request.cmdId;
         resp.tsMs = nowMs();
 
-        if (request.deviceExternalId != m_deviceId) {
-            resp.status = v1::CmdStatus::NotSupported;
-            resp.error = "Unknown device";
-            return resp;
-        }
-
-        if (request.channelExternalId == kChannelPower) {
+        if (request.channel == ChannelId::Power) {
             const auto on = scalarToBool(request.value);
             if (!on.has_value()) {
                 resp.status = v1::CmdStatus::InvalidArgument;
@@ -1036,7 +4252,17 @@ private:
             }
 
             const QByteArray command = *on ? QByteArrayLiteral("PWR01") : QByteArrayLiteral("PWR00");
-            if (!sendIscpCommand(command, false, 0)) {
+            // Waking a receiver from deep standby takes longer than a command deadline allows.
+            OperationContext sendCtx = ctx;
+            if (*on && wakeOnLanArmed()) {
+                sendCtx.deadlineMs = std::max(ctx.deadlineMs, nowMs() + m_wakeTimeoutMs);
+                if (!wakeReceiver(sendCtx)) {
+                    resp.status = unavailableCommandStatus();
+                    resp.error = "Receiver did not wake";
+                    return resp;
+                }
+            }
+            if (!sendIscpCommand(command, false, 0, sendCtx)) {
                 resp.status = unavailableCommandStatus();
                 resp.error = unavailableCommandMessage();
                 return resp;
@@ -1049,7 +4275,7 @@ private:
         }
 
         if (m_powerState == PowerState::Unknown)
-            requestInitialState();
+            requestInitialState(ctx);
 
         if (m_powerState == PowerState::Off) {
             resp.status = v1::CmdStatus::Failure;
@@ -1063,81 +4289,526 @@ private:
             return resp;
         }
 
-        if (request.channelExternalId == kChannelVolume) {
+        const std::optional<QByteArray> command = setterCommand(request, &resp);
+        if (!command.has_value())
+            return resp;
+        QList<QByteArray> frames{*command};
+        // Recall from another source: select the preset's band in the same write, no lookup on the receiver.
+        QString tunerInput;
+        if (request.channel == ChannelId::TunerPreset && !isTunerInput(m_lastInputCode)) {
+            tunerInput = tunerInputForPreset(command->mid(3));
+            frames.prepend(QByteArrayLiteral("SLI") + tunerInput.toLatin1());
+        }
+        if (sendIscpCommands(frames, false, 0, ctx)) {
+            if (!tunerInput.isEmpty()) {
+                m_lastInputCode = tunerInput;
+                emitInputState(tunerInput);
+            }
+            completeSetter(request, &resp);
+        } else {
+            resp.status = unavailableCommandStatus();
+            resp.error = unavailableCommandMessage();
+        }
+        return resp;
+    }
+
+    // ISCP frame for a volume, mute or input write; invalid values fill in resp instead.
+    std::optional<QByteArray> setterCommand(const ChannelWrite &request, v1::CmdResponse *resp) const
+    {
+        switch (request.channel) {
+        case ChannelId::Volume: {
             const auto requested = scalarToDouble(request.value);
             if (!requested.has_value()) {
-                resp.status = v1::CmdStatus::InvalidArgument;
-                resp.error = "Volume must be numeric";
-                return resp;
+                resp->status = v1::CmdStatus::InvalidArgument;
+                resp->error = "Volume must be numeric";
+                return std::nullopt;
+            }
+            return volumeCommand(qBound(0.0, *requested, 100.0));
+        }
+        case ChannelId::Mute: {
+            const auto muted = scalarToBool(request.value);
+            if (!muted.has_value()) {
+                resp->status = v1::CmdStatus::InvalidArgument;
+                resp->error = "Mute expects boolean";
+                return std::nullopt;
+            }
+            return *muted ? QByteArrayLiteral("AMT01") : QByteArrayLiteral("AMT00");
+        }
+        case ChannelId::Input: {
+            const QString input = resolveInputCode(scalarToQString(request.value));
+            if (input.length() != 2) {
+                resp->status = v1::CmdStatus::InvalidArgument;
+                resp->error = "Input expects 2-digit code (e.g. 01)";
+                return std::nullopt;
+            }
+            return QByteArrayLiteral("SLI") + input.toLatin1();
+        }
+        case ChannelId::ListeningMode:
+        case ChannelId::Dimmer: {
+            const QByteArray code = scalarToQString(request.value).trimmed().toUpper().toLatin1();
+            static const QRegularExpression kCodeRe(QStringLiteral("^[0-9A-F]{2}$"));
+            if (!kCodeRe.match(QString::fromLatin1(code)).hasMatch()) {
+                resp->status = v1::CmdStatus::InvalidArgument;
+                resp->error = "Expects 2-digit hex code (e.g. 0C)";
+                return std::nullopt;
+            }
+            return (request.channel == ChannelId::Dimmer ? QByteArrayLiteral("DIM") : QByteArrayLiteral("LMD")) + code;
+        }
+        case ChannelId::TunerPreset: {
+            const std::optional<QString> code = presetCode(request.value);
+            if (!code.has_value()) {
+                resp->status = v1::CmdStatus::InvalidArgument;
+                resp->error = "Preset expects a hex code from 01 to 28, #1 to #40 or a preset name";
+                return std::nullopt;
+            }
+            return QByteArrayLiteral("PRS") + code->toLatin1();
+        }
+        case ChannelId::TunerFrequency: {
+            const std::optional<QString> frequency = tunerFrequencyDigits(request.value);
+            if (!frequency.has_value()) {
+                resp->status = v1::CmdStatus::InvalidArgument;
+                resp->error = "Frequency expects 5 digits (08750) or MHz/kHz (87.5, 531)";
+                return std::nullopt;
+            }
+            return QByteArrayLiteral("TUN") + frequency->toLatin1();
+        }
+        case ChannelId::Bass:
+        case ChannelId::Treble:
+        case ChannelId::CenterLevel:
+        case ChannelId::SubwooferLevel: {
+            const auto level = scalarToDouble(request.value);
+            if (!level.has_value()) {
+                resp->status = v1::CmdStatus::InvalidArgument;
+                resp->error = "Level must be numeric";
+                return std::nullopt;
+            }
+            const int clamped = clampedLevel(request.channel, *level);
+            switch (request.channel) {
+            case ChannelId::Bass:
+                return QByteArrayLiteral("TFRB") + signedIscpLevel(clamped);
+            case ChannelId::Treble:
+                return QByteArrayLiteral("TFRT") + signedIscpLevel(clamped);
+            case ChannelId::CenterLevel:
+                return QByteArrayLiteral("CTL") + signedIscpLevel(clamped);
+            default:
+                return QByteArrayLiteral("SWL") + signedIscpLevel(clamped);
             }
+        }
+        default:
+            resp->status = v1::CmdStatus::NotSupported;
+            resp->error = "Channel not supported";
+            return std::nullopt;
+        }
+    }
 
-            const double clampedPercent = qBound(0.0, *requested, 100.0);
-            const int rawValue = qBound(0,
-                static_cast<int>(qRound((clampedPercent / 100.0) * m_volumeMaxRaw)),
-                m_volumeMaxRaw);
-            const QByteArray payload =
-                QByteArrayLiteral("MVL") + QByteArray::number(rawValue, 16).rightJustified(2, '0').toUpper();
-            if (sendIscpCommand(payload, false, 0)) {
-                resp.status = v1::CmdStatus::Success;
-                resp.finalValue = static_cast<std::int64_t>(qRound(clampedPercent));
-                emitVolumeState(static_cast<std::int64_t>(qRound(clampedPercent)));
-            } else {
-                resp.status = unavailableCommandStatus();
-                resp.error = unavailableCommandMessage();
+    // A setter reached the receiver: final value on the response, new value on the channel.
+    void completeSetter(const ChannelWrite &request, v1::CmdResponse *resp)
+    {
+        resp->status = v1::CmdStatus::Success;
+        switch (request.channel) {
+        case ChannelId::Volume: {
+            const auto volume = static_cast<std::int64_t>(qRound(qBound(0.0, *scalarToDouble(request.value), 100.0)));
+            resp->finalValue = volume;
+            emitVolumeState(volume);
+            break;
+        }
+        case ChannelId::Mute: {
+            const bool muted = *scalarToBool(request.value);
+            resp->finalValue = muted;
+            emitMuteState(muted);
+            break;
+        }
+        case ChannelId::Input: {
+            const QString input = resolveInputCode(scalarToQString(request.value));
+            resp->finalValue = input.toStdString();
+            m_lastInputCode = input;
+            emitInputState(input);
+            break;
+        }
+        case ChannelId::ListeningMode:
+        case ChannelId::Dimmer: {
+            const std::string code = scalarToQString(request.value).trimmed().toUpper().toStdString();
+            resp->finalValue = code;
+            emitExtendedState(request.channel, code);
+            break;
+        }
+        case ChannelId::TunerPreset: {
+            const std::string code = presetCode(request.value).value_or(QString()).toStdString();
+            resp->finalValue = code;
+            emitExtendedState(request.channel, code);
+            break;
+        }
+        case ChannelId::TunerFrequency: {
+            const std::string frequency = tunerFrequencyDigits(request.value).value_or(QString()).toStdString();
+            resp->finalValue = frequency;
+            emitExtendedState(request.channel, frequency);
+            break;
+        }
+        case ChannelId::Bass:
+        case ChannelId::Treble:
+        case ChannelId::CenterLevel:
+        case ChannelId::SubwooferLevel: {
+            const auto level = static_cast<std::int64_t>(clampedLevel(request.channel, *scalarToDouble(request.value)));
+            resp->finalValue = level;
+            emitExtendedState(request.channel, level);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // Preset as the 2-digit hex code PRS expects. The value is that hex code (what the channel reports and the
+    // choices carry), whether or not the NRI list is cached; "#<n>" is the decimal slot, a cached name also works.
+    std::optional<QString> presetCode(const v1::ScalarValue &value) const
+    {
+        const QString text = scalarToQString(value).trimmed();
+        bool ok = false;
+        int slot = 0;
+        if (text.startsWith(QLatin1Char('#'))) {
+            slot = text.mid(1).toInt(&ok, 10);
+        } else {
+            static const QRegularExpression kCodeRe(QStringLiteral("^[0-9A-Fa-f]{1,2}$"));
+            if (kCodeRe.match(text).hasMatch())
+                slot = text.toInt(&ok, 16);
+        }
+        if (ok && slot >= 1 && slot <= kTunerPresetSlots)
+            return QString::number(slot, 16).rightJustified(2, QLatin1Char('0')).toUpper();
+        for (const TunerPreset &preset : m_tunerPresets) {
+            if (preset.name.compare(text, Qt::CaseInsensitive) == 0)
+                return preset.code;
+        }
+        return std::nullopt;
+    }
+
+    // TUN takes 5 digits: FM in 10 kHz steps (08750 = 87.50 MHz), AM in kHz (00531).
+    static std::optional<QString> tunerFrequencyDigits(const v1::ScalarValue &value)
+    {
+        const QString text = scalarToQString(value).trimmed();
+        bool ok = false;
+        const double number = text.toDouble(&ok);
+        if (!ok || number <= 0.0)
+            return std::nullopt;
+        const bool fmMhz = text.contains(QLatin1Char('.')) || number < 200.0;
+        const int digits = fmMhz ? static_cast<int>(qRound(number * 100.0)) : static_cast<int>(qRound(number));
+        if (digits > 99999)
+            return std::nullopt;
+        return QString::number(digits).rightJustified(5, QLatin1Char('0'));
+    }
+
+    // FM unless the cached list says otherwise.
+    QString tunerInputForPreset(const QByteArray &code) const
+    {
+        for (const TunerPreset &preset : m_tunerPresets) {
+            if (preset.code.toLatin1() != code)
+                continue;
+            if (preset.band == 2)
+                return QStringLiteral("25");
+            if (preset.band == 3)
+                return QStringLiteral("33");
+            break;
+        }
+        return QStringLiteral("24");
+    }
+
+    v1::AdapterConfigOptionList presetChoicesForChannel() const
+    {
+        v1::AdapterConfigOptionList choices;
+        if (m_tunerPresets.empty()) {
+            for (int slot = 1; slot <= kTunerPresetSlots; ++slot) {
+                v1::AdapterConfigOption option;
+                option.value = QString::number(slot, 16).rightJustified(2, QLatin1Char('0')).toUpper().toStdString();
+                option.label = QStringLiteral("Preset %1").arg(slot).toStdString();
+                choices.push_back(std::move(option));
             }
-            return resp;
+            return choices;
         }
+        choices.reserve(m_tunerPresets.size());
+        for (const TunerPreset &preset : m_tunerPresets) {
+            v1::AdapterConfigOption option;
+            option.value = preset.code.toStdString();
+            const QString name = preset.name.isEmpty() ? QStringLiteral("Preset %1").arg(preset.code) : preset.name;
+            option.label = (preset.frequency.isEmpty() ? name : QStringLiteral("%1 (%2)").arg(name, preset.frequency))
+                               .toStdString();
+            choices.push_back(std::move(option));
+        }
+        return choices;
+    }
 
-        if (request.channelExternalId == kChannelMute) {
-            const auto muted = scalarToBool(request.value);
-            if (!muted.has_value()) {
-                resp.status = v1::CmdStatus::InvalidArgument;
-                resp.error = "Mute expects boolean";
-                return resp;
+    // Once per link: the preset list from NRI. Receivers without NRI keep the numbered slots.
+    void enqueuePresetListOperation()
+    {
+        if (m_presetListEpoch == m_linkEpoch)
+            return;
+        for (const PendingOperation &queued : m_operationQueue) {
+            if (queued.kind == PendingOperation::Kind::PresetList)
+                return;
+        }
+        queueOperation(PendingOperation::Kind::PresetList, false);
+        scheduleQueuePump();
+    }
+
+    void runPresetListFetch(const OperationContext &ctx)
+    {
+        if (m_presetListEpoch == m_linkEpoch)
+            return;
+        ControlSession *session = acquireSession(1500, QByteArrayLiteral("preset-list"), ctx);
+        if (!session)
+            return;
+        const bool replied = queryOnSession(*session, QByteArrayLiteral("NRIQSTN"), kPresetListTimeoutMs, ctx);
+        releaseSession();
+        if (ctx.isCancelled())
+            return;
+        m_presetListEpoch = m_linkEpoch;
+        timingLog(QStringLiteral("tuner.presets replied=%1 count=%2")
+                      .arg(replied ? 1 : 0)
+                      .arg(static_cast<int>(m_tunerPresets.size())));
+    }
+
+    void handleReceiverInfo(const QByteArray &xmlText)
+    {
+        std::vector<TunerPreset> presets;
+        QByteArray mac;
+        QXmlStreamReader xml(xmlText);
+        while (!xml.atEnd()) {
+            if (xml.readNext() != QXmlStreamReader::StartElement)
+                continue;
+            if (xml.name() == QLatin1String("macaddress")) {
+                mac = onkyo::parseMacAddress(xml.readElementText());
+                continue;
             }
-            if (sendIscpCommand(*muted ? QByteArrayLiteral("AMT01") : QByteArrayLiteral("AMT00"), false, 0)) {
-                resp.status = v1::CmdStatus::Success;
-                resp.finalValue = *muted;
-                emitMuteState(*muted);
+            if (xml.name() != QLatin1String("preset"))
+                continue;
+            const QXmlStreamAttributes attributes = xml.attributes();
+            TunerPreset preset;
+            preset.code = attributes.value(QLatin1String("id")).toString().trimmed().toUpper();
+            preset.band = attributes.value(QLatin1String("band")).toInt();
+            preset.frequency = attributes.value(QLatin1String("freq")).toString().trimmed();
+            preset.name = attributes.value(QLatin1String("name")).toString().trimmed();
+            // Band 0 marks an empty slot.
+            if (preset.band != 0 && !preset.code.isEmpty())
+                presets.push_back(std::move(preset));
+        }
+        learnMacAddress(mac, QStringLiteral("nri"));
+        if (xml.hasError() && presets.empty())
+            return;
+        m_tunerPresets = std::move(presets);
+        // New choices for the preset channel.
+        if (!m_ipcDown) {
+            m_synced = false;
+            emitDeviceSnapshot();
+        }
+    }
+
+    static std::pair<int, int> levelRange(ChannelId channel)
+    {
+        switch (channel) {
+        case ChannelId::CenterLevel:
+            return {-12, 12};
+        case ChannelId::SubwooferLevel:
+            return {-15, 12};
+        default:
+            return {-10, 10};
+        }
+    }
+
+    static int clampedLevel(ChannelId channel, double level)
+    {
+        const auto [minLevel, maxLevel] = levelRange(channel);
+        return qBound(minLevel, static_cast<int>(qRound(level)), maxLevel);
+    }
+
+    // Queued setters share one session and one pipelined write. Each command completes as soon as its echo
+    // is back, so a burst costs a single round trip instead of one exchange per command.
+    void runWriteBatch(WriteBatch &batch, const OperationContext &ctx)
+    {
+        constexpr int kBatchConnectTimeoutMs = 1500;
+        constexpr int kBatchConnectAttempts = 2;
+
+        std::array<v1::CmdResponse, kChannelIdCount> responses;
+        std::array<QByteArray, kChannelIdCount> commands;
+        std::size_t open = 0;
+        for (std::size_t i = 0; i < batch.size; ++i) {
+            responses[i].id = batch.writes[i].cmdId;
+            responses[i].tsMs = nowMs();
+            if (std::optional<QByteArray> command = setterCommand(batch.writes[i], &responses[i])) {
+                commands[i] = std::move(*command);
+                ++open;
             } else {
-                resp.status = unavailableCommandStatus();
-                resp.error = unavailableCommandMessage();
+                submitCmdResult(std::move(responses[i]), "channel.invoke.batch");
+            }
+        }
+        auto finish = [&](std::size_t i, bool delivered) {
+            if (delivered) {
+                completeSetter(batch.writes[i], &responses[i]);
+            } else {
+                responses[i].status = unavailableCommandStatus();
+                responses[i].error = unavailableCommandMessage();
+            }
+            responses[i].tsMs = nowMs();
+            submitCmdResult(std::move(responses[i]), "channel.invoke.batch");
+            commands[i].clear();
+            --open;
+        };
+        timingLog(QStringLiteral("batch.start writes=%1 valid=%2").arg(static_cast<int>(batch.size)).arg(open));
+
+        bool hadConnectedSession = false;
+        bool lostSession = false;
+        for (int attempt = 0; attempt < kBatchConnectAttempts && open > 0; ++attempt) {
+            if (ctx.isCancelled() || ctx.expired())
+                break;
+            bool reused = false;
+            ControlSession *session = acquireSession(kBatchConnectTimeoutMs, QByteArrayLiteral("batch"), ctx, &reused);
+            if (!session)
+                continue;
+            if (!reused) {
+                hadConnectedSession = true;
+                markConnectSuccess();
+            }
+
+            QList<QByteArray> frames;
+            for (std::size_t i = 0; i < batch.size; ++i) {
+                if (!commands[i].isEmpty())
+                    frames.push_back(commands[i]);
+            }
+            WaitStatus status = WaitStatus::Closed;
+            if (writeIscpCommands(*session, frames)) {
+                status = waitForSocket(
+                    session->socket,
+                    [&]() {
+                        readIscpSession(*session);
+                        for (std::size_t i = 0; i < batch.size; ++i) {
+                            if (!commands[i].isEmpty() && session->seenCommands.contains(commands[i].left(3)))
+                                finish(i, true);
+                        }
+                        return open == 0;
+                    },
+                    ctx.stepDeadline(kSessionEchoTimeoutMs),
+                    ctx.token);
+            }
+            if (ctx.isCancelled()) {
+                releaseSession();
+                break;
+            }
+            // A dead or silent kept-open session: replay what is left on a fresh connection.
+            if (open > 0 && (status == WaitStatus::Closed || (reused && session->seenCommands.isEmpty()))) {
+                timingLog(QStringLiteral("batch.session.stale host=%1 open=%2").arg(session->host).arg(open));
+                dropSession();
+                lostSession = lostSession || reused;
+                continue;
+            }
+            if (reused)
+                markConnectSuccess();
+            // Setters without an echo were still delivered; report them like single writes do.
+            for (std::size_t i = 0; i < batch.size; ++i) {
+                if (!commands[i].isEmpty())
+                    finish(i, true);
+            }
+            releaseSession();
+        }
+
+        if (open > 0) {
+            if (!hadConnectedSession && !ctx.isCancelled()) {
+                if (lostSession)
+                    markLinkLost();
+                else
+                    markConnectFailure();
+            }
+            for (std::size_t i = 0; i < batch.size; ++i) {
+                if (!commands[i].isEmpty())
+                    finish(i, false);
             }
-            return resp;
         }
+        resetPollTimerCountdown();
+        QTimer::singleShot(1000, m_dispatchContext.get(), [this]() {
+            if (m_started && !m_stopping)
+                enqueuePollOperation(true);
+        });
+    }
 
-        if (request.channelExternalId == kChannelInput) {
-            QString input = scalarToQString(request.value).trimmed();
+    GroupMemberResult runGroupCommand(const GroupCommand &command, const OperationContext &ctx)
+    {
+        GroupMemberResult result;
+        result.externalId = m_externalId;
+        if (nowMs() >= command.deadlineMs) {
+            result.status = v1::CmdStatus::TemporarilyOffline;
+            result.error = "Group deadline exceeded";
+            return result;
+        }
 
-            const QString labelMatch = input.toLower();
-            for (auto it = m_inputLabelMap.constBegin(); it != m_inputLabelMap.constEnd(); ++it) {
-                if (it.value().toLower() == labelMatch) {
-                    input = it.key();
-                    break;
-                }
-            }
-            input = normalizeSliCode(input);
+        ChannelWrite request;
+        request.channel = channelIdFromName(command.channelId);
+        request.value = command.value;
+        m_lastWriteMs = 0;
+        v1::CmdResponse response = handleChannelInvoke(request, ctx);
+        result.status = response.status;
+        result.error = response.error;
+        result.finalValue = response.finalValue;
+        result.writeMs = m_lastWriteMs;
+        return result;
+    }
 
-            if (input.length() != 2) {
-                resp.status = v1::CmdStatus::InvalidArgument;
-                resp.error = "Input expects 2-digit code (e.g. 01)";
-                return resp;
-            }
+    QByteArray volumeCommand(double percent) const
+    {
+        const double clampedPercent = qBound(0.0, percent, 100.0);
+        const int rawValue = qBound(0,
+            static_cast<int>(qRound((clampedPercent / 100.0) * m_volumeMaxRaw)),
+            m_volumeMaxRaw);
+        return QByteArrayLiteral("MVL") + QByteArray::number(rawValue, 16).rightJustified(2, '0').toUpper();
+    }
 
-            if (sendIscpCommand(QByteArrayLiteral("SLI") + input.toLatin1(), false, 0)) {
-                resp.status = v1::CmdStatus::Success;
-                resp.finalValue = input.toStdString();
-                m_lastInputCode = input;
-                emitInputState(input);
-            } else {
-                resp.status = unavailableCommandStatus();
-                resp.error = unavailableCommandMessage();
+    QString resolveInputCode(const QString &raw) const
+    {
+        QString input = raw.trimmed();
+        const QString labelMatch = input.toLower();
+        for (auto it = m_inputLabelMap.constBegin(); it != m_inputLabelMap.constEnd(); ++it) {
+            if (it.value().toLower() == labelMatch) {
+                input = it.key();
+                break;
             }
-            return resp;
         }
+        return normalizeSliCode(input);
+    }
 
-        resp.status = v1::CmdStatus::NotSupported;
-        resp.error = "Channel not supported";
+    // Delta resync: core passes the epoch and sequence number it last acknowledged and gets every channel
+    // journaled after it re-emitted, plus the new head to acknowledge next time. An unknown epoch means
+    // everything is sent.
+    v1::ActionResponse handleResync(const sdk::AdapterActionInvokeRequest &request)
+    {
+        const QJsonObject params = parseJsonObject(request.paramsJson);
+        const bool sameEpoch = params.value(QStringLiteral("epoch")).toVariant().toLongLong() == m_stateEpoch;
+        std::uint64_t sinceSeq = sameEpoch ? params.value(QStringLiteral("sinceSeq")).toVariant().toULongLong() : 0;
+        if (sinceSeq > m_stateSeq)
+            sinceSeq = 0;
+        m_resyncNegotiated = true;
+        m_ackedSeq = sinceSeq;
+
+        if (!m_synced)
+            emitDeviceSnapshot();
+        QJsonArray sent;
+        for (std::size_t i = 0; i < kChannelIdCount; ++i) {
+            if (m_stateJournal[i].seq <= sinceSeq)
+                continue;
+            const ChannelId id = static_cast<ChannelId>(i);
+            emitChannelState(id, m_stateJournal[i].value);
+            sent.append(channelQName(id));
+        }
+        timingLog(QStringLiteral("resync sinceSeq=%1 headSeq=%2 sent=%3")
+                      .arg(sinceSeq)
+                      .arg(m_stateSeq)
+                      .arg(sent.size()));
+
+        v1::ActionResponse resp;
+        resp.id = request.cmdId;
+        resp.tsMs = nowMs();
+        resp.status = v1::CmdStatus::Success;
+        resp.resultType = v1::ActionResultType::String;
+        resp.resultValue = toJson(QJsonObject{
+            {QStringLiteral("epoch"), static_cast<double>(m_stateEpoch)},
+            {QStringLiteral("headSeq"), static_cast<double>(m_stateSeq)},
+            {QStringLiteral("full"), sinceSeq == 0},
+            {QStringLiteral("channels"), sent},
+        });
         return resp;
     }
 
@@ -1198,7 +4869,10 @@ private:
         }
 
         if (request.actionId == "probeCurrentInput")
-            return handleProbeCurrentInput(request, false);
+            return handleProbeCurrentInput(request, false, OperationContext::withTimeout(kCommandDeadlineMs));
+
+        if (request.actionId == "resync")
+            return handleResync(request);
 
         resp.status = v1::CmdStatus::NotSupported;
         resp.error = "Adapter action not supported";
@@ -1206,7 +4880,8 @@ private:
     }
 
     v1::ActionResponse handleProbeCurrentInput(const sdk::AdapterActionInvokeRequest &request,
-                                               bool fromRunningPoll)
+                                               bool fromRunningPoll,
+                                               const OperationContext &ctx)
     {
         v1::ActionResponse resp;
         resp.id = request.cmdId;
@@ -1233,6 +4908,7 @@ private:
         } else if (!sendIscpCommand(QByteArrayLiteral("SLIQSTN"),
                                     true,
                                     700,
+                                    ctx,
                                     900,
                                     2)) {
             resp.status = unavailableCommandStatus();
@@ -1326,26 +5002,443 @@ private:
         return resp;
     }
 
-    v1::CmdResponse handleDeviceEffectInvoke(const sdk::DeviceEffectInvokeRequest &request)
+    std::optional<v1::CmdResponse> handleDeviceEffectInvoke(const sdk::DeviceEffectInvokeRequest &request)
     {
         v1::CmdResponse resp;
         resp.id = request.cmdId;
-        resp.status = v1::CmdStatus::NotImplemented;
-        resp.error = "Device effect not supported";
         resp.tsMs = nowMs();
-        return resp;
+
+        if (request.deviceExternalId != m_deviceId) {
+            resp.status = v1::CmdStatus::NotSupported;
+            resp.error = "Unknown device";
+            return resp;
+        }
+
+        const QJsonObject params = parseJsonObject(request.paramsJson);
+        const QString effectName = params.value(QStringLiteral("effect")).toString().trimmed().toLower();
+        VolumeEffect effect;
+        effect.cmdId = request.cmdId;
+        if (effectName == QLatin1String("ramp") || effectName == QLatin1String("fade")) {
+            effect.type = VolumeEffect::Type::Ramp;
+        } else if (effectName == QLatin1String("fadein")) {
+            effect.type = VolumeEffect::Type::FadeIn;
+        } else if (effectName == QLatin1String("fadeout")) {
+            effect.type = VolumeEffect::Type::FadeOut;
+        } else if (effectName == QLatin1String("duck")) {
+            effect.type = VolumeEffect::Type::Duck;
+        } else {
+            resp.status = v1::CmdStatus::NotSupported;
+            resp.error = "Device effect not supported";
+            return resp;
+        }
+
+        const QJsonValue target = params.value(effect.type == VolumeEffect::Type::Duck
+                                                   ? QStringLiteral("level")
+                                                   : QStringLiteral("target"));
+        if (target.isDouble()) {
+            effect.targetPercent = qBound(0.0, target.toDouble(), 100.0);
+        } else if (effect.type == VolumeEffect::Type::FadeOut) {
+            effect.targetPercent = 0.0;
+        } else {
+            resp.status = v1::CmdStatus::InvalidArgument;
+            resp.error = "Effect target volume must be numeric";
+            return resp;
+        }
+        effect.durationMs = qBound(0, params.value(QStringLiteral("durationMs")).toInt(1000), 3600000);
+        effect.holdMs = qBound(0, params.value(QStringLiteral("holdMs")).toInt(5000), 3600000);
+        effect.restoreMs = qBound(0, params.value(QStringLiteral("restoreMs")).toInt(effect.durationMs), 3600000);
+
+        cancelDeviceEffect("Superseded by new effect");
+        m_effect = std::move(effect);
+        timingLog(QStringLiteral("effect.accept cmdId=%1 effect=%2 target=%3 durationMs=%4")
+                      .arg(request.cmdId)
+                      .arg(effectName)
+                      .arg(m_effect->targetPercent)
+                      .arg(m_effect->durationMs));
+        enqueueEffectStep();
+        return std::nullopt;
+    }
+
+    // The effect may be cancelled while the effect step waits; callers look it up again after each wait.
+    VolumeEffect *runningEffect(CmdId cmdId)
+    {
+        return (m_effect.has_value() && m_effect->cmdId == cmdId) ? &*m_effect : nullptr;
+    }
+
+    bool beginDeviceEffect(CmdId cmdId,
+                           v1::CmdStatus *status,
+                           v1::Utf8String *error,
+                           const OperationContext &ctx)
+    {
+        if (m_powerState == PowerState::Unknown || !m_lastReportedVolume.has_value())
+            requestInitialState(ctx);
+        VolumeEffect *running = runningEffect(cmdId);
+        if (!running)
+            return false;
+        VolumeEffect &effect = *running;
+        if (m_powerState == PowerState::Off) {
+            *status = v1::CmdStatus::Failure;
+            *error = "Standby";
+            return false;
+        }
+        if (m_powerState != PowerState::On || !m_lastReportedVolume.has_value()) {
+            *status = unavailableCommandStatus();
+            *error = unavailableCommandMessage();
+            return false;
+        }
+
+        const double current = static_cast<double>(*m_lastReportedVolume);
+        switch (effect.type) {
+        case VolumeEffect::Type::Ramp:
+        case VolumeEffect::Type::FadeOut:
+            effect.segments.push_back({current, effect.targetPercent, effect.durationMs});
+            break;
+        case VolumeEffect::Type::FadeIn:
+            effect.segments.push_back({0.0, effect.targetPercent, effect.durationMs});
+            break;
+        case VolumeEffect::Type::Duck:
+            effect.segments.push_back({current, effect.targetPercent, effect.durationMs});
+            effect.segments.push_back({effect.targetPercent, effect.targetPercent, effect.holdMs});
+            effect.segments.push_back({effect.targetPercent, current, effect.restoreMs});
+            break;
+        }
+        effect.started = true;
+        effect.startedMs = nowMs();
+        return true;
+    }
+
+    void runEffectStep(const OperationContext &ctx)
+    {
+        if (!m_effect.has_value())
+            return;
+        // No reference is held across waits: a user write in a nested event loop may end the effect.
+        const CmdId cmdId = m_effect->cmdId;
+
+        if (!m_effect->started) {
+            v1::CmdStatus status = v1::CmdStatus::Success;
+            v1::Utf8String error;
+            if (!beginDeviceEffect(cmdId, &status, &error, ctx)) {
+                if (runningEffect(cmdId))
+                    finishDeviceEffect(status, error);
+                return;
+            }
+        }
+        VolumeEffect *effect = runningEffect(cmdId);
+
+        // Position on the timeline is derived from wall time so slow steps never stretch the effect.
+        std::int64_t offsetMs = nowMs() - effect->startedMs;
+        double percent = effect->segments.back().toPercent;
+        bool done = true;
+        for (const VolumeEffect::Segment &segment : effect->segments) {
+            if (offsetMs < segment.durationMs) {
+                const double progress = static_cast<double>(offsetMs) / segment.durationMs;
+                percent = segment.fromPercent + (segment.toPercent - segment.fromPercent) * progress;
+                done = false;
+                break;
+            }
+            offsetMs -= segment.durationMs;
+        }
+
+        const QByteArray command = volumeCommand(percent);
+        if (command != effect->lastCommand) {
+            const bool sent = sendIscpCommand(command, false, 0, ctx);
+            effect = runningEffect(cmdId);
+            if (!effect)
+                return;
+            if (!sent) {
+                finishDeviceEffect(unavailableCommandStatus(), unavailableCommandMessage());
+                return;
+            }
+            effect->lastCommand = command;
+            emitVolumeState(static_cast<std::int64_t>(qRound(percent)));
+        }
+
+        if (done) {
+            finishDeviceEffect(v1::CmdStatus::Success, {});
+            return;
+        }
+
+        if (!m_effectTimer) {
+            m_effectTimer = std::make_unique<QTimer>();
+            m_effectTimer->setSingleShot(true);
+            m_effectTimer->setTimerType(Qt::PreciseTimer);
+            QObject::connect(m_effectTimer.get(), &QTimer::timeout, [this]() {
+                enqueueEffectStep();
+            });
+        }
+        m_effectTimer->start(kEffectStepMs);
     }
 
-    v1::CmdResponse handleSceneInvoke(const sdk::SceneInvokeRequest &request)
+    void finishDeviceEffect(v1::CmdStatus status, const v1::Utf8String &error)
+    {
+        if (!m_effect.has_value())
+            return;
+        if (m_effectTimer)
+            m_effectTimer->stop();
+
+        v1::CmdResponse response;
+        response.id = m_effect->cmdId;
+        response.tsMs = nowMs();
+        response.status = status;
+        response.error = error;
+        if (status == v1::CmdStatus::Success && m_lastReportedVolume.has_value())
+            response.finalValue = *m_lastReportedVolume;
+        timingLog(QStringLiteral("effect.end cmdId=%1 status=%2 elapsedMs=%3")
+                      .arg(m_effect->cmdId)
+                      .arg(static_cast<int>(status))
+                      .arg(m_effect->started ? nowMs() - m_effect->startedMs : 0));
+        m_effect.reset();
+        submitCmdResult(std::move(response), "device.effect.invoke");
+
+        if (status == v1::CmdStatus::Success) {
+            resetPollTimerCountdown();
+            QTimer::singleShot(1000, m_dispatchContext.get(), [this]() {
+                if (m_started && !m_stopping)
+                    enqueuePollOperation(true);
+            });
+        }
+    }
+
+    void cancelDeviceEffect(const v1::Utf8String &reason)
+    {
+        if (!m_effect.has_value())
+            return;
+        for (auto it = m_operationQueue.begin(); it != m_operationQueue.end();) {
+            if (it->kind == PendingOperation::Kind::EffectStep) {
+                it = recycleOperation(it);
+                continue;
+            }
+            ++it;
+        }
+        m_effectStepQueued = false;
+        // A running step ends at its next wait and finds the effect gone.
+        if (m_effectStepRunning)
+            m_operationToken.cancel();
+        finishDeviceEffect(v1::CmdStatus::Failure, reason);
+    }
+
+    v1::CmdResponse handleSceneInvoke(const sdk::SceneInvokeRequest &request, const OperationContext &ctx)
     {
         v1::CmdResponse resp;
         resp.id = request.cmdId;
-        resp.status = v1::CmdStatus::NotImplemented;
-        resp.error = "Scene invocation not supported";
         resp.tsMs = nowMs();
+
+        SceneTargets targets;
+        QString parseError;
+        if (!parseSceneTargets(parseJsonObject(request.paramsJson), &targets, &parseError)) {
+            resp.status = v1::CmdStatus::InvalidArgument;
+            resp.error = parseError.toStdString();
+            return resp;
+        }
+        if (targets.isEmpty()) {
+            resp.status = v1::CmdStatus::InvalidArgument;
+            resp.error = "Scene has no receiver targets";
+            return resp;
+        }
+
+        v1::CmdStatus status = v1::CmdStatus::Success;
+        v1::Utf8String error;
+        runScene(targets, &status, &error, ctx);
+        resp.status = status;
+        resp.error = error;
+        resp.tsMs = nowMs();
+        if (status == v1::CmdStatus::Success)
+            resp.finalValue = toJson(currentChannelValues());
         return resp;
     }
 
+    bool parseSceneTargets(const QJsonObject &params, SceneTargets *targets, QString *error) const
+    {
+        QJsonObject source = params.value(QStringLiteral("channels")).toObject();
+        if (source.isEmpty())
+            source = params;
+
+        auto valueFor = [&source](const char *channelId) {
+            const QJsonValue value = source.value(QString::fromLatin1(channelId));
+            return (value.isUndefined() || value.isNull()) ? std::optional<v1::ScalarValue>()
+                                                           : std::optional<v1::ScalarValue>(jsonToScalar(value));
+        };
+
+        if (const auto power = valueFor(kChannelPower)) {
+            targets->power = scalarToBool(*power);
+            if (!targets->power.has_value()) {
+                *error = QStringLiteral("Power expects boolean");
+                return false;
+            }
+        }
+        if (const auto volume = valueFor(kChannelVolume)) {
+            targets->volume = scalarToDouble(*volume);
+            if (!targets->volume.has_value()) {
+                *error = QStringLiteral("Volume must be numeric");
+                return false;
+            }
+        }
+        if (const auto mute = valueFor(kChannelMute)) {
+            targets->mute = scalarToBool(*mute);
+            if (!targets->mute.has_value()) {
+                *error = QStringLiteral("Mute expects boolean");
+                return false;
+            }
+        }
+        if (const auto input = valueFor(kChannelInput)) {
+            targets->input = resolveInputCode(scalarToQString(*input));
+            if (targets->input.length() != 2) {
+                *error = QStringLiteral("Input expects 2-digit code (e.g. 01)");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool runScene(const SceneTargets &targets,
+                  v1::CmdStatus *status,
+                  v1::Utf8String *error,
+                  const OperationContext &ctx)
+    {
+        constexpr int kSceneConnectTimeoutMs = 1500;
+        constexpr int kSceneConnectAttempts = 2;
+
+        QElapsedTimer timer;
+        timer.start();
+        ControlSession *session = nullptr;
+        bool reused = false;
+        for (int attempt = 0; attempt < kSceneConnectAttempts && !session && !ctx.isCancelled(); ++attempt)
+            session = acquireSession(kSceneConnectTimeoutMs, QByteArrayLiteral("scene"), ctx, &reused);
+        if (!session) {
+            if (!ctx.isCancelled())
+                markConnectFailure();
+            *status = unavailableCommandStatus();
+            *error = unavailableCommandMessage();
+            return false;
+        }
+
+        if (!reused)
+            markConnectSuccess();
+        bool ok = runSceneOnSession(*session, targets, status, error, ctx);
+        // Not a single frame came back on a kept-open session: it may have died silently, so replay on a fresh one.
+        if (reused && !ctx.isCancelled() && session->seenCommands.isEmpty()) {
+            timingLog(QStringLiteral("scene.session.stale host=%1").arg(session->host));
+            dropSession();
+            session = acquireSession(kSceneConnectTimeoutMs, QByteArrayLiteral("scene"), ctx);
+            if (!session) {
+                if (!ctx.isCancelled())
+                    markLinkLost();
+                *status = unavailableCommandStatus();
+                *error = unavailableCommandMessage();
+                return false;
+            }
+            markConnectSuccess();
+            ok = runSceneOnSession(*session, targets, status, error, ctx);
+        } else if (reused && !session->seenCommands.isEmpty()) {
+            markConnectSuccess();
+        }
+        releaseSession();
+        timingLog(QStringLiteral("scene.done status=%1 elapsedMs=%2")
+                      .arg(ok ? QStringLiteral("success") : QStringLiteral("failure"))
+                      .arg(timer.elapsed()));
+        return ok;
+    }
+
+    bool runSceneOnSession(ControlSession &session,
+                           const SceneTargets &targets,
+                           v1::CmdStatus *status,
+                           v1::Utf8String *error,
+                           const OperationContext &ctx)
+    {
+        auto failWrite = [&]() {
+            *status = unavailableCommandStatus();
+            *error = unavailableCommandMessage();
+            return false;
+        };
+
+        // Standby rejects every other setter, so a power-off scene is a single write.
+        if (targets.power.has_value() && !*targets.power) {
+            if (!writeIscpCommands(session, {QByteArrayLiteral("PWR00")}))
+                return failWrite();
+            QSet<QByteArray> pending{QByteArrayLiteral("PWR")};
+            awaitIscpReplies(session, pending, kSceneAckTimeoutMs, ctx);
+            emitPowerState(false);
+            return true;
+        }
+
+        if (targets.power.value_or(false) && m_powerState != PowerState::On) {
+            const PowerState before = m_powerState;
+            if (!writeIscpCommands(session, {QByteArrayLiteral("PWR01")}))
+                return failWrite();
+            QSet<QByteArray> pending{QByteArrayLiteral("PWR")};
+            if (!awaitIscpReplies(session, pending, kPowerOnAckTimeoutMs, ctx) || m_powerState != PowerState::On) {
+                *status = v1::CmdStatus::TemporarilyOffline;
+                *error = "Receiver did not power on";
+                return false;
+            }
+            // Receivers ignore most setters for a moment after leaving standby.
+            if (before != PowerState::On)
+                settleIscpSession(session, kPowerOnSettleMs, ctx);
+        } else if (m_powerState == PowerState::Unknown) {
+            if (!writeIscpCommands(session, {QByteArrayLiteral("PWRQSTN")}))
+                return failWrite();
+            QSet<QByteArray> pending{QByteArrayLiteral("PWR")};
+            awaitIscpReplies(session, pending, kPollQueryTimeoutMs, ctx);
+        }
+
+        QList<QByteArray> commands;
+        QSet<QByteArray> pending;
+        if (targets.volume.has_value()) {
+            commands.push_back(volumeCommand(*targets.volume));
+            pending.insert(QByteArrayLiteral("MVL"));
+        }
+        if (targets.mute.has_value()) {
+            commands.push_back(*targets.mute ? QByteArrayLiteral("AMT01") : QByteArrayLiteral("AMT00"));
+            pending.insert(QByteArrayLiteral("AMT"));
+        }
+        if (!targets.input.isEmpty()) {
+            commands.push_back(QByteArrayLiteral("SLI") + targets.input.toLatin1());
+            pending.insert(QByteArrayLiteral("SLI"));
+        }
+        if (commands.isEmpty())
+            return true;
+
+        if (m_powerState == PowerState::Off) {
+            *status = v1::CmdStatus::Failure;
+            *error = "Standby";
+            return false;
+        }
+        if (m_powerState != PowerState::On) {
+            *status = v1::CmdStatus::TemporarilyOffline;
+            *error = "Power state unknown";
+            return false;
+        }
+
+        if (!writeIscpCommands(session, commands))
+            return failWrite();
+        awaitIscpReplies(session, pending, kSceneAckTimeoutMs, ctx);
+
+        // Setters without an echo were still delivered; report them like single writes do.
+        if (targets.volume.has_value() && pending.contains(QByteArrayLiteral("MVL")))
+            emitVolumeState(static_cast<std::int64_t>(qRound(qBound(0.0, *targets.volume, 100.0))));
+        if (targets.mute.has_value() && pending.contains(QByteArrayLiteral("AMT")))
+            emitMuteState(*targets.mute);
+        if (!targets.input.isEmpty() && pending.contains(QByteArrayLiteral("SLI"))) {
+            m_lastInputCode = targets.input;
+            emitInputState(targets.input);
+        }
+        return true;
+    }
+
+    QJsonObject currentChannelValues() const
+    {
+        QJsonObject values;
+        if (m_powerState != PowerState::Unknown)
+            values.insert(QString::fromLatin1(kChannelPower), m_powerState == PowerState::On);
+        if (m_lastReportedVolume.has_value())
+            values.insert(QString::fromLatin1(kChannelVolume), static_cast<double>(*m_lastReportedVolume));
+        if (m_lastReportedMute.has_value())
+            values.insert(QString::fromLatin1(kChannelMute), *m_lastReportedMute);
+        if (m_hasLastReportedInput)
+            values.insert(QString::fromLatin1(kChannelInput), m_lastReportedInput);
+        return values;
+    }
+
 private:
     void startPollingTimer()
     {
@@ -1403,6 +5496,10 @@ private:
         const std::uint16_t discoveredPort = normalizedPort(static_cast<int>(m_info.port));
         const std::uint16_t effectivePort = configuredIscpPort > 0 ? configuredIscpPort : discoveredPort;
         m_controlPort = resolvedControlPort(effectivePort);
+        m_transport = parseTransportConfig(m_meta);
+        if (!hasUsableBaudRate())
+            std::cerr << "onkyo-ipc config externalId=" << m_externalId << ": baudRate " << m_transport.baudRate
+                      << " is not supported (9600, 19200, 38400, 57600, 115200); serial transport stays closed\n";
         m_pollIntervalMs = qBound(500,
                                   m_meta.value(QStringLiteral("pollIntervalMs")).toInt(5000),
                                   300000);
@@ -1412,42 +5509,299 @@ private:
         m_volumeMaxRaw = qBound(1,
                                 m_meta.value(QStringLiteral("volumeMaxRaw")).toInt(160),
                                 500);
+        const int heartbeatIntervalMs = m_meta.value(QStringLiteral("heartbeatIntervalMs")).toInt(0);
+        m_heartbeatIntervalMs = heartbeatIntervalMs > 0 ? qBound(1000, heartbeatIntervalMs, 300000) : 0;
+        m_ipcGraceMs = qBound(0, m_meta.value(QStringLiteral("ipcGraceMs")).toInt(30000), 600000);
+        m_extendedIdleMs = qBound(10000, m_meta.value(QStringLiteral("extendedChannelIdleMs")).toInt(600000), 86400000);
+        const int sessionIdleTimeoutMs = m_meta.value(QStringLiteral("sessionIdleTimeoutMs")).toInt(60000);
+        m_sessionIdleTimeoutMs = sessionIdleTimeoutMs > 0 ? qBound(1000, sessionIdleTimeoutMs, 3600000) : 0;
+        m_keepAlive.idleSec = qBound(1, m_meta.value(QStringLiteral("tcpKeepAliveIdleS")).toInt(10), 7200);
+        m_keepAlive.intervalSec = qBound(1, m_meta.value(QStringLiteral("tcpKeepAliveIntervalS")).toInt(2), 600);
+        m_keepAlive.probeCount = qBound(1, m_meta.value(QStringLiteral("tcpKeepAliveCount")).toInt(3), 20);
+        m_keepAlive.userTimeoutMs = qBound(1000, m_meta.value(QStringLiteral("tcpUserTimeoutMs")).toInt(5000), 600000);
+        m_wakeOnLan = m_meta.value(QStringLiteral("wakeOnLan")).toBool(false);
+        m_macAddress = onkyo::parseMacAddress(m_meta.value(QStringLiteral("macAddress")).toString());
+        m_wolTarget = onkyo::wakeOnLanTarget(m_meta.value(QStringLiteral("wolBroadcast")).toString());
+        m_wolPort = normalizedPort(m_meta.value(QStringLiteral("wolPort")).toInt(kWakeDefaultPort));
+        if (m_wolPort == 0)
+            m_wolPort = kWakeDefaultPort;
+        m_wakeTimeoutMs = qBound(2000, m_meta.value(QStringLiteral("wakeTimeoutMs")).toInt(kWakeDefaultTimeoutMs), 120000);
         reloadInputLabelMap();
         updatePollInterval();
+        // Starts the lookup early so the first poll finds the addresses cached.
+        effectiveHosts();
+    }
+
+    static TransportConfig parseTransportConfig(const QJsonObject &meta)
+    {
+        TransportConfig transport;
+        const QString kind = meta.value(QStringLiteral("transport")).toString().trimmed().toLower();
+        if (kind == QLatin1String("serial"))
+            transport.kind = TransportKind::Serial;
+        else if (kind == QLatin1String("unix"))
+            transport.kind = TransportKind::UnixSocket;
+        transport.path = meta.value(QStringLiteral("devicePath")).toString().trimmed();
+        const QJsonValue baudRate = meta.value(QStringLiteral("baudRate"));
+        transport.baudRate = baudRate.isString() ? baudRate.toString().trimmed().toInt() : baudRate.toInt(9600);
+        const QString framing = meta.value(QStringLiteral("framing")).toString().trimmed().toLower();
+        if (framing == QLatin1String("eiscp"))
+            transport.framing = EiscpFraming{};
+        else if (framing == QLatin1String("crlf"))
+            transport.framing = RawIscpFraming<true>{};
+        else if (framing == QLatin1String("cr") || transport.kind != TransportKind::Tcp)
+            transport.framing = RawIscpFraming<false>{};
+        return transport;
+    }
+
+    bool isTcpTransport() const { return m_transport.kind == TransportKind::Tcp; }
+
+    bool hasUsableBaudRate() const
+    {
+#ifdef Q_OS_LINUX
+        return m_transport.kind != TransportKind::Serial || onkyo::termiosSpeed(m_transport.baudRate).has_value();
+#else
+        return true;
+#endif
+    }
+
+    // Identifies the configured receiver link; a kept session must still match it.
+    QString transportEndpoint() const
+    {
+        if (isTcpTransport())
+            return configuredHost();
+        return QStringLiteral("%1:%2")
+            .arg(m_transport.kind == TransportKind::Serial ? QStringLiteral("serial") : QStringLiteral("unix"),
+                 m_transport.path);
+    }
+
+    bool hasControlEndpoint() const
+    {
+        if (!isTcpTransport())
+            return !m_transport.path.isEmpty() && hasUsableBaudRate();
+        return !effectiveHosts().isEmpty() && m_controlPort != 0;
+    }
+
+    QString configuredHost() const
+    {
+        const QString ip = QString::fromStdString(m_info.ip).trimmed();
+        if (!ip.isEmpty())
+            return ip;
+        return m_meta.value(QStringLiteral("host")).toString().trimmed();
+    }
+
+    // Literal addresses are used as-is; hostnames come from the shared resolver cache and never block.
+    QStringList effectiveHosts() const
+    {
+        const QString host = configuredHost();
+        if (host.isEmpty())
+            return {};
+        QHostAddress addr;
+        if (addr.setAddress(host))
+            return {host};
+        return HostResolver::instance().addresses(host);
+    }
+
+    void onHostAddressesChanged(const QString &host)
+    {
+        if (!m_started || m_stopping || host.compare(configuredHost(), Qt::CaseInsensitive) != 0)
+            return;
+        const QStringList addresses = effectiveHosts();
+        timingLog(QStringLiteral("dns.changed host=%1 addresses=%2").arg(host, addresses.join(QLatin1Char(','))));
+        // Follow a DHCP move right away instead of waiting for the old address to time out.
+        if (m_session && m_sessionEstablished && !addresses.contains(m_session->host) && !m_operationRunning)
+            dropSession();
+        enqueuePollOperation(true);
+    }
+
+    void updatePollInterval()
+    {
+        if (!m_pollTimer)
+            return;
+        const int interval = m_connected ? m_pollIntervalMs : m_retryIntervalMs;
+        if (m_pollTimer->interval() != interval)
+            m_pollTimer->setInterval(interval);
+    }
+
+    void logConnectFailure(const QString &error, const QString &host)
+    {
+        const std::int64_t now = nowMs();
+        const QString msg = QStringLiteral("%1|%2").arg(error, host);
+        if (msg == m_lastConnectError && (now - m_lastConnectLogMs) < m_retryIntervalMs)
+            return;
+        m_lastConnectError = msg;
+        m_lastConnectLogMs = now;
+        std::cerr << "Onkyo connect failed: " << error.toStdString()
+                  << " host=" << host.toStdString()
+                  << " port=" << m_controlPort << '\n';
+    }
+
+    // Only a receiver that cannot be reached is woken; one in network standby takes PWR01 directly.
+    bool wakeOnLanArmed() const
+    {
+        return m_wakeOnLan && !m_macAddress.isEmpty() && isTcpTransport() && !m_connected;
+    }
+
+    // Sends the magic packet, then probes the control port with a growing backoff until the receiver accepts
+    // a connection. Returns with the session open, so PWR01 and the queued writes follow without delay.
+    bool wakeReceiver(const OperationContext &ctx)
+    {
+        const onkyo::WakeResult wake = onkyo::runWakeSequence(
+            ctx, onkyo::WakeTiming{kWakeResendIntervalMs, kWakeBackoffInitialMs, kWakeBackoffMaxMs},
+            [this]() { sendWakePacket(); },
+            [this, &ctx]() { return acquireSession(kWakeConnectTimeoutMs, QByteArrayLiteral("wake"), ctx); });
+        if (wake.ready) {
+            markConnectSuccess();
+            recordWakeToReady(wake.elapsedMs, wake.attempts);
+            return true;
+        }
+        timingLog(QStringLiteral("wol.fail elapsedMs=%1 attempts=%2 reason=%3")
+                      .arg(wake.elapsedMs)
+                      .arg(wake.attempts)
+                      .arg(ctx.isCancelled() ? QStringLiteral("cancelled") : QStringLiteral("timeout")));
+        return false;
+    }
+
+    void sendWakePacket()
+    {
+        const bool sent = onkyo::sendWakeOnLan(m_macAddress, m_wolTarget, m_wolPort);
+        timingLog(QStringLiteral("wol.send mac=%1 target=%2:%3 ok=%4")
+                      .arg(onkyo::formatMacAddress(m_macAddress), m_wolTarget.toString())
+                      .arg(m_wolPort)
+                      .arg(sent ? 1 : 0));
+    }
+
+    void recordWakeToReady(std::int64_t elapsedMs, int attempts)
+    {
+        ++m_wakeStats.count;
+        m_wakeStats.lastMs = elapsedMs;
+        m_wakeStats.totalMs += elapsedMs;
+        m_wakeStats.maxMs = std::max(m_wakeStats.maxMs, elapsedMs);
+        timingLog(QStringLiteral("wol.ready elapsedMs=%1 attempts=%2 count=%3 avgMs=%4 maxMs=%5")
+                      .arg(elapsedMs)
+                      .arg(attempts)
+                      .arg(m_wakeStats.count)
+                      .arg(m_wakeStats.totalMs / m_wakeStats.count)
+                      .arg(m_wakeStats.maxMs));
+        updateLinkQuality();
+    }
+
+    // Discovery reply fields: <model>/<port>/<region>/<mac>.
+    void learnMacFromDiscovery(const QByteArray &fields)
+    {
+        const QList<QByteArray> parts = fields.split('/');
+        if (parts.size() >= 4)
+            learnMacAddress(onkyo::parseMacAddress(QString::fromLatin1(parts.at(3).left(12))), QStringLiteral("ecn"));
+    }
+
+    // A MAC reported by the receiver replaces the configured one and is kept for the next start.
+    void learnMacAddress(const QByteArray &mac, const QString &source)
+    {
+        if (mac.isEmpty() || mac == m_macAddress)
+            return;
+        m_macAddress = mac;
+        const QString text = onkyo::formatMacAddress(mac);
+        timingLog(QStringLiteral("wol.mac source=%1 mac=%2").arg(source, text));
+        persistMetaPatch(QJsonObject{{QStringLiteral("macAddress"), text}});
+    }
+
+    void persistMetaPatch(const QJsonObject &patch)
+    {
+        for (auto it = patch.begin(); it != patch.end(); ++it)
+            m_meta.insert(it.key(), it.value());
+        m_info.metaJson = toJson(m_meta);
+        v1::Utf8String err;
+        if (!sendAdapterMetaUpdated(toJson(patch), &err))
+            std::cerr << "failed to send adapterMetaUpdated: " << err << '\n';
     }
 
-    QStringList effectiveHosts() const
+    // Disconnected retries send a unicast ECNQSTN instead of a TCP connect plus four queries. The full poll
+    // runs once a reply came back, and every kLivenessTcpFallbackMs anyway for receivers or paths dropping UDP.
+    bool probeLivenessInstead()
     {
-        QStringList result;
-        const QString ip = QString::fromStdString(m_info.ip).trimmed();
-        if (!ip.isEmpty()) {
-            QHostAddress addr;
-            if (addr.setAddress(ip))
-                result.push_back(ip);
+        if (m_connected || !isTcpTransport() || m_consecutiveConnectFailures < kConnectFailuresBeforeDisconnect)
+            return false;
+        const std::int64_t now = nowMs();
+        const bool replyDue = livenessReplyTcpDue(now);
+        if (replyDue || now - m_livenessTcpMs >= kLivenessTcpFallbackMs) {
+            // Still disconnected at the next reply means this attempt failed: wait twice as long for the next.
+            if (replyDue) {
+                m_livenessTcpBackoffMs = m_livenessTcpBackoffMs == 0
+                    ? kLivenessTcpBackoffInitialMs
+                    : std::min(m_livenessTcpBackoffMs * 2, kLivenessTcpFallbackMs);
+            }
+            m_livenessTcpMs = now;
+            return false;
         }
-        return result;
+        return sendLivenessProbe();
     }
 
-    void updatePollInterval()
+    // A receiver that answers ECN but refuses TCP (another client holds the control port, a firmware half up)
+    // would otherwise get a connect per retry; failed reply-triggered attempts back off up to the fallback.
+    bool livenessReplyTcpDue(std::int64_t now) const
     {
-        if (!m_pollTimer)
-            return;
-        const int interval = m_connected ? m_pollIntervalMs : m_retryIntervalMs;
-        if (m_pollTimer->interval() != interval)
-            m_pollTimer->setInterval(interval);
+        return m_livenessReplyMs > m_livenessTcpMs && now - m_livenessTcpMs >= m_livenessTcpBackoffMs;
     }
 
-    void logConnectFailure(const QString &error, const QString &host)
+    bool sendLivenessProbe()
     {
-        const std::int64_t now = nowMs();
-        const QString msg = QStringLiteral("%1|%2").arg(error, host);
-        if (msg == m_lastConnectError && (now - m_lastConnectLogMs) < m_retryIntervalMs)
-            return;
-        m_lastConnectError = msg;
-        m_lastConnectLogMs = now;
-        std::cerr << "Onkyo connect failed: " << error.toStdString()
-                  << " host=" << host.toStdString()
-                  << " port=" << m_controlPort << '\n';
+        if (!m_livenessSocket) {
+            auto socket = std::make_unique<QUdpSocket>();
+            if (!socket->bind(QHostAddress::Any, 0)) {
+                timingLog(QStringLiteral("liveness.bind err=%1").arg(socket->errorString()));
+                return false;
+            }
+            QObject::connect(socket.get(), &QIODevice::readyRead, [this]() { readLivenessReplies(); });
+            m_livenessSocket = std::move(socket);
+        }
+        const QByteArray query = EiscpFraming::encode(QByteArrayLiteral("ECNQSTN"), 'x');
+        const QStringList hosts = effectiveHosts();
+        int sent = 0;
+        for (const QString &host : hosts) {
+            if (m_livenessSocket->writeDatagram(query, QHostAddress(host), m_controlPort) == query.size())
+                ++sent;
+        }
+        trace(QStringLiteral("liveness.probe hosts=%1 sent=%2 sinceTcpMs=%3")
+                  .arg(hosts.size())
+                  .arg(sent)
+                  .arg(nowMs() - m_livenessTcpMs));
+        return sent > 0;
+    }
+
+    void readLivenessReplies()
+    {
+        while (m_livenessSocket && m_livenessSocket->hasPendingDatagrams()) {
+            const QNetworkDatagram datagram = m_livenessSocket->receiveDatagram();
+            if (!isReceiverAddress(datagram.senderAddress()))
+                continue;
+            bool answered = false;
+            EiscpFraming::extract(datagram.data(), [this, &answered](const QByteArray &payload) {
+                const qsizetype at = payload.indexOf("ECN");
+                if (at < 0)
+                    return;
+                answered = true;
+                learnMacFromDiscovery(payload.mid(at + 3).trimmed());
+            });
+            if (!answered)
+                continue;
+            m_livenessReplyMs = nowMs();
+            timingLog(QStringLiteral("liveness.reply host=%1 connected=%2")
+                          .arg(datagram.senderAddress().toString())
+                          .arg(m_connected ? 1 : 0));
+            // Inside the backoff the reply only counts for the next regular retry; a poll now would just
+            // send another probe.
+            if (!m_connected && livenessReplyTcpDue(m_livenessReplyMs))
+                enqueuePollOperation(true);
+        }
+    }
+
+    bool isReceiverAddress(const QHostAddress &address) const
+    {
+        const QStringList hosts = effectiveHosts();
+        for (const QString &host : hosts) {
+            if (QHostAddress(host).isEqual(address, QHostAddress::TolerantConversion))
+                return true;
+        }
+        return false;
     }
 
     void markConnectSuccess()
@@ -1455,9 +5809,16 @@ private:
         const bool wasConnected = m_connected;
         m_consecutiveConnectFailures = 0;
         setConnected(true);
-        if (!wasConnected)
-            emitChannelState(QString::fromLatin1(kChannelConnectivity),
+        if (!wasConnected) {
+            ++m_linkEpoch;
+            m_livenessSocket.reset();
+            m_livenessTcpBackoffMs = 0;
+            emitChannelState(ChannelId::Connectivity,
                              static_cast<std::int64_t>(v1::ConnectivityStatus::Connected));
+            enqueuePresetListOperation();
+            if (hasDeferredWrites())
+                enqueueDeferredFlush();
+        }
     }
 
     void markConnectFailure()
@@ -1469,30 +5830,214 @@ private:
         const bool wasConnected = m_connected;
         setConnected(false);
         if (wasConnected)
-            emitChannelState(QString::fromLatin1(kChannelConnectivity),
+            emitChannelState(ChannelId::Connectivity,
                              static_cast<std::int64_t>(v1::ConnectivityStatus::Disconnected));
         m_powerState = PowerState::Unknown;
+        // Pushes were missed while the link was down; extended channels query again on next use.
+        m_channelLastUseMs.fill(0);
+        invalidateSignalInfo();
+    }
+
+    // An established session died, which is stronger evidence than a failed connect: skip the hysteresis.
+    void markLinkLost()
+    {
+        m_consecutiveConnectFailures = std::max(m_consecutiveConnectFailures, kConnectFailuresBeforeDisconnect - 1);
+        markConnectFailure();
     }
 
     bool hasQueuedPriorityWork() const
     {
         for (const PendingOperation &op : m_operationQueue) {
-            if (op.kind != PendingOperation::Kind::Poll)
-                return true;
+            if (op.kind == PendingOperation::Kind::Poll || op.kind == PendingOperation::Kind::Heartbeat
+                || op.kind == PendingOperation::Kind::PresetList) {
+                continue;
+            }
+            if (op.kind == PendingOperation::Kind::SignalInfo && std::holds_alternative<std::monostate>(op.payload))
+                continue;
+            return true;
         }
         return false;
     }
 
+    void ensureSession()
+    {
+        if (m_session)
+            return;
+        m_session = std::make_unique<ControlSession>();
+        // Frames the receiver pushes between operations update the cached state right away.
+        QObject::connect(&m_session->socket, &QIODevice::readyRead, [this]() {
+            readIscpSession(*m_session);
+            noteSessionActivity();
+        });
+        QObject::connect(&m_session->socket, &QAbstractSocket::stateChanged,
+                         [this](QAbstractSocket::SocketState state) {
+                             if (state == QAbstractSocket::UnconnectedState)
+                                 onSessionDisconnected();
+                         });
+    }
+
+    // Returns the kept-open session, connecting it first when needed. *reused tells whether it was already open.
+    ControlSession *acquireSession(int connectTimeoutMs,
+                                  const QByteArray &context,
+                                  const OperationContext &ctx,
+                                  bool *reused = nullptr)
+    {
+        ensureSession();
+        if (m_sessionEstablished && m_session->socket.state() == QAbstractSocket::ConnectedState) {
+            if (reused)
+                *reused = true;
+            return m_session.get();
+        }
+        if (reused)
+            *reused = false;
+        m_sessionEstablished = false;
+        if (!openControlSocket(*m_session, connectTimeoutMs, context, ctx))
+            return nullptr;
+        m_session->endpoint = transportEndpoint();
+        if (isTcpTransport())
+            applyTcpKeepAlive(m_session->socket, m_keepAlive);
+        m_sessionEstablished = true;
+        noteSessionActivity();
+        if (m_sessionLost) {
+            m_sessionLost = false;
+            noteReconnect();
+        }
+        return m_session.get();
+    }
+
+    // Hands the session back after an operation; it stays open unless sessionIdleTimeoutMs is 0.
+    void releaseSession()
+    {
+        if (!m_session || !m_sessionEstablished)
+            return;
+        if (m_sessionIdleTimeoutMs > 0) {
+            noteSessionActivity();
+            return;
+        }
+        m_sessionEstablished = false;
+        stopSessionTimers();
+        closeControlSocket(*m_session);
+    }
+
+    // Intentional close; does not count as a lost link.
+    void dropSession()
+    {
+        m_sessionEstablished = false;
+        stopSessionTimers();
+        if (!m_session)
+            return;
+        m_session->socket.abort();
+        m_session->rxBuffer.clear();
+        m_session->seenCommands.clear();
+    }
+
+    void onSessionDisconnected()
+    {
+        if (!m_sessionEstablished)
+            return;
+        m_sessionEstablished = false;
+        stopSessionTimers();
+        const QAbstractSocket::SocketError error = m_session->socket.error();
+        timingLog(QStringLiteral("session.lost host=%1 err=%2")
+                      .arg(m_session->host)
+                      .arg(m_session->socket.errorString()));
+        if (error == QAbstractSocket::RemoteHostClosedError) {
+            // An orderly close may just be the receiver trimming idle sessions; let a reconnect decide.
+            enqueuePollOperation(true);
+            return;
+        }
+        m_sessionLost = true;
+        markLinkLost();
+    }
+
+    void noteSessionActivity()
+    {
+        if (!m_sessionEstablished)
+            return;
+        if (m_heartbeatIntervalMs > 0) {
+            if (!m_heartbeatTimer) {
+                m_heartbeatTimer = std::make_unique<QTimer>();
+                m_heartbeatTimer->setSingleShot(true);
+                QObject::connect(m_heartbeatTimer.get(), &QTimer::timeout, [this]() {
+                    enqueueHeartbeatOperation();
+                });
+            }
+            m_heartbeatTimer->start(m_heartbeatIntervalMs);
+        }
+        if (m_sessionIdleTimeoutMs > 0) {
+            if (!m_sessionIdleTimer) {
+                m_sessionIdleTimer = std::make_unique<QTimer>();
+                m_sessionIdleTimer->setSingleShot(true);
+                QObject::connect(m_sessionIdleTimer.get(), &QTimer::timeout, [this]() {
+                    closeIdleSession();
+                });
+            }
+            m_sessionIdleTimer->start(m_sessionIdleTimeoutMs);
+        }
+    }
+
+    void stopSessionTimers()
+    {
+        if (m_heartbeatTimer)
+            m_heartbeatTimer->stop();
+        if (m_sessionIdleTimer)
+            m_sessionIdleTimer->stop();
+    }
+
+    void closeIdleSession()
+    {
+        if (!m_session || !m_sessionEstablished)
+            return;
+        if (m_operationRunning || m_ipcDown) {
+            noteSessionActivity();
+            return;
+        }
+        timingLog(QStringLiteral("session.idle.close host=%1").arg(m_session->host));
+        m_sessionEstablished = false;
+        stopSessionTimers();
+        closeControlSocket(*m_session);
+    }
+
+    void runHeartbeat(const OperationContext &ctx)
+    {
+        if (!m_session || !m_sessionEstablished)
+            return;
+        const std::int64_t startedMs = nowMs();
+        if (queryOnSession(*m_session, QByteArrayLiteral("PWRQSTN"), kHeartbeatTimeoutMs, ctx)) {
+            markConnectSuccess();
+            timingLog(QStringLiteral("session.heartbeat rttMs=%1").arg(nowMs() - startedMs));
+            return;
+        }
+        if (ctx.isCancelled() || !m_sessionEstablished)
+            return;
+        timingLog(QStringLiteral("session.heartbeat.timeout waitedMs=%1").arg(nowMs() - startedMs));
+        dropSession();
+        markLinkLost();
+    }
+
     bool sendIscpCommand(const QByteArray &command,
                          bool parseResponse,
                          int responseTimeoutMs,
+                         const OperationContext &ctx,
                          int connectTimeoutMs = 1500,
                          int maxAttempts = 2)
     {
+        return sendIscpCommands({command}, parseResponse, responseTimeoutMs, ctx, connectTimeoutMs, maxAttempts);
+    }
+
+    // Frames go out pipelined in one write; a reply counts once every command's prefix has come back.
+    bool sendIscpCommands(const QList<QByteArray> &commands,
+                          bool parseResponse,
+                          int responseTimeoutMs,
+                          const OperationContext &ctx,
+                          int connectTimeoutMs = 1500,
+                          int maxAttempts = 2)
+    {
+        const QByteArray command = commands.join('+');
         QElapsedTimer totalTimer;
         totalTimer.start();
         const QStringList hostCandidates = effectiveHosts();
-        if (hostCandidates.isEmpty() || m_controlPort == 0) {
+        if (!hasControlEndpoint()) {
             trace(QStringLiteral("iscp skip cmd=%1 reason=no-host-or-port hostCount=%2 port=%3")
                       .arg(QString::fromLatin1(command))
                       .arg(hostCandidates.size())
@@ -1507,317 +6052,344 @@ private:
                       .arg(maxAttempts)
                       .arg(hostCandidates.size())
                       .arg(m_controlPort));
-        trace(QStringLiteral("iscp start cmd=%1 parseResponse=%2 responseTimeoutMs=%3 hosts=%4 port=%5")
-                  .arg(QString::fromLatin1(command))
-                  .arg(parseResponse ? 1 : 0)
-                  .arg(responseTimeoutMs)
-                  .arg(hostCandidates.join(QLatin1Char(',')))
-                  .arg(m_controlPort));
-
-        auto connectSocket = [&](QTcpSocket &socket, QString &connectedHost) -> bool {
-            for (const QString &host : hostCandidates) {
-                QElapsedTimer connectTimer;
-                connectTimer.start();
-                socket.abort();
-                socket.connectToHost(host, m_controlPort);
-
-                int waitedMs = 0;
-                while (!socket.waitForConnected(100)) {
-                    waitedMs += 100;
-                    if (waitedMs >= connectTimeoutMs) {
-                        timingLog(QStringLiteral("iscp.connect.timeout cmd=%1 host=%2 waitedMs=%3 err=%4")
-                                      .arg(QString::fromLatin1(command))
-                                      .arg(host)
-                                      .arg(waitedMs)
-                                      .arg(socket.errorString()));
-                        if (socket.state() != QAbstractSocket::ConnectedState)
-                            logConnectFailure(socket.errorString(), host);
-                        break;
-                    }
-                }
-                if (socket.state() == QAbstractSocket::ConnectedState) {
-                    connectedHost = host;
-                    timingLog(QStringLiteral("iscp.connect.ok cmd=%1 host=%2 elapsedMs=%3")
-                                  .arg(QString::fromLatin1(command))
-                                  .arg(host)
-                                  .arg(connectTimer.elapsed()));
-                    trace(QStringLiteral("iscp connected cmd=%1 host=%2 port=%3 connectElapsedMs=%4")
-                              .arg(QString::fromLatin1(command))
-                              .arg(host)
-                              .arg(m_controlPort)
-                              .arg(connectTimer.elapsed()));
-                    return true;
-                }
-            }
-            return false;
-        };
-
-        auto executeOnce = [&](QTcpSocket &socket, const qint64 afterConnectMs) -> bool {
-            if (!kUseEiscp) {
-                const QByteArray terminator = kUseCrlf ? QByteArrayLiteral("\r\n") : QByteArrayLiteral("\r");
-                trace(QStringLiteral("iscp phase cmd=%1 phase=write-begin elapsedMs=%2")
-                          .arg(QString::fromLatin1(command))
-                          .arg(afterConnectMs));
-                if (socket.write(QByteArrayLiteral("!1") + command + terminator) < 0) {
-                    trace(QStringLiteral("iscp write-failed cmd=%1 mode=plain error=%2")
-                              .arg(QString::fromLatin1(command))
-                              .arg(socket.errorString()));
-                    return false;
-                }
-                trace(QStringLiteral("iscp phase cmd=%1 phase=write-end elapsedMs=%2")
-                          .arg(QString::fromLatin1(command))
-                          .arg(totalTimer.elapsed()));
-
-                if (parseResponse && responseTimeoutMs > 0) {
-                if (!socket.waitForReadyRead(responseTimeoutMs))
-                    return false;
-                const QByteArray data = socket.readAll();
-                timingLog(QStringLiteral("iscp.read cmd=%1 bytes=%2 elapsedMs=%3")
-                              .arg(QString::fromLatin1(command))
-                              .arg(data.size())
-                              .arg(totalTimer.elapsed()));
-                if (data.isEmpty())
-                    return false;
-                processResponseData(data);
-                }
-                return true;
-            }
-
-            const QByteArray frame = buildEiscpFrame(command);
-            trace(QStringLiteral("iscp phase cmd=%1 phase=write-begin elapsedMs=%2")
-                      .arg(QString::fromLatin1(command))
-                      .arg(afterConnectMs));
-            if (socket.write(frame) < 0) {
-                trace(QStringLiteral("iscp write-failed cmd=%1 mode=eiscp error=%2")
-                          .arg(QString::fromLatin1(command))
-                          .arg(socket.errorString()));
-                return false;
-            }
-            trace(QStringLiteral("iscp phase cmd=%1 phase=write-end elapsedMs=%2")
-                      .arg(QString::fromLatin1(command))
-                      .arg(totalTimer.elapsed()));
-
-            if (!parseResponse || responseTimeoutMs <= 0)
-                return true;
-
-            QByteArray data;
-            int readWaitedMs = 0;
-            bool firstWaitLogged = false;
-            trace(QStringLiteral("iscp phase cmd=%1 phase=read-loop-begin elapsedMs=%2 timeoutMs=%3")
-                      .arg(QString::fromLatin1(command))
-                      .arg(totalTimer.elapsed())
-                      .arg(responseTimeoutMs));
-            while (readWaitedMs < responseTimeoutMs) {
-                const bool ready = socket.waitForReadyRead(100);
-                if (!firstWaitLogged) {
-                    trace(QStringLiteral("iscp phase cmd=%1 phase=first-readyread ready=%2 elapsedMs=%3")
-                              .arg(QString::fromLatin1(command))
-                              .arg(ready ? 1 : 0)
-                              .arg(totalTimer.elapsed()));
-                    firstWaitLogged = true;
-                }
-                if (ready) {
-                    data.append(socket.readAll());
-                    QElapsedTimer coalesceTimer;
-                    coalesceTimer.start();
-                    while (coalesceTimer.elapsed() < 120) {
-                        if (!socket.waitForReadyRead(10))
-                            break;
-                        const QByteArray chunk = socket.readAll();
-                        if (chunk.isEmpty())
-                            break;
-                        data.append(chunk);
-                    }
-                    break;
-                }
-                readWaitedMs += 100;
-            }
-
-            trace(QStringLiteral("iscp read cmd=%1 readWaitedMs=%2 bytes=%3")
-                      .arg(QString::fromLatin1(command))
-                      .arg(readWaitedMs)
-                      .arg(data.size()));
-            timingLog(QStringLiteral("iscp.read cmd=%1 readWaitedMs=%2 bytes=%3 elapsedMs=%4")
-                          .arg(QString::fromLatin1(command))
-                          .arg(readWaitedMs)
-                          .arg(data.size())
-                          .arg(totalTimer.elapsed()));
-            if (data.isEmpty())
-                return false;
-
-            processResponseData(data);
-            return true;
-        };
 
         if (maxAttempts < 1)
             maxAttempts = 1;
         bool hadConnectedSession = false;
+        bool lostSession = false;
         for (int attempt = 0; attempt < maxAttempts; ++attempt) {
-            QTcpSocket socket;
-            socket.setSocketOption(QAbstractSocket::KeepAliveOption, 1);
-            QString connectedHost;
-            if (!connectSocket(socket, connectedHost))
+            if (ctx.isCancelled() || ctx.expired())
+                break;
+            bool reused = false;
+            ControlSession *session = acquireSession(connectTimeoutMs, command, ctx, &reused);
+            if (!session)
                 continue;
 
-            hadConnectedSession = true;
-            markConnectSuccess();
-            const bool ok = executeOnce(socket, totalTimer.elapsed());
-
-            trace(QStringLiteral("iscp phase cmd=%1 phase=disconnect-begin elapsedMs=%2")
-                      .arg(QString::fromLatin1(command))
-                      .arg(totalTimer.elapsed()));
-            socket.disconnectFromHost();
-            if (socket.state() != QAbstractSocket::UnconnectedState) {
-                int disconnectWaitedMs = 0;
-                while (socket.state() != QAbstractSocket::UnconnectedState && disconnectWaitedMs < 300) {
-                    socket.waitForDisconnected(50);
-                    disconnectWaitedMs += 50;
-                }
+            // A fresh connect proves the link; a kept-open session only once its echo is back below.
+            if (!reused) {
+                hadConnectedSession = true;
+                markConnectSuccess();
+            }
+            bool ok = writeIscpCommands(*session, commands);
+            // A kept-open session can die silently, so a write on it only counts once the echo is back.
+            int replyTimeoutMs = (parseResponse && responseTimeoutMs > 0) ? responseTimeoutMs : 0;
+            if (reused)
+                replyTimeoutMs = std::max(replyTimeoutMs, kSessionEchoTimeoutMs);
+            if (ok && replyTimeoutMs > 0) {
+                QSet<QByteArray> pending;
+                for (const QByteArray &sent : commands)
+                    pending.insert(sent.left(3));
+                ok = awaitIscpReplies(*session, pending, replyTimeoutMs, ctx);
             }
-            trace(QStringLiteral("iscp phase cmd=%1 phase=disconnect-end elapsedMs=%2")
-                      .arg(QString::fromLatin1(command))
-                      .arg(totalTimer.elapsed()));
 
             if (ok) {
-                timingLog(QStringLiteral("iscp.done cmd=%1 status=success elapsedMs=%2 attempt=%3")
+                if (reused)
+                    markConnectSuccess();
+                releaseSession();
+                timingLog(QStringLiteral("iscp.done cmd=%1 status=success elapsedMs=%2 attempt=%3 reused=%4")
                               .arg(QString::fromLatin1(command))
                               .arg(totalTimer.elapsed())
-                              .arg(attempt + 1));
-                trace(QStringLiteral("iscp done cmd=%1 elapsedMs=%2 attempt=%3")
-                          .arg(QString::fromLatin1(command))
-                          .arg(totalTimer.elapsed())
-                          .arg(attempt + 1));
+                              .arg(attempt + 1)
+                              .arg(reused ? 1 : 0));
                 return true;
             }
+            if (ctx.isCancelled()) {
+                releaseSession();
+                break;
+            }
+            dropSession();
+            // The stale session does not use up an attempt; the retry on a fresh connection is what counts.
+            if (reused && !lostSession) {
+                lostSession = true;
+                m_sessionLost = true;
+                ++maxAttempts;
+            }
         }
 
-        if (!hadConnectedSession)
-            markConnectFailure();
-        timingLog(QStringLiteral("iscp.done cmd=%1 status=failure elapsedMs=%2")
+        if (!hadConnectedSession && !ctx.isCancelled()) {
+            if (lostSession)
+                markLinkLost();
+            else
+                markConnectFailure();
+        }
+        timingLog(QStringLiteral("iscp.done cmd=%1 status=%2 elapsedMs=%3")
                       .arg(QString::fromLatin1(command))
+                      .arg(ctx.isCancelled() ? QStringLiteral("cancelled") : QStringLiteral("failure"))
                       .arg(totalTimer.elapsed()));
-        trace(QStringLiteral("iscp failed cmd=%1 totalElapsedMs=%2")
-                  .arg(QString::fromLatin1(command))
-                  .arg(totalTimer.elapsed()));
         return false;
     }
 
-    bool sendIscpPollBatch(const std::array<QByteArray, 4> &commands,
-                           int responseTimeoutMs)
+    // Remembered winner first, then address families alternate (RFC 8305, section 4).
+    QStringList orderedConnectCandidates(QStringList hosts) const
     {
-        const int connectTimeoutMs = 1500;
-        const QStringList hostCandidates = effectiveHosts();
-        if (hostCandidates.isEmpty() || m_controlPort == 0)
+        if (hosts.removeOne(m_preferredHost))
+            hosts.prepend(m_preferredHost);
+        if (hosts.size() < 3)
+            return hosts;
+        const QAbstractSocket::NetworkLayerProtocol firstFamily = QHostAddress(hosts.front()).protocol();
+        QStringList primary;
+        QStringList secondary;
+        for (const QString &host : std::as_const(hosts))
+            (QHostAddress(host).protocol() == firstFamily ? primary : secondary).push_back(host);
+        QStringList ordered;
+        for (qsizetype i = 0; i < std::max(primary.size(), secondary.size()); ++i) {
+            if (i < primary.size())
+                ordered.push_back(primary.at(i));
+            if (i < secondary.size())
+                ordered.push_back(secondary.at(i));
+        }
+        return ordered;
+    }
+
+    bool openControlSocket(ControlSession &session,
+                           int connectTimeoutMs,
+                           const QByteArray &context,
+                           const OperationContext &ctx)
+    {
+        if (!isTcpTransport())
+            return openLocalTransport(session, context, ctx);
+        const QStringList hostCandidates = orderedConnectCandidates(effectiveHosts());
+        if (hostCandidates.isEmpty() || m_controlPort == 0 || ctx.isCancelled())
             return false;
-        const std::int64_t pollStartMs = nowMs();
-        timingLog(QStringLiteral("poll.batch.start hostCount=%1 port=%2 responseTimeoutMs=%3 queueSize=%4")
-                      .arg(hostCandidates.size())
-                      .arg(m_controlPort)
-                      .arg(responseTimeoutMs)
-                      .arg(static_cast<int>(m_operationQueue.size())));
-        bool interrupted = false;
-        auto shouldInterrupt = [&]() -> bool {
-            if (hasQueuedPriorityWork()) {
-                interrupted = true;
-                return true;
-            }
+        QElapsedTimer connectTimer;
+        connectTimer.start();
+        session.socket.abort();
+        session.rxBuffer.clear();
+        session.seenCommands.clear();
+        session.framing = m_transport.framing;
+
+        // The session socket takes the first candidate; later ones race on helper sockets.
+        std::vector<std::unique_ptr<QTcpSocket>> helperSockets;
+        std::vector<QTcpSocket *> sockets{&session.socket};
+        for (int i = 1; i < hostCandidates.size(); ++i) {
+            helperSockets.push_back(std::make_unique<QTcpSocket>());
+            sockets.push_back(helperSockets.back().get());
+        }
+        const int staggerMs = kConnectAttemptDelayMs * (static_cast<int>(sockets.size()) - 1);
+        int winner = raceConnect(sockets, hostCandidates, m_controlPort, ctx.stepDeadline(connectTimeoutMs + staggerMs), ctx.token);
+        if (winner > 0 && !adoptConnectedSocket(session.socket, *sockets[static_cast<std::size_t>(winner)])) {
+            timingLog(QStringLiteral("iscp.connect.adopt-failed cmd=%1 host=%2")
+                          .arg(QString::fromLatin1(context))
+                          .arg(hostCandidates.at(winner)));
+            winner = -1;
+        }
+
+        if (winner >= 0) {
+            session.host = hostCandidates.at(winner);
+            m_preferredHost = session.host;
+            timingLog(QStringLiteral("iscp.connect.ok cmd=%1 host=%2 elapsedMs=%3 candidate=%4/%5")
+                          .arg(QString::fromLatin1(context))
+                          .arg(session.host)
+                          .arg(connectTimer.elapsed())
+                          .arg(winner + 1)
+                          .arg(hostCandidates.size()));
+            return true;
+        }
+        if (ctx.isCancelled()) {
+            timingLog(QStringLiteral("iscp.connect.cancelled cmd=%1 candidates=%2 waitedMs=%3")
+                          .arg(QString::fromLatin1(context))
+                          .arg(hostCandidates.size())
+                          .arg(connectTimer.elapsed()));
             return false;
-        };
+        }
+        for (std::size_t i = 0; i < sockets.size(); ++i) {
+            const QString &host = hostCandidates.at(static_cast<int>(i));
+            timingLog(QStringLiteral("iscp.connect.timeout cmd=%1 host=%2 waitedMs=%3 err=%4")
+                          .arg(QString::fromLatin1(context))
+                          .arg(host)
+                          .arg(connectTimer.elapsed())
+                          .arg(sockets[i]->errorString()));
+            logConnectFailure(sockets[i]->errorString(), host);
+        }
+        return false;
+    }
 
-        auto connectSocket = [&](QTcpSocket &socket) -> bool {
-            for (const QString &host : hostCandidates) {
-                if (shouldInterrupt())
-                    return false;
-                socket.abort();
-                socket.connectToHost(host, m_controlPort);
-
-                int waitedMs = 0;
-                while (!socket.waitForConnected(100)) {
-                    if (shouldInterrupt()) {
-                        socket.abort();
-                        return false;
-                    }
-                    waitedMs += 100;
-                    if (waitedMs >= connectTimeoutMs) {
-                        if (socket.state() != QAbstractSocket::ConnectedState)
-                            logConnectFailure(socket.errorString(), host);
-                        break;
-                    }
+    // Serial devices and ptys go through a SerialBridge, Unix sockets are adopted directly; both then behave
+    // like a connected TCP session. There is nothing to race, so a failure is reported at once.
+    bool openLocalTransport(ControlSession &session, const QByteArray &context, const OperationContext &ctx)
+    {
+        if (ctx.isCancelled())
+            return false;
+        QElapsedTimer connectTimer;
+        connectTimer.start();
+        session.socket.abort();
+        session.rxBuffer.clear();
+        session.seenCommands.clear();
+        session.framing = m_transport.framing;
+        QString error;
+#ifdef Q_OS_LINUX
+        session.bridge.reset();
+        int fd = -1;
+        if (m_transport.kind == TransportKind::Serial) {
+            session.bridge = std::make_unique<SerialBridge>();
+            fd = session.bridge->open(m_transport.path, m_transport.baudRate, &error);
+        } else {
+            sockaddr_un address{};
+            if (!fillUnixAddress(m_transport.path, &address)) {
+                error = QStringLiteral("Socket path too long");
+            } else {
+                fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+                    error = QString::fromLocal8Bit(std::strerror(errno));
+                    ::close(fd);
+                    fd = -1;
                 }
-                if (socket.state() == QAbstractSocket::ConnectedState)
-                    return true;
             }
+        }
+        if (fd >= 0 && !session.socket.setSocketDescriptor(fd, QAbstractSocket::ConnectedState, QIODevice::ReadWrite)) {
+            error = session.socket.errorString();
+            ::close(fd);
+            fd = -1;
+        }
+        if (fd < 0)
+            session.bridge.reset();
+        const bool ok = fd >= 0;
+#else
+        error = QStringLiteral("Local transports need Linux");
+        const bool ok = false;
+#endif
+        if (!ok) {
+            timingLog(QStringLiteral("iscp.connect.failed cmd=%1 endpoint=%2 elapsedMs=%3 err=%4")
+                          .arg(QString::fromLatin1(context))
+                          .arg(transportEndpoint())
+                          .arg(connectTimer.elapsed())
+                          .arg(error));
+            logConnectFailure(error, m_transport.path);
             return false;
-        };
+        }
+        session.host = m_transport.path;
+        timingLog(QStringLiteral("iscp.connect.ok cmd=%1 endpoint=%2 framing=%3 elapsedMs=%4")
+                      .arg(QString::fromLatin1(context))
+                      .arg(transportEndpoint())
+                      .arg(framingName(session.framing))
+                      .arg(connectTimer.elapsed()));
+        return true;
+    }
 
-        auto sendQueryOnConnectedSocket = [&](QTcpSocket &socket, const QByteArray &command) -> bool {
-            if (!kUseEiscp) {
-                const QByteArray terminator = kUseCrlf ? QByteArrayLiteral("\r\n") : QByteArrayLiteral("\r");
-                if (socket.write(QByteArrayLiteral("!1") + command + terminator) < 0)
-                    return false;
-                if (responseTimeoutMs <= 0)
-                    return true;
-                int readWaitedMs = 0;
-                while (!socket.waitForReadyRead(100)) {
-                    if (shouldInterrupt())
-                        return false;
-                    readWaitedMs += 100;
-                    if (readWaitedMs >= responseTimeoutMs)
-                        return false;
-                }
-                const QByteArray data = socket.readAll();
-                if (data.isEmpty())
-                    return false;
-                processResponseData(data);
-                return true;
-            }
+    bool writeIscpCommands(ControlSession &session, const QList<QByteArray> &commands)
+    {
+        // All frames go out in one write so the receiver sees them back-to-back.
+        QByteArray frames;
+        for (const QByteArray &command : commands)
+            frames.append(encodeIscpFrame(session.framing, command));
+        session.seenCommands.clear();
+        if (session.socket.write(frames) != frames.size()) {
+            trace(QStringLiteral("iscp write-failed cmds=%1 error=%2")
+                      .arg(commands.size())
+                      .arg(session.socket.errorString()));
+            return false;
+        }
+        session.socket.flush();
+        m_lastWriteMs = nowMs();
+        return true;
+    }
 
-            const QByteArray frame = buildEiscpFrame(command);
-            if (socket.write(frame) < 0)
-                return false;
-            if (responseTimeoutMs <= 0)
-                return true;
+    void readIscpSession(ControlSession &session)
+    {
+        const QByteArray chunk = session.socket.readAll();
+        if (chunk.isEmpty())
+            return;
+        session.rxBuffer.append(chunk);
+        session.rxBuffer.remove(0, processResponseData(session.framing, session.rxBuffer, &session.seenCommands));
+    }
 
-            QByteArray data;
-            int readWaitedMs = 0;
-            while (readWaitedMs < responseTimeoutMs) {
-                if (shouldInterrupt())
-                    return false;
-                if (socket.waitForReadyRead(100)) {
-                    data.append(socket.readAll());
-                    QElapsedTimer coalesceTimer;
-                    coalesceTimer.start();
-                    while (coalesceTimer.elapsed() < 120) {
-                        if (shouldInterrupt())
-                            return false;
-                        if (!socket.waitForReadyRead(10))
-                            break;
-                        const QByteArray chunk = socket.readAll();
-                        if (chunk.isEmpty())
-                            break;
-                        data.append(chunk);
-                    }
-                    break;
-                }
-                readWaitedMs += 100;
-            }
+    bool awaitIscpReplies(ControlSession &session,
+                          QSet<QByteArray> &pending,
+                          int timeoutMs,
+                          const OperationContext &ctx)
+    {
+        // The session's readyRead handler may have consumed the reply already; seenCommands keeps it.
+        QElapsedTimer roundTrip;
+        roundTrip.start();
+        const WaitStatus status = waitForSocket(
+            session.socket,
+            [this, &session, &pending]() {
+                readIscpSession(session);
+                for (const QByteArray &prefix : std::as_const(session.seenCommands))
+                    pending.remove(prefix);
+                return pending.isEmpty();
+            },
+            ctx.stepDeadline(timeoutMs),
+            ctx.token);
+        if (status == WaitStatus::Ready)
+            noteRoundTrip(roundTrip.nsecsElapsed() / 1000);
+        else if (status == WaitStatus::TimedOut)
+            noteReplyTimeout();
+        return status == WaitStatus::Ready;
+    }
 
-            if (data.isEmpty())
+    void settleIscpSession(ControlSession &session, int durationMs, const OperationContext &ctx)
+    {
+        // Only the deadline ends this wait; pushed frames are processed meanwhile.
+        waitForSocket(
+            session.socket,
+            [this, &session]() {
+                readIscpSession(session);
                 return false;
-            processResponseData(data);
+            },
+            ctx.stepDeadline(durationMs),
+            ctx.token);
+    }
+
+    void closeControlSocket(ControlSession &session)
+    {
+        constexpr int kDisconnectWaitMs = 300;
+        session.socket.disconnectFromHost();
+        if (session.socket.state() == QAbstractSocket::UnconnectedState)
+            return;
+        // Blocking on purpose: this also runs from the idle timer, outside any operation, where a nested event
+        // loop would let a lifecycle call drop the session under this frame.
+        if (!session.socket.waitForDisconnected(kDisconnectWaitMs))
+            session.socket.abort();
+    }
+
+    bool queryOnSession(ControlSession &session,
+                        const QByteArray &command,
+                        int responseTimeoutMs,
+                        const OperationContext &ctx)
+    {
+        if (!writeIscpCommands(session, {command}))
+            return false;
+        if (responseTimeoutMs <= 0)
             return true;
-        };
+        QSet<QByteArray> pending{command.left(3)};
+        return awaitIscpReplies(session, pending, responseTimeoutMs, ctx);
+    }
 
-        QTcpSocket socket;
-        socket.setSocketOption(QAbstractSocket::KeepAliveOption, 1);
-        if (!connectSocket(socket)) {
-            if (interrupted)
-                return true;
+    bool sendIscpPollBatch(const std::array<QByteArray, 4> &commands,
+                           int responseTimeoutMs,
+                           const OperationContext &ctx)
+    {
+        const int connectTimeoutMs = 1500;
+        const QStringList hostCandidates = effectiveHosts();
+        if (!hasControlEndpoint())
+            return false;
+        const std::int64_t pollStartMs = nowMs();
+        timingLog(QStringLiteral("poll.batch.start hostCount=%1 port=%2 responseTimeoutMs=%3 queueSize=%4")
+                      .arg(hostCandidates.size())
+                      .arg(m_controlPort)
+                      .arg(responseTimeoutMs)
+                      .arg(static_cast<int>(m_operationQueue.size())));
+        auto finishInterrupted = [&]() {
+            timingLog(QStringLiteral("poll.batch.end status=interrupted elapsedMs=%1").arg(nowMs() - pollStartMs));
+            return true;
+        };
+        if (hasQueuedPriorityWork())
+            return finishInterrupted();
+
+        bool reused = false;
+        ControlSession *session = acquireSession(connectTimeoutMs, QByteArrayLiteral("poll"), ctx, &reused);
+        if (!session) {
+            if (ctx.isCancelled())
+                return finishInterrupted();
             markConnectFailure();
             return false;
         }
 
-        markConnectSuccess();
+        // A kept-open session counts as connected only once it answered.
+        bool confirmed = !reused;
+        if (confirmed)
+            markConnectSuccess();
         bool allSucceeded = true;
         bool sawConnectFailure = false;
 
@@ -1826,51 +6398,44 @@ private:
                 allSucceeded = false;
                 break;
             }
-            if (shouldInterrupt())
+            if (ctx.isCancelled())
                 break;
 
-            bool commandSucceeded = sendQueryOnConnectedSocket(socket, command);
-            if (!commandSucceeded) {
-                if (interrupted)
-                    break;
-                socket.abort();
-                if (connectSocket(socket)) {
-                    if (interrupted)
-                        break;
+            bool commandSucceeded = queryOnSession(*session, command, responseTimeoutMs, ctx);
+            if (!commandSucceeded && !ctx.isCancelled()) {
+                const bool wasEstablished = m_sessionEstablished;
+                dropSession();
+                session = acquireSession(connectTimeoutMs, QByteArrayLiteral("poll"), ctx);
+                if (session) {
                     markConnectSuccess();
-                    commandSucceeded = sendQueryOnConnectedSocket(socket, command);
-                } else {
-                    if (!interrupted)
+                    commandSucceeded = queryOnSession(*session, command, responseTimeoutMs, ctx);
+                } else if (!ctx.isCancelled()) {
+                    // The session answered until now and the receiver refuses a new one: the link is gone.
+                    if (wasEstablished)
+                        markLinkLost();
+                    else
                         sawConnectFailure = true;
                 }
             }
 
             if (!commandSucceeded) {
-                if (interrupted)
-                    break;
-                allSucceeded = false;
+                if (!ctx.isCancelled())
+                    allSucceeded = false;
                 break;
             }
-            if (shouldInterrupt())
-                break;
-        }
-
-        socket.disconnectFromHost();
-        if (socket.state() != QAbstractSocket::UnconnectedState) {
-            int disconnectWaitedMs = 0;
-            while (socket.state() != QAbstractSocket::UnconnectedState && disconnectWaitedMs < 300) {
-                socket.waitForDisconnected(50);
-                disconnectWaitedMs += 50;
+            if (!confirmed) {
+                confirmed = true;
+                markConnectSuccess();
             }
         }
 
-        if (sawConnectFailure && !interrupted)
-            markConnectFailure();
+        if (session)
+            releaseSession();
 
-        if (interrupted) {
-            timingLog(QStringLiteral("poll.batch.end status=interrupted elapsedMs=%1").arg(nowMs() - pollStartMs));
-            return true;
-        }
+        if (ctx.isCancelled())
+            return finishInterrupted();
+        if (sawConnectFailure)
+            markConnectFailure();
         timingLog(QStringLiteral("poll.batch.end status=%1 elapsedMs=%2")
                       .arg(allSucceeded ? QStringLiteral("success") : QStringLiteral("failure"))
                       .arg(nowMs() - pollStartMs));
@@ -1887,45 +6452,21 @@ private:
         return v1::Utf8String("Receiver unavailable");
     }
 
-    void processResponseData(const QByteArray &data)
+    // Returns the number of leading bytes consumed; an incomplete trailing frame is left over.
+    int processResponseData(const FramingPolicy &framing,
+                            const QByteArray &data,
+                            QSet<QByteArray> *seenCommands = nullptr)
     {
         if (data.isEmpty())
-            return;
-
-        if (!kUseEiscp) {
-            handleIscpPayload(data);
-            return;
-        }
-
-        int offset = 0;
-        while (offset + 16 <= data.size()) {
-            const int headerIndex = data.indexOf("ISCP", offset);
-            if (headerIndex < 0 || headerIndex + 16 > data.size())
-                return;
-
-            const unsigned char *header =
-                reinterpret_cast<const unsigned char *>(data.constData() + headerIndex);
-            auto readInt = [](const unsigned char *ptr) -> quint32 {
-                return (static_cast<quint32>(ptr[0]) << 24)
-                    | (static_cast<quint32>(ptr[1]) << 16)
-                    | (static_cast<quint32>(ptr[2]) << 8)
-                    | static_cast<quint32>(ptr[3]);
-            };
-
-            const quint32 headerSize = readInt(header + 4);
-            const quint32 dataSize = readInt(header + 8);
-            const int frameSize = static_cast<int>(headerSize + dataSize);
-            if (headerIndex + frameSize > data.size())
-                return;
-
-            const QByteArray payload = data.mid(headerIndex + static_cast<int>(headerSize),
-                                                static_cast<int>(dataSize));
-            handleIscpPayload(payload);
-            offset = headerIndex + frameSize;
-        }
+            return 0;
+        return std::visit(
+            [&](const auto &policy) {
+                return policy.extract(data, [&](const QByteArray &payload) { handleIscpPayload(payload, seenCommands); });
+            },
+            framing);
     }
 
-    void handleIscpPayload(const QByteArray &payload)
+    void handleIscpPayload(const QByteArray &payload, QSet<QByteArray> *seenCommands = nullptr)
     {
         auto sanitizeLine = [](QByteArray line) {
             line = line.trimmed();
@@ -1948,6 +6489,8 @@ private:
             if (line.startsWith("!1"))
                 line = line.mid(2);
             line = sanitizeLine(line);
+            if (seenCommands && line.size() >= 3)
+                seenCommands->insert(line.left(3));
 
             if (line.startsWith("PWR")) {
                 const QByteArray value = line.mid(3);
@@ -1986,6 +6529,108 @@ private:
                 }
                 continue;
             }
+
+            if (line.startsWith("TUN")) {
+                const QByteArray value = line.mid(3).trimmed();
+                if (value.size() == 5 && std::all_of(value.begin(), value.end(), [](char c) { return c >= '0' && c <= '9'; }))
+                    emitExtendedState(ChannelId::TunerFrequency, value.toStdString());
+                continue;
+            }
+
+            if (line.startsWith("PRS")) {
+                const QString code = QString::fromLatin1(line.mid(3)).trimmed().toUpper();
+                static const QRegularExpression kCodeRe(QStringLiteral("^[0-9A-F]{2}$"));
+                if (kCodeRe.match(code).hasMatch())
+                    emitExtendedState(ChannelId::TunerPreset, code.toStdString());
+                continue;
+            }
+
+            if (line.startsWith("NRI")) {
+                handleReceiverInfo(line.mid(3));
+                continue;
+            }
+
+            if (line.startsWith("ECN")) {
+                learnMacFromDiscovery(line.mid(3));
+                continue;
+            }
+
+            if (line.startsWith("NLA")) {
+                const QByteArray reply = line.mid(3);
+                // A page that timed out can still be answered later; that reply must not stand in for ours.
+                if (reply == "N/A" || isCurrentBrowseReply(reply))
+                    m_browse.reply = reply;
+                else
+                    timingLog(QStringLiteral("browse.nla.stale sequence=%1 expected=%2")
+                                  .arg(QString::fromLatin1(reply.mid(1, 4)))
+                                  .arg(QString::fromLatin1(*hexField(m_browse.sequence, 4))));
+                continue;
+            }
+
+            if (line.startsWith("NLT")) {
+                handleBrowseTitle(line.mid(3));
+                continue;
+            }
+
+            // NLS: info type (A ASCII, U UTF-8, C cursor), line 0-9, property (icon code or '-'), text.
+            if (line.startsWith("NLS")) {
+                const char type = (line.size() >= 6) ? line.at(3) : '\0';
+                const int row = (line.size() >= 6) ? line.at(4) - '0' : -1;
+                if ((type == 'A' || type == 'U') && row >= 0 && row < kNlsWindowLines) {
+                    const QByteArray text = line.mid(6);
+                    m_browse.nlsLines[static_cast<std::size_t>(row)] =
+                        (type == 'U' ? QString::fromUtf8(text) : QString::fromLatin1(text)).trimmed();
+                }
+                continue;
+            }
+
+            if (line.startsWith("IFA") || line.startsWith("IFV")) {
+                const bool video = line.startsWith("IFV");
+                const QByteArray value = line.mid(3);
+                QByteArray &raw = m_signalInfoRaw[video ? 1 : 0];
+                if (value == "N/A" || value == raw)
+                    continue;
+                raw = value;
+                m_signalInfoFresh = true;
+                emitExtendedState(video ? ChannelId::VideoSignal : ChannelId::AudioSignal,
+                                  toJson(parseSignalInfo(value, video)));
+                continue;
+            }
+
+            // Extended channels: pushes and echoes are reported whether the channel is warm or not.
+            if (line.startsWith("LMD") || line.startsWith("DIM")) {
+                const QString code = QString::fromLatin1(line.mid(3)).trimmed().toUpper();
+                static const QRegularExpression kCodeRe(QStringLiteral("^[0-9A-F]{2}$"));
+                if (kCodeRe.match(code).hasMatch())
+                    emitExtendedState(line.startsWith("LMD") ? ChannelId::ListeningMode : ChannelId::Dimmer,
+                                      code.toStdString());
+                continue;
+            }
+
+            if (line.startsWith("TFR")) {
+                // "B+2T-4", or a single part on some models.
+                const QByteArray value = line.mid(3);
+                const qsizetype bassAt = value.indexOf('B');
+                const qsizetype trebleAt = value.indexOf('T');
+                if (bassAt >= 0) {
+                    const qsizetype end = (trebleAt > bassAt) ? trebleAt : value.size();
+                    if (const auto bass = parseSignedIscpLevel(value.mid(bassAt + 1, end - bassAt - 1)))
+                        emitExtendedState(ChannelId::Bass, static_cast<std::int64_t>(*bass));
+                }
+                if (trebleAt >= 0) {
+                    const qsizetype end = (bassAt > trebleAt) ? bassAt : value.size();
+                    if (const auto treble = parseSignedIscpLevel(value.mid(trebleAt + 1, end - trebleAt - 1)))
+                        emitExtendedState(ChannelId::Treble, static_cast<std::int64_t>(*treble));
+                }
+                continue;
+            }
+
+            if (line.startsWith("CTL") || line.startsWith("SWL")) {
+                if (const auto level = parseSignedIscpLevel(line.mid(3)))
+                    emitExtendedState(line.startsWith("CTL") ? ChannelId::CenterLevel : ChannelId::SubwooferLevel,
+                                      static_cast<std::int64_t>(*level));
+                continue;
+            }
         }
     }
 
@@ -2076,6 +6721,77 @@ private:
         input.choices = inputChoicesForChannel();
         channels.push_back(input);
 
+        // Extended channels are registered up front but cost no traffic until first used.
+        v1::Channel listeningMode;
+        listeningMode.externalId = kChannelListeningMode;
+        listeningMode.name = "Listening mode";
+        listeningMode.kind = v1::ChannelKind::Unknown;
+        listeningMode.dataType = v1::ChannelDataType::String;
+        listeningMode.flags = v1::ChannelFlag::Readable | v1::ChannelFlag::Writable | v1::ChannelFlag::Reportable;
+        listeningMode.choices = listeningModeChoices();
+        channels.push_back(listeningMode);
+
+        const std::array<std::pair<ChannelId, const char *>, 4> levels{{
+            {ChannelId::Bass, "Bass"},
+            {ChannelId::Treble, "Treble"},
+            {ChannelId::CenterLevel, "Center level"},
+            {ChannelId::SubwooferLevel, "Subwoofer level"},
+        }};
+        for (const auto &[id, name] : levels) {
+            v1::Channel level;
+            level.externalId = channelName(id);
+            level.name = name;
+            level.kind = v1::ChannelKind::Unknown;
+            level.dataType = v1::ChannelDataType::Int;
+            level.flags = v1::ChannelFlag::Readable | v1::ChannelFlag::Writable | v1::ChannelFlag::Reportable;
+            level.minValue = levelRange(id).first;
+            level.maxValue = levelRange(id).second;
+            channels.push_back(level);
+        }
+
+        v1::Channel dimmer;
+        dimmer.externalId = kChannelDimmer;
+        dimmer.name = "Dimmer";
+        dimmer.kind = v1::ChannelKind::Unknown;
+        dimmer.dataType = v1::ChannelDataType::String;
+        dimmer.flags = v1::ChannelFlag::Readable | v1::ChannelFlag::Writable | v1::ChannelFlag::Reportable;
+        dimmer.choices = dimmerChoices();
+        channels.push_back(dimmer);
+
+        v1::Channel tunerFrequency;
+        tunerFrequency.externalId = kChannelTunerFrequency;
+        tunerFrequency.name = "Tuner frequency";
+        tunerFrequency.kind = v1::ChannelKind::Unknown;
+        tunerFrequency.dataType = v1::ChannelDataType::String;
+        tunerFrequency.flags = v1::ChannelFlag::Readable | v1::ChannelFlag::Writable | v1::ChannelFlag::Reportable;
+        channels.push_back(tunerFrequency);
+
+        v1::Channel tunerPreset;
+        tunerPreset.externalId = kChannelTunerPreset;
+        tunerPreset.name = "Tuner preset";
+        tunerPreset.kind = v1::ChannelKind::Unknown;
+        tunerPreset.dataType = v1::ChannelDataType::String;
+        tunerPreset.flags = v1::ChannelFlag::Readable | v1::ChannelFlag::Writable | v1::ChannelFlag::Reportable;
+        tunerPreset.choices = presetChoicesForChannel();
+        channels.push_back(tunerPreset);
+
+        // Diagnostics: JSON objects with the parsed IFA/IFV fields, fetched on input change or power-on,
+        // and the link quality computed from the instance's own exchanges.
+        const std::array<std::pair<ChannelId, const char *>, 3> diagnostics{{
+            {ChannelId::AudioSignal, "Audio signal"},
+            {ChannelId::VideoSignal, "Video signal"},
+            {ChannelId::LinkQuality, "Link quality"},
+        }};
+        for (const auto &[id, name] : diagnostics) {
+            v1::Channel diagnostic;
+            diagnostic.externalId = channelName(id);
+            diagnostic.name = name;
+            diagnostic.kind = v1::ChannelKind::Unknown;
+            diagnostic.dataType = v1::ChannelDataType::String;
+            diagnostic.flags = v1::ChannelFlag::Readable | v1::ChannelFlag::Reportable;
+            channels.push_back(diagnostic);
+        }
+
         v1::Channel connectivity;
         connectivity.externalId = kChannelConnectivity;
         connectivity.name = "Connectivity";
@@ -2122,11 +6838,11 @@ private:
         return "onkyo-pioneer";
     }
 
-    void requestInitialState()
+    void requestInitialState(const OperationContext &ctx)
     {
         if (!m_started || m_stopping)
             return;
-        if (effectiveHosts().isEmpty() || m_controlPort == 0)
+        if (!hasControlEndpoint())
             return;
 
         static const std::array<QByteArray, 4> commands = {
@@ -2135,7 +6851,7 @@ private:
             QByteArrayLiteral("AMTQSTN"),
             QByteArrayLiteral("SLIQSTN"),
         };
-        sendIscpPollBatch(commands, kPollQueryTimeoutMs);
+        sendIscpPollBatch(commands, kPollQueryTimeoutMs, ctx);
     }
 
     void reloadInputLabelMap()
@@ -2163,27 +6879,171 @@ private:
             return;
         m_connected = connected;
         updatePollInterval();
+        if (m_ipcDown)
+            return;
         v1::Utf8String err;
         if (!sendConnectionStateChanged(m_connected, &err))
             std::cerr << "failed to send connectionStateChanged: " << err << '\n';
     }
 
-    void emitChannelState(const QString &channelId, const v1::ScalarValue &value)
+    // Every distinct value gets the next sequence number of this instance; resends of the same value do not.
+    void journalChannelState(ChannelId channelId, const v1::ScalarValue &value)
     {
-        if (m_deviceId.empty())
+        JournalEntry &entry = m_stateJournal[static_cast<std::size_t>(channelId)];
+        if (entry.seq != 0 && entry.value == value)
+            return;
+        entry.seq = ++m_stateSeq;
+        entry.value = value;
+        publishSharedState(channelId, value);
+#ifdef Q_OS_LINUX
+        StateStreamServer::publish(m_externalId, channelName(channelId), value);
+#endif
+    }
+
+    // Mirrors a journaled value into the shared-memory table for local readers.
+    void publishSharedState(ChannelId channelId, const v1::ScalarValue &value)
+    {
+        onkyo::statetable::Writer *table = sharedStateTable();
+        if (!table || m_stateRecord < 0)
+            return;
+        onkyo::statetable::ChannelValue shared;
+        if (const auto *v = std::get_if<bool>(&value)) {
+            shared.type = onkyo::statetable::ValueType::Bool;
+            shared.boolValue = *v;
+        } else if (const auto *v = std::get_if<std::int64_t>(&value)) {
+            shared.type = onkyo::statetable::ValueType::Int;
+            shared.intValue = *v;
+        } else if (const auto *v = std::get_if<double>(&value)) {
+            shared.type = onkyo::statetable::ValueType::Double;
+            shared.doubleValue = *v;
+        } else if (const auto *v = std::get_if<v1::Utf8String>(&value)) {
+            shared.type = onkyo::statetable::ValueType::String;
+            shared.text = *v;
+        }
+        const std::int64_t tsMs = nowMs();
+        table->publishChannel(m_stateRecord, static_cast<std::size_t>(channelId), channelName(channelId), shared, tsMs);
+        if (channelId == ChannelId::Connectivity)
+            table->publishLink(m_stateRecord, static_cast<std::int32_t>(shared.intValue), -1, tsMs);
+    }
+
+    void noteRoundTrip(std::int64_t rttUs)
+    {
+        m_lastRttUs = rttUs;
+        LinkQualityStats &link = m_linkQuality;
+        // RFC 6298 smoothing (alpha 1/8).
+        link.srttUs = link.srttUs < 0 ? static_cast<double>(rttUs) : link.srttUs + (rttUs - link.srttUs) / 8.0;
+        recordExchange(false);
+        updateLinkQuality();
+        onkyo::statetable::Writer *table = sharedStateTable();
+        if (!table || m_stateRecord < 0)
+            return;
+        table->publishLink(m_stateRecord,
+                           static_cast<std::int32_t>(m_connected ? v1::ConnectivityStatus::Connected
+                                                                 : v1::ConnectivityStatus::Disconnected),
+                           rttUs,
+                           nowMs());
+    }
+
+    void noteReplyTimeout()
+    {
+        recordExchange(true);
+        updateLinkQuality();
+    }
+
+    void noteReconnect()
+    {
+        m_linkQuality.reconnectsMs.push_back(nowMs());
+        updateLinkQuality();
+    }
+
+    void recordExchange(bool timedOut)
+    {
+        LinkQualityStats &link = m_linkQuality;
+        if (link.filled == link.timedOut.size()) {
+            if (link.timedOut[link.next])
+                --link.timeouts;
+        } else {
+            ++link.filled;
+        }
+        link.timedOut[link.next] = timedOut;
+        if (timedOut)
+            ++link.timeouts;
+        link.next = (link.next + 1) % link.timedOut.size();
+    }
+
+    // linkQuality only changes on a significant move of one of its figures, and at most every
+    // kLinkQualityMinIntervalMs; a change inside that window goes out when it ends.
+    void updateLinkQuality()
+    {
+        LinkQualityStats &link = m_linkQuality;
+        const std::int64_t now = nowMs();
+        while (!link.reconnectsMs.empty() && now - link.reconnectsMs.front() >= 3600000)
+            link.reconnectsMs.pop_front();
+        // Until the first reply there is no RTT; timeouts and reconnects are reported without it.
+        const double rttMs = link.srttUs < 0 ? -1.0 : link.srttUs / 1000.0;
+        const double timeoutRatio =
+            link.filled == 0 ? 0.0 : static_cast<double>(link.timeouts) / static_cast<double>(link.filled);
+        const int reconnects = static_cast<int>(link.reconnectsMs.size());
+        const bool rttChanged = (rttMs < 0) != (link.emittedRttMs < 0)
+            || (rttMs >= 0
+                && qAbs(rttMs - link.emittedRttMs)
+                    >= std::max(kLinkQualityRttMinDeltaMs, link.emittedRttMs * kLinkQualityRttRelDelta));
+        const bool significant = link.emittedMs == 0
+            || rttChanged
+            || qAbs(timeoutRatio - link.emittedTimeoutRatio) >= kLinkQualityTimeoutDelta
+            || reconnects != link.emittedReconnects
+            || m_wakeStats.count != link.emittedWakes;
+        if (!significant)
+            return;
+        const std::int64_t waitMs = link.emittedMs + kLinkQualityMinIntervalMs - now;
+        if (link.emittedMs != 0 && waitMs > 0) {
+            if (!m_linkQualityTimer) {
+                m_linkQualityTimer = std::make_unique<QTimer>();
+                m_linkQualityTimer->setSingleShot(true);
+                QObject::connect(m_linkQualityTimer.get(), &QTimer::timeout, [this]() { updateLinkQuality(); });
+            }
+            if (!m_linkQualityTimer->isActive())
+                m_linkQualityTimer->start(static_cast<int>(waitMs));
+            return;
+        }
+        link.emittedRttMs = rttMs;
+        link.emittedTimeoutRatio = timeoutRatio;
+        link.emittedReconnects = reconnects;
+        link.emittedWakes = m_wakeStats.count;
+        link.emittedMs = now;
+        const QJsonObject quality{
+            {QStringLiteral("rttMs"), rttMs < 0 ? QJsonValue() : QJsonValue(qRound(rttMs * 10.0) / 10.0)},
+            {QStringLiteral("timeoutRatio"), qRound(timeoutRatio * 1000.0) / 1000.0},
+            {QStringLiteral("reconnectsPerHour"), reconnects},
+            {QStringLiteral("samples"), static_cast<int>(link.filled)},
+            {QStringLiteral("lastWakeToReadyMs"),
+             m_wakeStats.count > 0 ? QJsonValue(static_cast<qint64>(m_wakeStats.lastMs)) : QJsonValue()},
+        };
+        emitChannelState(ChannelId::LinkQuality, toJson(quality));
+    }
+
+    void emitChannelState(ChannelId channelId, const v1::ScalarValue &value)
+    {
+        journalChannelState(channelId, value);
+        // While core is away values only land in the cache; the resume snapshot carries them.
+        if (m_deviceId.empty() || m_ipcDown)
             return;
         v1::Utf8String err;
-        if (!sendChannelStateUpdated(m_deviceId, channelId.toStdString(), value, nowMs(), &err))
-            std::cerr << "failed to send channel state for " << channelId.toStdString() << ": " << err << '\n';
+        if (!sendChannelStateUpdated(m_deviceId, channelName(channelId), value, nowMs(), &err))
+            std::cerr << "failed to send channel state for " << channelName(channelId) << ": " << err << '\n';
     }
 
     void emitPowerState(bool value)
     {
+        if (value && m_powerState != PowerState::On) {
+            invalidateSignalInfo();
+            scheduleSignalInfoRefresh();
+        }
         m_powerState = value ? PowerState::On : PowerState::Off;
         if (m_lastReportedPower.has_value() && m_lastReportedPower.value() == value)
             return;
         m_lastReportedPower = value;
-        emitChannelState(QString::fromLatin1(kChannelPower), value);
+        emitChannelState(ChannelId::Power, value);
     }
 
     void emitMuteState(bool value)
@@ -2191,7 +7051,7 @@ private:
         if (m_lastReportedMute.has_value() && m_lastReportedMute.value() == value)
             return;
         m_lastReportedMute = value;
-        emitChannelState(QString::fromLatin1(kChannelMute), value);
+        emitChannelState(ChannelId::Mute, value);
     }
 
     void emitVolumeState(std::int64_t value)
@@ -2199,30 +7059,65 @@ private:
         if (m_lastReportedVolume.has_value() && m_lastReportedVolume.value() == value)
             return;
         m_lastReportedVolume = value;
-        emitChannelState(QString::fromLatin1(kChannelVolume), value);
+        emitChannelState(ChannelId::Volume, value);
     }
 
     void emitInputState(const QString &value)
     {
+        // Signal info belongs to one input; the cached strings are worthless once it changes.
+        if (value != m_signalInfoInput) {
+            m_signalInfoInput = value;
+            invalidateSignalInfo();
+            scheduleSignalInfoRefresh();
+        }
         if (m_hasLastReportedInput && m_lastReportedInput == value)
             return;
         m_lastReportedInput = value;
         m_hasLastReportedInput = true;
-        emitChannelState(QString::fromLatin1(kChannelInput), value.toStdString());
+        emitChannelState(ChannelId::Input, value.toStdString());
+    }
+
+    void emitExtendedState(ChannelId channelId, const v1::ScalarValue &value)
+    {
+        const JournalEntry &entry = m_stateJournal[static_cast<std::size_t>(channelId)];
+        if (entry.seq != 0 && entry.value == value)
+            return;
+        emitChannelState(channelId, value);
+    }
+
+    // Results a retry would get again. Failures (timeouts, lost connections) and TemporarilyOffline may
+    // turn out differently next time, so a retry of those runs the command again.
+    static bool isDefinitiveResult(v1::CmdStatus status)
+    {
+        return status == v1::CmdStatus::Success || status == v1::CmdStatus::InvalidArgument
+            || status == v1::CmdStatus::NotSupported || status == v1::CmdStatus::NotImplemented;
     }
 
     void submitCmdResult(v1::CmdResponse response, const char *context)
     {
-        timingLog(QStringLiteral("cmd.result.send context=%1 cmdId=%2 status=%3 error=%4")
+        if (isDefinitiveResult(response.status))
+            m_recentCommands.complete(response.id, response);
+        else
+            m_recentCommands.forget(response.id);
+        sendCmdResponse(response, context);
+    }
+
+    void sendCmdResponse(const v1::CmdResponse &response, const char *context)
+    {
+        if (timingLogEnabled()) {
+            timingLog(QStringLiteral("cmd.result.send context=%1 cmdId=%2 status=%3 error=%4")
+                          .arg(QString::fromLatin1(context))
+                          .arg(response.id)
+                          .arg(static_cast<int>(response.status))
+                          .arg(QString::fromStdString(response.error)));
+        }
+        if (kTraceEnabled) {
+            trace(QStringLiteral("result cmd context=%1 id=%2 status=%3 err=%4")
                       .arg(QString::fromLatin1(context))
                       .arg(response.id)
                       .arg(static_cast<int>(response.status))
                       .arg(QString::fromStdString(response.error)));
-        trace(QStringLiteral("result cmd context=%1 id=%2 status=%3 err=%4")
-                  .arg(QString::fromLatin1(context))
-                  .arg(response.id)
-                  .arg(static_cast<int>(response.status))
-                  .arg(QString::fromStdString(response.error)));
+        }
         v1::Utf8String err;
         if (!sendResult(response, &err))
             std::cerr << "failed to send " << context << " result: " << err << '\n';
@@ -2245,6 +7140,11 @@ private:
             std::cerr << "failed to send " << context << " result: " << err << '\n';
     }
 
+    inline static std::mutex s_registryMutex;
+    inline static std::unordered_map<std::string, OnkyoIpcInstance *> s_registry;
+
+    const std::string m_externalId;
+    std::unique_ptr<QObject> m_dispatchContext;
     v1::Adapter m_info;
     QJsonObject m_meta;
 
@@ -2260,6 +7160,8 @@ private:
     int m_volumeMaxRaw = 160;
 
     std::int64_t m_lastConnectLogMs = 0;
+    std::int64_t m_lastWriteMs = 0;
+    std::int64_t m_preemptRequestedMs = 0;
 
     QString m_lastConnectError;
     QString m_lastInputCode;
@@ -2272,13 +7174,77 @@ private:
     PowerState m_powerState = PowerState::Unknown;
     QHash<QString, QString> m_defaultInputLabelMap;
     QHash<QString, QString> m_inputLabelMap;
-    std::deque<PendingOperation> m_operationQueue;
+    OperationQueue m_operationQueue;
+    OperationPool m_operationPool;
+    std::array<std::optional<DeferredWrite>, kChannelIdCount> m_deferredWrites;
+    std::uint64_t m_deferredSeq = 0;
+    // Last kRecentCommandCapacity channel.invoke cmdIds; preallocated so new cmdIds do not allocate.
+    RecentCommands m_recentCommands;
+    CancellationToken m_operationToken;
     bool m_operationRunning = false;
+    bool m_effectStepRunning = false;
+    std::vector<std::function<void()>> m_deferredLifecycle;
     bool m_queuePumpScheduled = false;
     bool m_pollQueued = false;
     bool m_pollRunning = false;
+    std::optional<VolumeEffect> m_effect;
+    bool m_effectStepQueued = false;
+
+    KeepAliveSettings m_keepAlive;
+    TransportConfig m_transport;
+    int m_stateRecord = -1;
+    std::int64_t m_lastRttUs = -1;
+    LinkQualityStats m_linkQuality;
+    std::unique_ptr<QTimer> m_linkQualityTimer;
+    bool m_sessionLost = false;
+    int m_heartbeatIntervalMs = 0;
+    bool m_wakeOnLan = false;
+    QByteArray m_macAddress;
+    QHostAddress m_wolTarget{QHostAddress::Broadcast};
+    std::uint16_t m_wolPort = kWakeDefaultPort;
+    int m_wakeTimeoutMs = kWakeDefaultTimeoutMs;
+    WakeStats m_wakeStats;
+    std::unique_ptr<QUdpSocket> m_livenessSocket;
+    std::int64_t m_livenessReplyMs = 0;
+    std::int64_t m_livenessTcpMs = 0;
+    std::int64_t m_livenessTcpBackoffMs = 0;
+    int m_extendedIdleMs = 600000;
+    std::array<std::int64_t, kChannelIdCount> m_channelLastUseMs{};
+    QString m_signalInfoInput;
+    std::array<QByteArray, 2> m_signalInfoRaw;
+    bool m_signalInfoFresh = false;
+    std::unique_ptr<QTimer> m_signalInfoTimer;
+    BrowseCursor m_browse;
+    std::vector<TunerPreset> m_tunerPresets;
+    std::uint64_t m_linkEpoch = 0;
+    std::uint64_t m_presetListEpoch = 0;
+    int m_sessionIdleTimeoutMs = 60000;
+    std::unique_ptr<ControlSession> m_session;
+    bool m_sessionEstablished = false;
+    QString m_preferredHost;
+    std::function<void(HandoffRecord)> m_handoffCallback;
+    int m_ipcGraceMs = 30000;
+    bool m_ipcDown = false;
+    std::int64_t m_ipcGraceUntilMs = 0;
+    bool m_resumePending = false;
+    std::unique_ptr<QTimer> m_ipcGraceTimer;
+
+    // Last value and sequence number per channel, for delta resync.
+    struct JournalEntry
+    {
+        std::uint64_t seq = 0;
+        v1::ScalarValue value;
+    };
+    std::array<JournalEntry, kChannelIdCount> m_stateJournal;
+    std::uint64_t m_stateSeq = 0;
+    const std::int64_t m_stateEpoch = nowMs();
+    std::uint64_t m_ackedSeq = 0;
+    bool m_resyncNegotiated = false;
 
     std::unique_ptr<QTimer> m_pollTimer;
+    std::unique_ptr<QTimer> m_effectTimer;
+    std::unique_ptr<QTimer> m_heartbeatTimer;
+    std::unique_ptr<QTimer> m_sessionIdleTimer;
 };
 
 class OnkyoIpcFactory final : public sdk::AdapterFactory
@@ -2344,6 +7310,14 @@ protected:
         probe.metaJson = R"({"placement":"card","kind":"command","requiresAck":true})";
         caps.factoryActions.push_back(probe);
 
+        v1::AdapterActionDescriptor groupInvoke;
+        groupInvoke.id = "groupInvoke";
+        groupInvoke.label = "Group command";
+        groupInvoke.description = "Write one channel value on several receivers in parallel.";
+        groupInvoke.hasForm = false;
+        groupInvoke.metaJson = R"({"kind":"command","requiresAck":true})";
+        caps.factoryActions.push_back(groupInvoke);
+
         v1::AdapterActionDescriptor settings;
         settings.id = "settings";
         settings.label = "Settings";
@@ -2360,6 +7334,68 @@ protected:
         probeCurrent.metaJson = R"({"placement":"form_field","kind":"command","requiresAck":true})";
         caps.instanceActions.push_back(probeCurrent);
 
+        v1::AdapterActionDescriptor resync;
+        resync.id = "resync";
+        resync.label = "Resync state";
+        resync.description = "Re-emit channel states changed since the given sequence number.";
+        resync.hasForm = false;
+        resync.metaJson = R"({"kind":"command","requiresAck":true,"internal":true})";
+        caps.instanceActions.push_back(resync);
+
+        v1::AdapterActionDescriptor readChannel;
+        readChannel.id = "readChannel";
+        readChannel.label = "Read channel";
+        readChannel.description = "Return a channel value, querying the receiver if the channel is dormant.";
+        readChannel.hasForm = false;
+        readChannel.metaJson = R"({"kind":"command","requiresAck":true,"internal":true})";
+        caps.instanceActions.push_back(readChannel);
+
+        v1::AdapterActionDescriptor refreshSignalInfo;
+        refreshSignalInfo.id = "refreshSignalInfo";
+        refreshSignalInfo.label = "Refresh signal info";
+        refreshSignalInfo.description = "Query the incoming audio format and video resolution.";
+        refreshSignalInfo.hasForm = false;
+        refreshSignalInfo.metaJson = R"({"kind":"command","requiresAck":true})";
+        caps.instanceActions.push_back(refreshSignalInfo);
+
+        const std::array<std::array<const char *, 3>, 3> browseActions{{
+            {"netBrowseOpen", "Browse: open", "Open the current NET/USB list (param top: start at the NET menu)."},
+            {"netBrowsePage", "Browse: page", "Return one page of the open list (param page)."},
+            {"netBrowseSelect", "Browse: select", "Enter the item at param index, or go up with param back."},
+        }};
+        for (const auto &[id, label, description] : browseActions) {
+            v1::AdapterActionDescriptor browse;
+            browse.id = id;
+            browse.label = label;
+            browse.description = description;
+            browse.hasForm = false;
+            browse.metaJson = R"({"kind":"command","requiresAck":true})";
+            caps.instanceActions.push_back(browse);
+        }
+
+        v1::AdapterActionDescriptor deferredInvoke;
+        deferredInvoke.id = "deferredInvoke";
+        deferredInvoke.label = "Deferred write";
+        deferredInvoke.description = "Write param value to param channel now or on the next reconnect, within param ttlMs.";
+        deferredInvoke.hasForm = false;
+        deferredInvoke.metaJson = R"({"kind":"command","requiresAck":true})";
+        caps.instanceActions.push_back(deferredInvoke);
+
+        const std::array<std::array<const char *, 3>, 3> scheduleActions{{
+            {"scheduleAdd", "Schedule: add", "Write param value to param channel at param at/inMs/time (repeat: daily)."},
+            {"scheduleRemove", "Schedule: remove", "Remove the schedule entry with param id."},
+            {"scheduleList", "Schedule: list", "Return this receiver's schedule entries."},
+        }};
+        for (const auto &[id, label, description] : scheduleActions) {
+            v1::AdapterActionDescriptor schedule;
+            schedule.id = id;
+            schedule.label = label;
+            schedule.description = description;
+            schedule.hasForm = false;
+            schedule.metaJson = R"({"kind":"command","requiresAck":true})";
+            caps.instanceActions.push_back(schedule);
+        }
+
         return caps;
     }
 
@@ -2378,55 +7414,258 @@ protected:
     std::unique_ptr<sdk::AdapterInstance> createInstance(const sdk::ExternalId &externalId) override
     {
         std::cerr << "create onkyo instance externalId=" << externalId << '\n';
-        return std::make_unique<OnkyoIpcInstance>(m_schemaInputLabels);
+        return std::make_unique<OnkyoIpcInstance>(std::string(externalId), m_schemaInputLabels);
     }
 
     void onFactoryActionInvoke(const sdk::AdapterActionInvokeRequest &request) override
     {
-        submitFactoryActionResult(handleFactoryActionInvoke(request), "factory.action.invoke");
+        if (request.actionId == "groupInvoke") {
+            startGroupInvoke(request);
+            return;
+        }
+        if (request.actionId == "probe") {
+            startProbe(request);
+            return;
+        }
+        v1::ActionResponse resp;
+        resp.id = request.cmdId;
+        resp.tsMs = nowMs();
+        resp.status = v1::CmdStatus::NotSupported;
+        resp.error = "Factory action not supported";
+        submitFactoryActionResult(std::move(resp), "factory.action.invoke");
     }
 
 private:
-    v1::ActionResponse handleFactoryActionInvoke(const sdk::AdapterActionInvokeRequest &request)
+    struct GroupInvocation
     {
-        trace(QStringLiteral("factory action invoke id=%1 action=%2")
-                  .arg(request.cmdId)
-                  .arg(QString::fromStdString(request.actionId)));
+        decltype(v1::ActionResponse::id) cmdId{};
+        std::int64_t startedMs = 0;
+        std::vector<std::string> members;
+        std::unordered_map<std::string, GroupMemberResult> results;
+        bool completed = false;
+    };
+
+    void startGroupInvoke(const sdk::AdapterActionInvokeRequest &request)
+    {
+        constexpr int kDefaultGroupDeadlineMs = 5000;
+
+        const QJsonObject params = parseJsonObject(request.paramsJson);
+        auto invocation = std::make_shared<GroupInvocation>();
+        invocation->cmdId = request.cmdId;
+        invocation->startedMs = nowMs();
+        const QJsonArray ids = params.value(QStringLiteral("instanceIds")).toArray();
+        for (const QJsonValue &entry : ids) {
+            const std::string id = entry.toString().trimmed().toStdString();
+            if (!id.empty()
+                && std::find(invocation->members.begin(), invocation->members.end(), id) == invocation->members.end()) {
+                invocation->members.push_back(id);
+            }
+        }
+
+        GroupCommand command;
+        command.channelId = params.value(QStringLiteral("channel")).toString().trimmed().toStdString();
+        command.value = jsonToScalar(params.value(QStringLiteral("value")));
+        if (invocation->members.empty() || command.channelId.empty()
+            || std::holds_alternative<std::monostate>(command.value)) {
+            v1::ActionResponse resp;
+            resp.id = request.cmdId;
+            resp.tsMs = nowMs();
+            resp.status = v1::CmdStatus::InvalidArgument;
+            resp.error = "groupInvoke requires instanceIds, channel and value";
+            submitFactoryActionResult(std::move(resp), "factory.action.invoke");
+            return;
+        }
+
+        // The factory timeout bounds the whole group; members past the deadline are reported as timed out.
+        const int deadlineMs = qBound(500,
+                                      params.value(QStringLiteral("deadlineMs")).toInt(kDefaultGroupDeadlineMs),
+                                      timeoutMs() - 1000);
+        command.deadlineMs = invocation->startedMs + deadlineMs;
+        timingLog(QStringLiteral("group.start cmdId=%1 members=%2 channel=%3 deadlineMs=%4")
+                      .arg(request.cmdId)
+                      .arg(static_cast<int>(invocation->members.size()))
+                      .arg(QString::fromStdString(command.channelId))
+                      .arg(deadlineMs));
+
+        for (const std::string &id : invocation->members) {
+            const bool posted = OnkyoIpcInstance::postGroupCommand(
+                id,
+                command,
+                [this, invocation](GroupMemberResult result) {
+                    QMetaObject::invokeMethod(
+                        QCoreApplication::instance(),
+                        [this, invocation, result = std::move(result)]() mutable {
+                            collectGroupResult(invocation, std::move(result));
+                        },
+                        Qt::QueuedConnection);
+                });
+            if (!posted) {
+                GroupMemberResult result;
+                result.externalId = id;
+                result.status = v1::CmdStatus::NotSupported;
+                result.error = "Unknown instance";
+                invocation->results.emplace(id, std::move(result));
+            }
+        }
+
+        if (invocation->results.size() == invocation->members.size()) {
+            completeGroupInvoke(invocation);
+            return;
+        }
+        QTimer::singleShot(deadlineMs, QCoreApplication::instance(), [this, invocation]() {
+            completeGroupInvoke(invocation);
+        });
+    }
+
+    void collectGroupResult(const std::shared_ptr<GroupInvocation> &invocation, GroupMemberResult result)
+    {
+        if (invocation->completed)
+            return;
+        const std::string id = result.externalId;
+        invocation->results.insert_or_assign(id, std::move(result));
+        if (invocation->results.size() == invocation->members.size())
+            completeGroupInvoke(invocation);
+    }
+
+    void completeGroupInvoke(const std::shared_ptr<GroupInvocation> &invocation)
+    {
+        if (invocation->completed)
+            return;
+        invocation->completed = true;
+
+        QJsonArray members;
+        int failed = 0;
+        std::int64_t firstWriteMs = 0;
+        std::int64_t lastWriteMs = 0;
+        for (const std::string &id : invocation->members) {
+            QJsonObject member;
+            member.insert(QStringLiteral("instanceId"), QString::fromStdString(id));
+            auto it = invocation->results.find(id);
+            if (it == invocation->results.end()) {
+                ++failed;
+                member.insert(QStringLiteral("status"), static_cast<int>(v1::CmdStatus::TemporarilyOffline));
+                member.insert(QStringLiteral("error"), QStringLiteral("Group deadline exceeded"));
+                members.append(member);
+                continue;
+            }
+            const GroupMemberResult &result = it->second;
+            if (result.status != v1::CmdStatus::Success)
+                ++failed;
+            member.insert(QStringLiteral("status"), static_cast<int>(result.status));
+            if (!result.error.empty())
+                member.insert(QStringLiteral("error"), QString::fromStdString(result.error));
+            const QJsonValue finalValue = scalarToJson(result.finalValue);
+            if (!finalValue.isNull())
+                member.insert(QStringLiteral("finalValue"), finalValue);
+            if (result.writeMs > 0) {
+                member.insert(QStringLiteral("writeOffsetMs"), static_cast<double>(result.writeMs - invocation->startedMs));
+                firstWriteMs = (firstWriteMs == 0) ? result.writeMs : qMin(firstWriteMs, result.writeMs);
+                lastWriteMs = qMax(lastWriteMs, result.writeMs);
+            }
+            members.append(member);
+        }
+
+        const std::int64_t elapsedMs = nowMs() - invocation->startedMs;
+        const std::int64_t skewMs = (firstWriteMs > 0) ? (lastWriteMs - firstWriteMs) : 0;
+        timingLog(QStringLiteral("group.end cmdId=%1 members=%2 failed=%3 skewMs=%4 elapsedMs=%5")
+                      .arg(invocation->cmdId)
+                      .arg(static_cast<int>(invocation->members.size()))
+                      .arg(failed)
+                      .arg(skewMs)
+                      .arg(elapsedMs));
+
         v1::ActionResponse resp;
-        resp.id = request.cmdId;
+        resp.id = invocation->cmdId;
         resp.tsMs = nowMs();
+        resp.status = (failed == 0) ? v1::CmdStatus::Success : v1::CmdStatus::Failure;
+        if (failed > 0)
+            resp.error = QStringLiteral("%1 of %2 receivers failed")
+                             .arg(failed)
+                             .arg(static_cast<int>(invocation->members.size()))
+                             .toStdString();
+        resp.resultType = v1::ActionResultType::String;
+        resp.resultValue = toJson(QJsonObject{
+            {QStringLiteral("results"), members},
+            {QStringLiteral("failed"), failed},
+            {QStringLiteral("skewMs"), static_cast<double>(skewMs)},
+            {QStringLiteral("elapsedMs"), static_cast<double>(elapsedMs)},
+        });
+        submitFactoryActionResult(std::move(resp), "factory.action.invoke");
+    }
 
-        if (request.actionId != "probe") {
-            resp.status = v1::CmdStatus::NotSupported;
-            resp.error = "Factory action not supported";
-            return resp;
-        }
+    struct ProbeRequest
+    {
+        decltype(v1::ActionResponse::id) cmdId{};
+        std::uint16_t port = 0;
+        QStringList hosts;
+        QHash<QString, QString> addresses;
+        int pendingLookups = 0;
+    };
 
+    // Hostnames are looked up first without blocking the IPC loop; the answer goes out from the last lookup
+    // callback, so nothing re-enters the host's poll while a probe waits for DNS.
+    void startProbe(const sdk::AdapterActionInvokeRequest &request)
+    {
+        constexpr int kProbeResolveTimeoutMs = 2000;
+        trace(QStringLiteral("factory action invoke id=%1 action=%2")
+                  .arg(request.cmdId)
+                  .arg(QString::fromStdString(request.actionId)));
         const QJsonObject params = parseJsonObject(request.paramsJson);
-        const QStringList hosts = resolveProbeHosts(params);
-        const std::uint16_t port = resolveProbePort(params);
-        if (hosts.isEmpty() || port == 0) {
+        auto probe = std::make_shared<ProbeRequest>();
+        probe->cmdId = request.cmdId;
+        probe->hosts = resolveProbeHosts(params);
+        probe->port = resolveProbePort(params);
+        if (probe->hosts.isEmpty() || probe->port == 0) {
+            v1::ActionResponse resp;
+            resp.id = request.cmdId;
+            resp.tsMs = nowMs();
             resp.status = v1::CmdStatus::InvalidArgument;
             resp.error = "Probe requires host/ip and iscpPort";
-            return resp;
+            submitFactoryActionResult(std::move(resp), "factory.action.invoke");
+            return;
+        }
+
+        // One extra count until every lookup is started, as cached names call back right away.
+        probe->pendingLookups = 1;
+        for (const QString &host : std::as_const(probe->hosts)) {
+            QHostAddress literal;
+            if (literal.setAddress(host)) {
+                probe->addresses.insert(host, host);
+                continue;
+            }
+            ++probe->pendingLookups;
+            HostResolver::instance().resolveAsync(host, kProbeResolveTimeoutMs, [this, probe, host](const QStringList &addresses) {
+                probe->addresses.insert(host, addresses.isEmpty() ? QString() : addresses.front());
+                if (--probe->pendingLookups == 0)
+                    finishProbe(*probe);
+            });
         }
+        if (--probe->pendingLookups == 0)
+            finishProbe(*probe);
+    }
+
+    void finishProbe(const ProbeRequest &probe)
+    {
+        v1::ActionResponse resp;
+        resp.id = probe.cmdId;
+        resp.tsMs = nowMs();
 
         QString errorMessage;
         QString successfulHost;
-        for (const QString &host : hosts) {
+        for (const QString &host : probe.hosts) {
             QString hostError;
-            if (probeEndpoint(host, port, &hostError)) {
+            if (probeEndpoint(host, probe.addresses.value(host), probe.port, &hostError)) {
                 successfulHost = host;
                 break;
             }
             if (!hostError.isEmpty())
-                errorMessage = QStringLiteral("%1 (%2:%3)").arg(hostError, host).arg(port);
+                errorMessage = QStringLiteral("%1 (%2:%3)").arg(hostError, host).arg(probe.port);
         }
 
         if (!successfulHost.isEmpty()) {
             resp.status = v1::CmdStatus::Success;
             resp.resultType = v1::ActionResultType::String;
-            resp.resultValue = QStringLiteral("%1:%2").arg(successfulHost).arg(port).toStdString();
+            resp.resultValue = QStringLiteral("%1:%2").arg(successfulHost).arg(probe.port).toStdString();
         } else {
             resp.status = v1::CmdStatus::Failure;
             resp.error = errorMessage.isEmpty()
@@ -2434,7 +7673,7 @@ private:
                 : errorMessage.toStdString();
             resp.errorContext = "factory.action";
         }
-        return resp;
+        submitFactoryActionResult(std::move(resp), "factory.action.invoke");
     }
 
     void submitFactoryActionResult(v1::ActionResponse response, const char *context)
@@ -2449,6 +7688,137 @@ private:
 
 } // namespace
 
+#ifdef Q_OS_LINUX
+constexpr int kHandoffCollectTimeoutMs = 2000;
+constexpr int kHandoffReceiveTimeoutMs = 5000;
+constexpr int kHandoffClaimWindowMs = 60000;
+// `--takeover`: pulls sessions and state from the sidecar currently serving socketPath.
+// Must run before the new sidecar host starts; the old process stops its host before it answers `done`.
+int takeOverFromRunningSidecar(const QString &handoffPath)
+{
+    sockaddr_un address{};
+    if (!fillUnixAddress(handoffPath, &address))
+        return 0;
+    const int channel = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (channel < 0)
+        return 0;
+    if (::connect(channel, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        std::cerr << "takeover: no running sidecar at " << handoffPath.toStdString() << '\n';
+        ::close(channel);
+        return 0;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    int adopted = 0;
+    if (onkyo::sendHandoffMessage(channel, QJsonObject{{QStringLiteral("type"), QStringLiteral("takeover")}})) {
+        for (HandoffRecord &record : onkyo::receiveHandoffRecords(channel, kHandoffReceiveTimeoutMs)) {
+            record.expiresAtMs = nowMs() + kHandoffClaimWindowMs;
+            if (record.fd >= 0)
+                ++adopted;
+            HandoffStore::instance().put(std::move(record));
+        }
+    }
+    ::close(channel);
+    timingLog(QStringLiteral("handoff.takeover sessions=%1 elapsedMs=%2").arg(adopted).arg(timer.elapsed()));
+    return adopted;
+}
+
+// Listens on `<socketPath>.handoff` so a newer sidecar started with `--takeover` can replace this one.
+// Only peers running as the same user are served, and a path another sidecar still listens on is not taken.
+class HandoffServer
+{
+public:
+    HandoffServer(std::function<void()> stopHost, std::function<void()> quit)
+        : m_stopHost(std::move(stopHost))
+        , m_quit(std::move(quit))
+    {
+    }
+
+    ~HandoffServer()
+    {
+        closeListener();
+    }
+
+    bool listen(const QString &path)
+    {
+        sockaddr_un address{};
+        if (!fillUnixAddress(path, &address))
+            return false;
+        if (!onkyo::releaseStaleSocketPath(path, SOCK_SEQPACKET))
+            return false;
+        m_listenFd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (m_listenFd < 0)
+            return false;
+        if (::bind(m_listenFd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0
+            || ::listen(m_listenFd, 1) != 0) {
+            ::close(m_listenFd);
+            m_listenFd = -1;
+            return false;
+        }
+        m_path = path;
+        m_notifier = std::make_unique<QSocketNotifier>(m_listenFd, QSocketNotifier::Read);
+        QObject::connect(m_notifier.get(), &QSocketNotifier::activated, [this]() { onIncoming(); });
+        return true;
+    }
+
+private:
+    void closeListener()
+    {
+        // Called from the notifier's own activated handler; it goes once that handler returned.
+        if (m_notifier) {
+            m_notifier->setEnabled(false);
+            m_notifier.release()->deleteLater();
+        }
+        if (m_listenFd < 0)
+            return;
+        ::close(m_listenFd);
+        m_listenFd = -1;
+        // Unlinked before the successor binds the same path, never after.
+        ::unlink(QFile::encodeName(m_path).constData());
+    }
+
+    void onIncoming()
+    {
+        const int channel = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (channel < 0)
+            return;
+        if (!onkyo::peerIsSameUser(channel)) {
+            std::cerr << "handoff: refused a peer running as another user\n";
+            ::close(channel);
+            return;
+        }
+        QJsonObject request;
+        int fd = -1;
+        if (!onkyo::receiveHandoffMessage(channel, 1000, &request, &fd)
+            || request.value(QStringLiteral("type")).toString() != QLatin1String("takeover")) {
+            closeHandoffDescriptor(fd);
+            ::close(channel);
+            return;
+        }
+
+        timingLog(QStringLiteral("handoff.start"));
+        closeListener();
+        OnkyoIpcInstance::collectHandoff(kHandoffCollectTimeoutMs, [this, channel](std::vector<HandoffRecord> records) {
+            onkyo::sendHandoffRecords(channel, records);
+            for (const HandoffRecord &record : records)
+                closeHandoffDescriptor(record.fd);
+            m_stopHost();
+            onkyo::sendHandoffDone(channel);
+            ::close(channel);
+            timingLog(QStringLiteral("handoff.done instances=%1").arg(records.size()));
+            m_quit();
+        });
+    }
+
+    std::function<void()> m_stopHost;
+    std::function<void()> m_quit;
+    int m_listenFd = -1;
+    QString m_path;
+    std::unique_ptr<QSocketNotifier> m_notifier;
+};
+#endif
+
 int main(int argc, char **argv)
 {
     QCoreApplication app(argc, argv);
@@ -2456,13 +7826,28 @@ int main(int argc, char **argv)
     std::signal(SIGINT, handleSignal);
     std::signal(SIGTERM, handleSignal);
 
+    QStringList args = app.arguments();
+    const bool takeover = args.removeAll(QStringLiteral("--takeover")) > 0;
     const char *envSocketPath = std::getenv("PHI_ADAPTER_SOCKET_PATH");
-    const v1::Utf8String socketPath = (argc > 1)
-        ? argv[1]
+    const v1::Utf8String socketPath = (args.size() > 1)
+        ? args.at(1).toStdString()
         : (envSocketPath ? envSocketPath : v1::Utf8String("/tmp/phi-adapter-onkyo-ipc.sock"));
 
     std::cerr << "starting phi_adapter_onkyo_ipc for pluginType=" << kPluginType
-              << " socket=" << socketPath << '\n';
+              << " socket=" << socketPath << (takeover ? " takeover=1" : "") << '\n';
+
+#ifdef Q_OS_LINUX
+    const QString handoffPath = QString::fromStdString(socketPath) + QStringLiteral(".handoff");
+    if (takeover && takeOverFromRunningSidecar(handoffPath) > 0)
+        HandoffStore::scheduleExpiry(kHandoffClaimWindowMs);
+#else
+    if (takeover)
+        std::cerr << "takeover is not supported on this platform\n";
+#endif
+
+    const QString schedulePath = qEnvironmentVariable("PHI_ONKYO_SCHEDULE_FILE",
+                                                      QString::fromStdString(socketPath) + QStringLiteral(".schedule.json"));
+    CommandScheduler::instance().start(schedulePath, &OnkyoIpcInstance::postGroupCommand);
 
     OnkyoIpcFactory factory;
     sdk::SidecarHost host(socketPath, factory);
@@ -2472,6 +7857,27 @@ int main(int argc, char **argv)
         std::cerr << "failed to start sidecar host: " << error << '\n';
         return 1;
     }
+    bool hostStopped = false;
+
+#ifdef Q_OS_LINUX
+    // Being replaced is opt-in: PHI_ONKYO_HANDOFF=1, or a sidecar that took over itself.
+    HandoffServer handoffServer(
+        [&]() {
+            host.stop();
+            hostStopped = true;
+        },
+        [&]() { app.quit(); });
+    if ((takeover || qEnvironmentVariableIntValue("PHI_ONKYO_HANDOFF") == 1) && !handoffServer.listen(handoffPath))
+        std::cerr << "handoff listener unavailable at " << handoffPath.toStdString()
+                  << " (path missing, in use by a running sidecar, or not a socket)\n";
+
+    StateStreamServer stateStream;
+    const QString stateStreamPath = qEnvironmentVariable("PHI_ONKYO_STATE_STREAM").trimmed();
+    constexpr int kStateStreamTakeoverRetryMs = 10000;
+    if (!stateStreamPath.isEmpty() && !stateStream.listen(stateStreamPath, takeover ? kStateStreamTakeoverRetryMs : 0))
+        std::cerr << "state stream unavailable at " << stateStreamPath.toStdString()
+                  << " (in use by a running sidecar, or not a socket)\n";
+#endif
 
     constexpr std::chrono::milliseconds kPollTimeout{16};
 
@@ -2481,6 +7887,8 @@ int main(int argc, char **argv)
             app.quit();
             return;
         }
+        if (hostStopped)
+            return;
         if (!host.pollOnce(kPollTimeout, &error))
             std::cerr << "poll failed: " << error << '\n';
     });
@@ -2489,6 +7897,7 @@ int main(int argc, char **argv)
     const int execResult = app.exec();
     hostPollTimer.stop();
 
-    host.stop();
+    if (!hostStopped)
+        host.stop();
     return execResult;
 }
@@ -0,0 +1,67 @@
+#pragma once
+
+// Unix socket helpers shared by the local endpoints of the sidecar (handoff, state stream, unix transport).
+
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace onkyo {
+
+inline bool fillUnixAddress(const QString &path, sockaddr_un *address)
+{
+    const QByteArray encoded = QFile::encodeName(path);
+    if (encoded.size() >= static_cast<int>(sizeof(address->sun_path)))
+        return false;
+    std::memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    std::memcpy(address->sun_path, encoded.constData(), static_cast<std::size_t>(encoded.size()));
+    return true;
+}
+
+// Frees `path` for bind(): a socket nobody accepts on any more is unlinked, a live one is left alone.
+// False when the path is taken by a listening socket or by something that is not a socket.
+inline bool releaseStaleSocketPath(const QString &path, int type)
+{
+    sockaddr_un address{};
+    if (!fillUnixAddress(path, &address))
+        return false;
+    struct stat info{};
+    if (::lstat(address.sun_path, &info) != 0)
+        return errno == ENOENT;
+    if (!S_ISSOCK(info.st_mode))
+        return false;
+    const int probe = ::socket(AF_UNIX, type | SOCK_CLOEXEC, 0);
+    if (probe < 0)
+        return false;
+    const bool live = ::connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0
+        || errno == EAGAIN;
+    ::close(probe);
+    if (live)
+        return false;
+    return ::unlink(address.sun_path) == 0 || errno == ENOENT;
+}
+
+// True when the process at the other end of a connected Unix socket runs as this process's user.
+inline bool peerIsSameUser(int channel)
+{
+    ucred credentials{};
+    socklen_t length = sizeof(credentials);
+    if (::getsockopt(channel, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0 || length != sizeof(credentials))
+        return false;
+    return credentials.uid == ::getuid();
+}
+
+} // namespace onkyo
+#endif
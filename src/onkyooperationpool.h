@@ -0,0 +1,65 @@
+#pragma once
+
+// Spare nodes for a std::list based operation queue.
+//
+// Nodes leaving the queue are spliced into the pool instead of being freed, and new entries are spliced back
+// out of it, so once the pool is warm queueing and finishing operations allocates nothing. The pool keeps at
+// most Capacity spare nodes; a burst beyond that frees its surplus as the queue drains.
+
+#include <cstddef>
+#include <iterator>
+#include <list>
+
+namespace onkyo {
+
+template <typename T, std::size_t Capacity>
+class OperationPool
+{
+    static_assert(Capacity > 0, "pool needs at least one node");
+
+public:
+    using List = std::list<T>;
+
+    // Inserts a node before `pos` of `queue`, reusing a spare one when available. A reused node keeps
+    // whatever release() left in it.
+    T &acquire(List &queue, typename List::iterator pos)
+    {
+        if (m_spare.empty())
+            return *queue.emplace(pos);
+        const auto node = m_spare.begin();
+        queue.splice(pos, m_spare, node);
+        return *node;
+    }
+
+    // Takes `it` out of `queue`, keeping the node as a spare if there is room. `reset` runs on kept nodes
+    // so they hold no resources while parked. Returns the iterator following `it`.
+    template <typename Reset>
+    typename List::iterator release(List &queue, typename List::iterator it, Reset &&reset)
+    {
+        if (m_spare.size() >= Capacity)
+            return queue.erase(it);
+        const auto next = std::next(it);
+        reset(*it);
+        m_spare.splice(m_spare.end(), queue, it);
+        return next;
+    }
+
+    // Moves the nodes of a discarded list into the pool as far as there is room; the rest is freed with `list`.
+    template <typename Reset>
+    void reclaim(List &list, Reset &&reset)
+    {
+        while (!list.empty() && m_spare.size() < Capacity) {
+            reset(list.front());
+            m_spare.splice(m_spare.end(), list, list.begin());
+        }
+    }
+
+    std::size_t spare() const { return m_spare.size(); }
+
+    static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+    List m_spare;
+};
+
+} // namespace onkyo
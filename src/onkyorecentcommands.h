@@ -0,0 +1,94 @@
+#pragma once
+
+// Fixed-size memory of recently seen command ids and their results, used to answer core retries.
+//
+// Entries live in a fixed array that is allocated once with the owner. Remembering a new id overwrites the
+// least recently used entry in place, so the steady state allocates nothing beyond what copying a response
+// into an existing slot needs. Every lookup refreshes the entry it finds: a core that keeps retrying one
+// command keeps its answer even while a stream of newer writes passes through.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace onkyo {
+
+template <typename Id, typename Response, std::size_t Capacity>
+class RecentCommandRing
+{
+    static_assert(Capacity > 0, "ring needs at least one entry");
+
+public:
+    struct Entry
+    {
+        Id id{};
+        bool used = false;
+        bool completed = false;
+        Response response{};
+        std::uint64_t lastUsed = 0;
+    };
+
+    // Entry remembered for `id`, or nullptr. A hit counts as a use.
+    Entry *find(Id id)
+    {
+        for (Entry &entry : m_entries) {
+            if (entry.used && entry.id == id) {
+                entry.lastUsed = ++m_clock;
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    // Remembers `id` as in flight, in a free slot or else in place of the least recently used entry.
+    void remember(Id id)
+    {
+        Entry *victim = &m_entries[0];
+        for (Entry &entry : m_entries) {
+            if (!entry.used) {
+                victim = &entry;
+                break;
+            }
+            if (entry.lastUsed < victim->lastUsed)
+                victim = &entry;
+        }
+        victim->id = id;
+        victim->used = true;
+        victim->completed = false;
+        victim->lastUsed = ++m_clock;
+    }
+
+    // Stores the result of an in-flight `id`. False when the id is unknown or already has a result.
+    bool complete(Id id, const Response &response)
+    {
+        Entry *entry = find(id);
+        if (!entry || entry->completed)
+            return false;
+        entry->response = response;
+        entry->completed = true;
+        return true;
+    }
+
+    // Drops `id`, so a retry runs the command again.
+    void forget(Id id)
+    {
+        if (Entry *entry = find(id))
+            entry->used = false;
+    }
+
+    // Drops every id; slot storage is kept for reuse.
+    void clear()
+    {
+        for (Entry &entry : m_entries)
+            entry.used = false;
+        m_clock = 0;
+    }
+
+    static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+    std::array<Entry, Capacity> m_entries{};
+    std::uint64_t m_clock = 0;
+};
+
+} // namespace onkyo
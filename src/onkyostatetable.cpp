@@ -0,0 +1,405 @@
+#include "onkyostatetable.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define ONKYO_STATETABLE_POSIX 1
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace onkyo::statetable {
+
+namespace {
+
+constexpr int kClaimAttempts = 4;
+constexpr int kWriteSpinLimit = 1 << 16;
+constexpr int kWriteSpinBeforeYield = 64;
+
+std::mutex s_acquireMutex;
+
+void setError(std::string *error, const char *what)
+{
+    if (!error)
+        return;
+    *error = what;
+    if (errno != 0) {
+        *error += ": ";
+        *error += std::strerror(errno);
+    }
+}
+
+// Returns true when `text` did not fit; it is then cut before a UTF-8 continuation byte.
+bool copyText(char *target, std::size_t capacity, std::string_view text)
+{
+    std::size_t length = std::min(text.size(), capacity - 1);
+    const bool truncated = length < text.size();
+    while (truncated && length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0u) == 0x80u)
+        --length;
+    std::memcpy(target, text.data(), length);
+    std::memset(target + length, 0, capacity - length);
+    return truncated;
+}
+
+std::string_view recordId(const RecordData &data)
+{
+    return std::string_view(data.externalId, ::strnlen(data.externalId, kIdBytes));
+}
+
+// False for 0 and for pids without a process. A pid reused by an unrelated process counts as alive, which
+// only delays reclaiming the record.
+bool processAlive(std::int32_t pid)
+{
+#ifdef ONKYO_STATETABLE_POSIX
+    return pid > 0 && (::kill(pid, 0) == 0 || errno == EPERM);
+#else
+    return false;
+#endif
+}
+
+bool headerMatches(const Header &header)
+{
+    return header.magic == kMagic && header.version == kLayoutVersion && header.recordCapacity > 0
+        && header.recordCapacity <= kMaxRecordCapacity && header.recordSize == sizeof(Record);
+}
+
+#ifdef ONKYO_STATETABLE_POSIX
+// Record capacity of a valid region already in `fd` of `size` bytes, or 0.
+std::size_t existingCapacity(int fd, std::size_t size)
+{
+    if (size < sizeof(Header))
+        return 0;
+    void *base = ::mmap(nullptr, sizeof(Header), PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+        return 0;
+    const Header header = *static_cast<const Header *>(base);
+    ::munmap(base, sizeof(Header));
+    if (!headerMatches(header) || size < regionSize(header.recordCapacity))
+        return 0;
+    return header.recordCapacity;
+}
+#endif
+
+} // namespace
+
+Writer::~Writer()
+{
+#ifdef ONKYO_STATETABLE_POSIX
+    // The object is not unlinked: readers keep their mapping, and a successor process picks the table up.
+    if (m_header)
+        ::munmap(m_header, m_mappedBytes);
+#endif
+}
+
+bool Writer::open(const std::string &name, std::size_t recordCapacity, std::string *error)
+{
+#ifdef ONKYO_STATETABLE_POSIX
+    recordCapacity = std::clamp<std::size_t>(recordCapacity, 1, kMaxRecordCapacity);
+    errno = 0;
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        setError(error, "shm_open failed");
+        return false;
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0) {
+        setError(error, "sizing shared memory failed");
+        ::close(fd);
+        return false;
+    }
+    const std::size_t size = static_cast<std::size_t>(info.st_size);
+    const std::size_t existing = existingCapacity(fd, size);
+    const std::size_t capacity = std::max(existing, recordCapacity);
+    const std::size_t bytes = regionSize(capacity);
+    // Never shrunk: readers of the current region keep their mapping. Grown records read as zero.
+    if (size < bytes && ::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        setError(error, "sizing shared memory failed");
+        ::close(fd);
+        return false;
+    }
+    void *base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        setError(error, "mmap failed");
+        return false;
+    }
+    m_header = static_cast<Header *>(base);
+    m_pid = static_cast<std::int32_t>(::getpid());
+    m_records = reinterpret_cast<Record *>(static_cast<char *>(base) + sizeof(Header));
+    m_capacity = capacity;
+    m_mappedBytes = bytes;
+    if (existing == 0) {
+        // Fresh object or an older layout: readers see the new version only once every record is clean.
+        m_header->magic = 0;
+        std::memset(static_cast<void *>(m_records), 0, capacity * sizeof(Record));
+        m_header->version = kLayoutVersion;
+        m_header->recordCapacity = static_cast<std::uint32_t>(capacity);
+        m_header->recordSize = sizeof(Record);
+        m_header->createdMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  std::chrono::system_clock::now().time_since_epoch())
+                                  .count();
+        std::atomic_thread_fence(std::memory_order_release);
+        m_header->magic = kMagic;
+    } else if (existing < capacity) {
+        // Readers opened before keep using the first `existing` records.
+        std::atomic_thread_fence(std::memory_order_release);
+        m_header->recordCapacity = static_cast<std::uint32_t>(capacity);
+    }
+    return true;
+#else
+    (void)name;
+    (void)recordCapacity;
+    if (error)
+        *error = "shared memory state table needs POSIX shm";
+    return false;
+#endif
+}
+
+int Writer::acquireRecord(std::string_view externalId)
+{
+    if (!m_header || externalId.empty())
+        return -1;
+    std::lock_guard<std::mutex> lock(s_acquireMutex);
+    // Another process can claim a record between the scan and the claim; losing that race rescans.
+    for (int attempt = 0; attempt < kClaimAttempts; ++attempt) {
+        int index = -1;
+        int freeIndex = -1;
+        for (std::size_t i = 0; i < m_capacity; ++i) {
+            const Record &candidate = m_records[i];
+            if (candidate.data.inUse != 0 && recordId(candidate.data) == externalId) {
+                index = static_cast<int>(i);
+                break;
+            }
+            const std::int32_t owner = candidate.owner.load(std::memory_order_acquire);
+            if (freeIndex < 0 && owner != m_pid && !processAlive(owner))
+                freeIndex = static_cast<int>(i);
+        }
+        const bool matched = index >= 0;
+        if (!matched)
+            index = freeIndex;
+        if (index < 0)
+            return -1;
+
+        Record &target = m_records[index];
+        const std::int32_t previousOwner = target.owner.load(std::memory_order_acquire);
+        bool torn = false;
+        if (previousOwner != m_pid && !claim(target, previousOwner, &torn))
+            continue;
+        std::uint32_t sequence = 0;
+        if (!beginWrite(target, &sequence))
+            return -1;
+        if (!matched || torn) {
+            std::memset(static_cast<void *>(&target.data), 0, sizeof(RecordData));
+            copyText(target.data.externalId, kIdBytes, externalId);
+        }
+        target.data.inUse = 1;
+        endWrite(target, sequence);
+        return index;
+    }
+    return -1;
+}
+
+void Writer::releaseRecord(int index)
+{
+    Record *target = record(index);
+    if (!target)
+        return;
+    std::lock_guard<std::mutex> lock(s_acquireMutex);
+    std::uint32_t sequence = 0;
+    // A record another process has taken over stays with it.
+    if (!beginWrite(*target, &sequence))
+        return;
+    target->data.inUse = 0;
+    target->data.connectivity = 0;
+    endWrite(*target, sequence);
+    std::int32_t expected = m_pid;
+    target->owner.compare_exchange_strong(expected, 0, std::memory_order_acq_rel);
+}
+
+void Writer::publishChannel(int index,
+                            std::size_t slot,
+                            std::string_view name,
+                            const ChannelValue &value,
+                            std::int64_t tsMs)
+{
+    Record *target = record(index);
+    std::uint32_t sequence = 0;
+    if (!target || slot >= kChannelCapacity || !beginWrite(*target, &sequence))
+        return;
+    RecordData &data = target->data;
+    ChannelSlot &channel = data.channels[slot];
+    copyText(channel.name, kNameBytes, name);
+    channel.type = value.type;
+    channel.intValue = value.type == ValueType::Bool ? (value.boolValue ? 1 : 0) : value.intValue;
+    channel.doubleValue = value.doubleValue;
+    channel.updatedMs = tsMs;
+    channel.flags = copyText(channel.text, kTextBytes, value.text) ? kSlotTextTruncated : 0;
+    data.channelCount = std::max<std::uint32_t>(data.channelCount, static_cast<std::uint32_t>(slot + 1));
+    data.updatedMs = tsMs;
+    ++data.writeCount;
+    endWrite(*target, sequence);
+}
+
+void Writer::publishLink(int index, std::int32_t connectivity, std::int64_t rttUs, std::int64_t tsMs)
+{
+    Record *target = record(index);
+    std::uint32_t sequence = 0;
+    if (!target || !beginWrite(*target, &sequence))
+        return;
+    target->data.connectivity = connectivity;
+    if (rttUs >= 0)
+        target->data.rttUs = rttUs;
+    target->data.updatedMs = tsMs;
+    ++target->data.writeCount;
+    endWrite(*target, sequence);
+}
+
+Record *Writer::record(int index) const
+{
+    if (!m_header || index < 0 || static_cast<std::size_t>(index) >= m_capacity)
+        return nullptr;
+    return &m_records[index];
+}
+
+// Takes the record from `previousOwner`. A dead owner may have stopped inside a write; its odd sequence is
+// made even again, or readers and every later write would wait on it forever, and *torn tells the caller
+// to clear the half-written data.
+bool Writer::claim(Record &record, std::int32_t previousOwner, bool *torn)
+{
+    std::int32_t expected = previousOwner;
+    if (!record.owner.compare_exchange_strong(expected, m_pid, std::memory_order_acq_rel))
+        return false;
+    if (!processAlive(previousOwner)) {
+        std::uint32_t sequence = record.sequence.load(std::memory_order_acquire);
+        if (sequence & 1u)
+            *torn = record.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acq_rel);
+    }
+    return true;
+}
+
+// Enters a write only from an even sequence, so writers of two processes exclude each other. False once
+// another process owns the record; `*sequence` is the odd value to hand to endWrite.
+bool Writer::beginWrite(Record &record, std::uint32_t *sequence) const
+{
+    for (int spin = 0; spin < kWriteSpinLimit; ++spin) {
+        std::uint32_t current = record.sequence.load(std::memory_order_relaxed);
+        if ((current & 1u) == 0
+            && record.sequence.compare_exchange_weak(current, current + 1, std::memory_order_acquire,
+                                                     std::memory_order_relaxed)) {
+            std::atomic_thread_fence(std::memory_order_release);
+            if (record.owner.load(std::memory_order_acquire) == m_pid) {
+                *sequence = current + 1;
+                return true;
+            }
+            endWrite(record, current + 1);
+            return false;
+        }
+        if (spin >= kWriteSpinBeforeYield)
+            std::this_thread::yield();
+    }
+    return false;
+}
+
+void Writer::endWrite(Record &record, std::uint32_t sequence)
+{
+    // Fails only when a claim forced the sequence even meanwhile; then there is nothing left to close.
+    record.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_release,
+                                            std::memory_order_relaxed);
+}
+
+Reader::~Reader()
+{
+    close();
+}
+
+bool Reader::open(const std::string &name, std::string *error)
+{
+    close();
+#ifdef ONKYO_STATETABLE_POSIX
+    errno = 0;
+    const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        setError(error, "shm_open failed");
+        return false;
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+        setError(error, "shared memory too small");
+        ::close(fd);
+        return false;
+    }
+    const std::size_t capacity = existingCapacity(fd, static_cast<std::size_t>(info.st_size));
+    if (capacity == 0) {
+        errno = 0;
+        setError(error, "layout version mismatch");
+        ::close(fd);
+        return false;
+    }
+    const std::size_t bytes = regionSize(capacity);
+    void *base = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        setError(error, "mmap failed");
+        return false;
+    }
+    m_header = static_cast<const Header *>(base);
+    m_records = reinterpret_cast<const Record *>(static_cast<const char *>(base) + sizeof(Header));
+    m_capacity = capacity;
+    m_mappedBytes = bytes;
+    return true;
+#else
+    (void)name;
+    if (error)
+        *error = "shared memory state table needs POSIX shm";
+    return false;
+#endif
+}
+
+void Reader::close()
+{
+#ifdef ONKYO_STATETABLE_POSIX
+    if (m_header)
+        ::munmap(const_cast<Header *>(m_header), m_mappedBytes);
+#endif
+    m_header = nullptr;
+    m_records = nullptr;
+    m_capacity = 0;
+    m_mappedBytes = 0;
+}
+
+bool Reader::read(std::size_t index, RecordData *out, int maxRetries) const
+{
+    if (!m_header || !out || index >= m_capacity)
+        return false;
+    const Record &source = m_records[index];
+    for (int attempt = 0; attempt < maxRetries; ++attempt) {
+        const std::uint32_t before = source.sequence.load(std::memory_order_acquire);
+        if (before & 1u)
+            continue;
+        std::memcpy(static_cast<void *>(out), static_cast<const void *>(&source.data), sizeof(RecordData));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (source.sequence.load(std::memory_order_relaxed) == before)
+            return out->inUse != 0;
+    }
+    return false;
+}
+
+int Reader::find(std::string_view externalId) const
+{
+    RecordData data;
+    for (std::size_t i = 0; i < capacity(); ++i) {
+        if (read(i, &data) && std::string_view(data.externalId, ::strnlen(data.externalId, kIdBytes)) == externalId)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+} // namespace onkyo::statetable
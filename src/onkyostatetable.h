@@ -0,0 +1,173 @@
+#pragma once
+
+// Shared-memory table of per-instance receiver state, published by the sidecar for local readers.
+//
+// The region is a Header followed by `recordCapacity` fixed-size Records. Each record has its own seqlock:
+// the writer makes `sequence` odd, updates `data`, then makes it even again. Readers copy `data` and retry
+// while the sequence is odd or changed during the copy, so they never block the writer and never cause
+// receiver traffic.
+//
+// A record belongs to the process whose pid is in `owner`; it is claimed with a compare-and-swap, so during
+// a `--takeover` upgrade the new sidecar takes its records over and the old one stops writing them. Entering
+// a write is a compare-and-swap from an even sequence as well, so two processes never write at once, and a
+// record whose owner died mid-write has its sequence made even again when it is claimed.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace onkyo::statetable {
+
+constexpr std::uint32_t kMagic = 0x4F4E4B53; // "ONKS"
+constexpr std::uint32_t kLayoutVersion = 2;
+constexpr std::size_t kDefaultRecordCapacity = 32;
+constexpr std::size_t kMaxRecordCapacity = 1024;
+constexpr std::size_t kChannelCapacity = 32;
+constexpr std::size_t kIdBytes = 64;
+constexpr std::size_t kNameBytes = 32;
+constexpr std::size_t kTextBytes = 256;
+
+// ChannelSlot::flags: `text` holds only the start of a longer value (a cut JSON text is not valid JSON).
+constexpr std::uint8_t kSlotTextTruncated = 0x01;
+
+enum class ValueType : std::uint8_t {
+    None,
+    Bool,
+    Int,
+    Double,
+    String,
+};
+
+struct ChannelSlot
+{
+    char name[kNameBytes];
+    ValueType type;
+    std::uint8_t flags;
+    std::uint8_t reserved[6];
+    std::int64_t intValue;
+    double doubleValue;
+    std::int64_t updatedMs;
+    char text[kTextBytes];
+};
+
+// Plain copy of one record as seen by a reader. Strings are NUL-terminated; longer values are cut at a UTF-8
+// boundary and a cut channel text is flagged with kSlotTextTruncated.
+struct RecordData
+{
+    std::uint32_t inUse;
+    std::int32_t connectivity;
+    std::int64_t rttUs;
+    std::int64_t updatedMs;
+    std::uint64_t writeCount;
+    std::uint32_t channelCount;
+    std::uint32_t reserved;
+    char externalId[kIdBytes];
+    ChannelSlot channels[kChannelCapacity];
+};
+
+struct alignas(64) Record
+{
+    std::atomic<std::uint32_t> sequence;
+    // Pid of the writing process, 0 while free.
+    std::atomic<std::int32_t> owner;
+    RecordData data;
+};
+
+struct alignas(64) Header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t recordCapacity;
+    std::uint32_t recordSize;
+    // Wall-clock time (epoch ms) the region was initialized; a change tells readers the table was recreated.
+    std::uint64_t createdMs;
+};
+
+constexpr std::size_t regionSize(std::size_t recordCapacity)
+{
+    return sizeof(Header) + recordCapacity * sizeof(Record);
+}
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "seqlock needs a lock-free counter");
+static_assert(std::atomic<std::int32_t>::is_always_lock_free, "record claims need a lock-free owner");
+
+struct ChannelValue
+{
+    ValueType type = ValueType::None;
+    bool boolValue = false;
+    std::int64_t intValue = 0;
+    double doubleValue = 0.0;
+    std::string_view text;
+};
+
+// Owned by the sidecar. Every record has exactly one writing process; acquire/release are serialized
+// internally, and writes to a record another process has taken over are dropped.
+class Writer
+{
+public:
+    Writer() = default;
+    ~Writer();
+    Writer(const Writer &) = delete;
+    Writer &operator=(const Writer &) = delete;
+
+    // Creates or reuses the POSIX shared memory object `name` (e.g. "/phi-onkyo-state") with room for at least
+    // `recordCapacity` records. An existing region is grown when smaller, never shrunk, and one with another
+    // layout version is reinitialized.
+    bool open(const std::string &name, std::size_t recordCapacity = kDefaultRecordCapacity, std::string *error = nullptr);
+    bool isOpen() const { return m_header != nullptr; }
+    std::size_t capacity() const { return m_capacity; }
+    std::size_t mappedBytes() const { return m_mappedBytes; }
+
+    // Record of `externalId`, taken over from a previous process that published it, or a free one (also one
+    // whose owner died). -1 when the table is full.
+    int acquireRecord(std::string_view externalId);
+    void releaseRecord(int index);
+
+    void publishChannel(int index, std::size_t slot, std::string_view name, const ChannelValue &value, std::int64_t tsMs);
+    void publishLink(int index, std::int32_t connectivity, std::int64_t rttUs, std::int64_t tsMs);
+
+private:
+    Record *record(int index) const;
+    bool claim(Record &record, std::int32_t previousOwner, bool *torn);
+    bool beginWrite(Record &record, std::uint32_t *sequence) const;
+    static void endWrite(Record &record, std::uint32_t sequence);
+
+    Header *m_header = nullptr;
+    std::int32_t m_pid = 0;
+    Record *m_records = nullptr;
+    std::size_t m_capacity = 0;
+    std::size_t m_mappedBytes = 0;
+};
+
+// Read-only mapping for local consumers; reads never block the sidecar.
+class Reader
+{
+public:
+    Reader() = default;
+    ~Reader();
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    // Fails when the region is missing or was written with another layout version.
+    bool open(const std::string &name, std::string *error = nullptr);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+    std::size_t capacity() const { return m_capacity; }
+
+    // Consistent copy of record `index`. False for unused records, or when the writer kept the record busy
+    // for `maxRetries` attempts in a row.
+    bool read(std::size_t index, RecordData *out, int maxRetries = 64) const;
+
+    // Index of the record published for `externalId`, or -1.
+    int find(std::string_view externalId) const;
+
+private:
+    const Header *m_header = nullptr;
+    const Record *m_records = nullptr;
+    std::size_t m_capacity = 0;
+    std::size_t m_mappedBytes = 0;
+};
+
+} // namespace onkyo::statetable
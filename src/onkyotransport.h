@@ -0,0 +1,276 @@
+#pragma once
+
+// Receiver transports below the session: the eISCP (TCP) and raw ISCP (RS-232) framings, and the bridge that
+// turns a serial device or pty into a socket the session can use like a TCP connection.
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <optional>
+
+#include <QByteArray>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QString>
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace onkyo {
+
+// A raw ISCP line longer than this without a terminator is line noise and gets dropped.
+constexpr int kRawLineLimitBytes = 4096;
+
+// Wire framings. encode() wraps one command; extract() hands each complete payload in `data` to `sink` and
+// returns the number of leading bytes consumed, leaving an incomplete trailing frame for the next read.
+struct EiscpFraming
+{
+    // Unit type '1' addresses a receiver; discovery queries use 'x' (any device).
+    static QByteArray encode(const QByteArray &command, char unitType = '1')
+    {
+        const QByteArray payload = QByteArrayLiteral("!") + unitType + command + '\r';
+        const quint32 dataSize = static_cast<quint32>(payload.size());
+
+        QByteArray frame;
+        frame.append("ISCP", 4);
+        auto appendInt = [&frame](quint32 value) {
+            frame.append(static_cast<char>((value >> 24) & 0xFF));
+            frame.append(static_cast<char>((value >> 16) & 0xFF));
+            frame.append(static_cast<char>((value >> 8) & 0xFF));
+            frame.append(static_cast<char>(value & 0xFF));
+        };
+        appendInt(16);
+        appendInt(dataSize);
+        frame.append(char(1));
+        frame.append(QByteArray(3, '\0'));
+        frame.append(payload);
+        return frame;
+    }
+
+    template <typename Sink>
+    static int extract(const QByteArray &data, Sink &&sink)
+    {
+        int offset = 0;
+        while (offset + 16 <= data.size()) {
+            const int headerIndex = data.indexOf("ISCP", offset);
+            if (headerIndex < 0)
+                return qMax(offset, static_cast<int>(data.size()) - 3);
+            if (headerIndex + 16 > data.size())
+                return headerIndex;
+
+            const unsigned char *header =
+                reinterpret_cast<const unsigned char *>(data.constData() + headerIndex);
+            auto readInt = [](const unsigned char *ptr) -> quint32 {
+                return (static_cast<quint32>(ptr[0]) << 24)
+                    | (static_cast<quint32>(ptr[1]) << 16)
+                    | (static_cast<quint32>(ptr[2]) << 8)
+                    | static_cast<quint32>(ptr[3]);
+            };
+
+            const quint32 headerSize = readInt(header + 4);
+            const quint32 dataSize = readInt(header + 8);
+            const int frameSize = static_cast<int>(headerSize + dataSize);
+            if (headerIndex + frameSize > data.size())
+                return headerIndex;
+
+            sink(data.mid(headerIndex + static_cast<int>(headerSize), static_cast<int>(dataSize)));
+            offset = headerIndex + frameSize;
+        }
+        return offset;
+    }
+};
+
+// Plain ISCP as spoken on RS-232: "!1" + command + CR (or CR LF). Replies end in EOF (0x1A), CR and/or LF.
+template <bool Crlf>
+struct RawIscpFraming
+{
+    static QByteArray encode(const QByteArray &command)
+    {
+        return QByteArrayLiteral("!1") + command + (Crlf ? QByteArrayLiteral("\r\n") : QByteArrayLiteral("\r"));
+    }
+
+    template <typename Sink>
+    static int extract(const QByteArray &data, Sink &&sink)
+    {
+        int offset = 0;
+        for (int i = 0; i < data.size(); ++i) {
+            const char c = data.at(i);
+            if (c != '\r' && c != '\n' && c != '\x1a')
+                continue;
+            if (i > offset)
+                sink(data.mid(offset, i - offset));
+            offset = i + 1;
+        }
+        // A line noise run without terminator is dropped rather than buffered forever.
+        if (data.size() - offset > kRawLineLimitBytes)
+            return static_cast<int>(data.size());
+        return offset;
+    }
+};
+
+#ifdef Q_OS_LINUX
+// Baud rates the serial transport offers; anything else is rejected instead of falling back to 9600.
+constexpr std::array<int, 5> kSerialBaudRates{9600, 19200, 38400, 57600, 115200};
+
+inline std::optional<speed_t> termiosSpeed(int baudRate)
+{
+    switch (baudRate) {
+    case 9600:
+        return B9600;
+    case 19200:
+        return B19200;
+    case 38400:
+        return B38400;
+    case 57600:
+        return B57600;
+    case 115200:
+        return B115200;
+    default:
+        return std::nullopt;
+    }
+}
+
+// Relays a serial device or pty into one end of a socket pair, so the session keeps its QTcpSocket and all
+// socket based waits. Either side closing closes the other: the session sees an orderly remote close.
+class SerialBridge
+{
+public:
+    ~SerialBridge() { close(); }
+
+    // Returns the session end of the pair, or -1 with *error set.
+    int open(const QString &path, int baudRate, QString *error)
+    {
+        const std::optional<speed_t> speed = termiosSpeed(baudRate);
+        if (!speed) {
+            *error = QStringLiteral("Unsupported baud rate %1").arg(baudRate);
+            return -1;
+        }
+        m_deviceFd = ::open(QFile::encodeName(path).constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (m_deviceFd < 0) {
+            *error = QString::fromLocal8Bit(std::strerror(errno));
+            return -1;
+        }
+        termios tio{};
+        if (::tcgetattr(m_deviceFd, &tio) == 0) {
+            // 8N1 raw; a pty ignores the speed.
+            ::cfmakeraw(&tio);
+            ::cfsetspeed(&tio, *speed);
+            tio.c_cflag |= CLOCAL | CREAD;
+            tio.c_cc[VMIN] = 1;
+            tio.c_cc[VTIME] = 0;
+            ::tcsetattr(m_deviceFd, TCSANOW, &tio);
+            ::tcflush(m_deviceFd, TCIOFLUSH);
+        }
+        int pair[2] = {-1, -1};
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) != 0) {
+            *error = QString::fromLocal8Bit(std::strerror(errno));
+            close();
+            return -1;
+        }
+        m_relayFd = pair[1];
+        ::fcntl(m_relayFd, F_SETFL, ::fcntl(m_relayFd, F_GETFL) | O_NONBLOCK);
+        watch(m_toRelay, m_deviceFd, m_relayFd);
+        watch(m_toDevice, m_relayFd, m_deviceFd);
+        return pair[0];
+    }
+
+    // Safe from a notifier slot: the notifiers stop firing now and are deleted back in the event loop.
+    void close()
+    {
+        retire(m_toRelay);
+        retire(m_toDevice);
+        if (m_relayFd >= 0)
+            ::close(m_relayFd);
+        if (m_deviceFd >= 0)
+            ::close(m_deviceFd);
+        m_relayFd = -1;
+        m_deviceFd = -1;
+    }
+
+private:
+    // One direction of the relay. Bytes the sink does not take yet stay in pending; reading from the source
+    // pauses until the write notifier has drained them.
+    struct Direction
+    {
+        int from = -1;
+        int to = -1;
+        QByteArray pending;
+        std::unique_ptr<QSocketNotifier> readNotifier;
+        std::unique_ptr<QSocketNotifier> writeNotifier;
+    };
+
+    void watch(Direction &direction, int from, int to)
+    {
+        direction.from = from;
+        direction.to = to;
+        direction.readNotifier = std::make_unique<QSocketNotifier>(from, QSocketNotifier::Read);
+        QObject::connect(direction.readNotifier.get(), &QSocketNotifier::activated, [this, &direction]() {
+            pump(direction);
+        });
+        direction.writeNotifier = std::make_unique<QSocketNotifier>(to, QSocketNotifier::Write);
+        direction.writeNotifier->setEnabled(false);
+        QObject::connect(direction.writeNotifier.get(), &QSocketNotifier::activated, [this, &direction]() {
+            drain(direction);
+        });
+    }
+
+    static void retire(Direction &direction)
+    {
+        for (std::unique_ptr<QSocketNotifier> *notifier : {&direction.readNotifier, &direction.writeNotifier}) {
+            if (!*notifier)
+                continue;
+            (*notifier)->setEnabled(false);
+            notifier->release()->deleteLater();
+        }
+        direction.pending.clear();
+    }
+
+    void pump(Direction &direction)
+    {
+        char buffer[512];
+        const ssize_t n = ::read(direction.from, buffer, sizeof(buffer));
+        if (n < 0 && (errno == EAGAIN || errno == EINTR))
+            return;
+        if (n <= 0) {
+            // Unplugged adapter, closed pty master or session shut down.
+            close();
+            return;
+        }
+        direction.pending.append(buffer, static_cast<qsizetype>(n));
+        drain(direction);
+    }
+
+    void drain(Direction &direction)
+    {
+        while (!direction.pending.isEmpty()) {
+            const ssize_t w = ::write(direction.to, direction.pending.constData(),
+                                      static_cast<size_t>(direction.pending.size()));
+            if (w < 0 && errno == EINTR)
+                continue;
+            if (w < 0 && errno == EAGAIN)
+                break;
+            if (w <= 0) {
+                close();
+                return;
+            }
+            direction.pending.remove(0, static_cast<qsizetype>(w));
+        }
+        const bool blocked = !direction.pending.isEmpty();
+        direction.writeNotifier->setEnabled(blocked);
+        direction.readNotifier->setEnabled(!blocked);
+    }
+
+    int m_deviceFd = -1;
+    int m_relayFd = -1;
+    Direction m_toRelay;
+    Direction m_toDevice;
+};
+#endif
+
+} // namespace onkyo
@@ -0,0 +1,175 @@
+#pragma once
+
+// Cancellable waits for ISCP operations. Waits run a local event loop, so other events of the thread keep being
+// delivered while an operation waits; cancel() quits that loop at once, which is what bounds poll preemption.
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+
+#include <QAbstractSocket>
+#include <QDateTime>
+#include <QEventLoop>
+#include <QTimer>
+#include <QtGlobal>
+
+namespace onkyo {
+
+// Thrown out of a wait whose owner was destroyed by an event delivered during that wait. The frames between
+// the wait and the operation runner belong to the destroyed owner, so they must not run any further code.
+struct OperationAbandoned
+{
+};
+
+// Cancellation flag shared between an operation and whoever may abort it.
+// cancel() quits the event loop the operation is currently waiting in, so it takes effect immediately.
+class CancellationToken
+{
+public:
+    bool isCancelled() const
+    {
+        return m_state->cancelled;
+    }
+
+    bool isAbandoned() const
+    {
+        return m_state->abandoned;
+    }
+
+    void cancel() const
+    {
+        m_state->cancelled = true;
+        if (m_state->waiter)
+            m_state->waiter->quit();
+    }
+
+    // Cancels and makes the wait in progress throw OperationAbandoned instead of returning.
+    void abandon() const
+    {
+        m_state->abandoned = true;
+        cancel();
+    }
+
+    void setWaiter(QEventLoop *loop) const
+    {
+        m_state->waiter = loop;
+    }
+
+    // Runs `loop` as this token's waiter. A loop that returns at once because the thread is quitting counts
+    // as a cancellation; otherwise the caller would spin on exec() until its deadline.
+    void exec(QEventLoop &loop) const
+    {
+        setWaiter(&loop);
+        const int result = loop.exec();
+        setWaiter(nullptr);
+        if (m_state->abandoned)
+            throw OperationAbandoned{};
+        if (result < 0)
+            m_state->cancelled = true;
+    }
+
+private:
+    struct State
+    {
+        bool cancelled = false;
+        bool abandoned = false;
+        QEventLoop *waiter = nullptr;
+    };
+
+    std::shared_ptr<State> m_state = std::make_shared<State>();
+};
+
+struct OperationContext
+{
+    CancellationToken token;
+    std::int64_t deadlineMs = std::numeric_limits<std::int64_t>::max();
+
+    static OperationContext withTimeout(int timeoutMs)
+    {
+        OperationContext ctx;
+        ctx.deadlineMs = QDateTime::currentMSecsSinceEpoch() + timeoutMs;
+        return ctx;
+    }
+
+    bool isCancelled() const
+    {
+        return token.isCancelled();
+    }
+
+    bool expired() const
+    {
+        return QDateTime::currentMSecsSinceEpoch() >= deadlineMs;
+    }
+
+    // Deadline of a single step: its own timeout, capped by the operation deadline.
+    std::int64_t stepDeadline(int timeoutMs) const
+    {
+        return qMin(deadlineMs, QDateTime::currentMSecsSinceEpoch() + timeoutMs);
+    }
+};
+
+enum class WaitStatus {
+    Ready,
+    TimedOut,
+    Cancelled,
+    Closed,
+};
+
+inline int remainingTimerMs(std::int64_t remainingMs)
+{
+    return static_cast<int>(qMin<std::int64_t>(remainingMs, std::numeric_limits<int>::max()));
+}
+
+// Runs a local event loop until `ready()` holds, the socket closes, the deadline passes or the token
+// is cancelled. Other events of the thread (incoming invokes, timers) keep being delivered meanwhile.
+inline WaitStatus waitForSocket(QAbstractSocket &socket,
+                                const std::function<bool()> &ready,
+                                std::int64_t deadlineMs,
+                                const CancellationToken &token)
+{
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    QObject::connect(&socket, &QAbstractSocket::connected, &loop, &QEventLoop::quit);
+    QObject::connect(&socket, &QIODevice::readyRead, &loop, &QEventLoop::quit);
+    QObject::connect(&socket, &QAbstractSocket::stateChanged, &loop, &QEventLoop::quit);
+    QObject::connect(&socket, &QAbstractSocket::errorOccurred, &loop, &QEventLoop::quit);
+
+    for (;;) {
+        if (token.isCancelled())
+            return WaitStatus::Cancelled;
+        if (ready())
+            return WaitStatus::Ready;
+        if (socket.state() == QAbstractSocket::UnconnectedState)
+            return WaitStatus::Closed;
+        const std::int64_t remainingMs = deadlineMs - QDateTime::currentMSecsSinceEpoch();
+        if (remainingMs <= 0)
+            return WaitStatus::TimedOut;
+        timer.start(remainingTimerMs(remainingMs));
+        token.exec(loop);
+    }
+}
+
+// Sleeps until the deadline while other events of the thread keep being delivered. False when cancelled.
+inline bool waitUntil(std::int64_t deadlineMs, const CancellationToken &token)
+{
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&timer, &QTimer::timeout, &loop, &QEventLoop::quit);
+
+    while (!token.isCancelled()) {
+        const std::int64_t remainingMs = deadlineMs - QDateTime::currentMSecsSinceEpoch();
+        if (remainingMs <= 0)
+            return true;
+        timer.start(remainingTimerMs(remainingMs));
+        token.exec(loop);
+    }
+    return false;
+}
+
+} // namespace onkyo
@@ -0,0 +1,109 @@
+#pragma once
+
+// Wake-on-LAN helpers: MAC address parsing, the magic packet sent to a receiver in network standby and the
+// wake sequence that follows it until the control port accepts.
+
+#include <algorithm>
+#include <cstdint>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QRegularExpression>
+#include <QString>
+#include <QUdpSocket>
+
+#include "onkyowait.h"
+
+namespace onkyo {
+
+// Accepts "00:09:B0:12:34:56", "00-09-B0-12-34-56" and the bare hex digits ECN and NRI report.
+// Empty when malformed or all zero (what some firmware reports before its network module is up).
+inline QByteArray parseMacAddress(const QString &text)
+{
+    QString hex = text.trimmed();
+    hex.remove(QLatin1Char(':'));
+    hex.remove(QLatin1Char('-'));
+    static const QRegularExpression kMacRe(QStringLiteral("^[0-9A-Fa-f]{12}$"));
+    if (!kMacRe.match(hex).hasMatch())
+        return {};
+    const QByteArray mac = QByteArray::fromHex(hex.toLatin1());
+    if (mac == QByteArray(6, '\0'))
+        return {};
+    return mac;
+}
+
+inline QString formatMacAddress(const QByteArray &mac)
+{
+    return QString::fromLatin1(mac.toHex(':').toUpper());
+}
+
+// Six 0xFF bytes followed by the MAC sixteen times.
+inline QByteArray wakeOnLanPacket(const QByteArray &mac)
+{
+    QByteArray packet(6, '\xFF');
+    packet.reserve(6 + 16 * mac.size());
+    for (int i = 0; i < 16; ++i)
+        packet.append(mac);
+    return packet;
+}
+
+// The configured wolBroadcast address, or the limited broadcast address when it is empty or invalid.
+inline QHostAddress wakeOnLanTarget(const QString &broadcast)
+{
+    const QHostAddress target(broadcast.trimmed());
+    return target.isNull() ? QHostAddress(QHostAddress::Broadcast) : target;
+}
+
+// Sends one magic packet for `mac` to target:port. False when the datagram could not be sent.
+inline bool sendWakeOnLan(const QByteArray &mac, const QHostAddress &target, quint16 port)
+{
+    QUdpSocket socket;
+    return socket.writeDatagram(wakeOnLanPacket(mac), target, port) > 0;
+}
+
+struct WakeTiming
+{
+    int resendIntervalMs = 5000;
+    int backoffInitialMs = 250;
+    int backoffMaxMs = 2000;
+};
+
+struct WakeResult
+{
+    bool ready = false;
+    std::int64_t elapsedMs = 0;
+    int attempts = 0;
+};
+
+// Sends the magic packet through `sendPacket()`, repeating it every resendIntervalMs, and calls `tryConnect()`
+// with a backoff growing by half up to backoffMaxMs until it returns true, the deadline passes or the context
+// is cancelled. elapsedMs runs from the first packet to the accepted connection.
+template <typename SendPacket, typename TryConnect>
+WakeResult runWakeSequence(const OperationContext &ctx, const WakeTiming &timing, SendPacket &&sendPacket,
+                           TryConnect &&tryConnect)
+{
+    WakeResult result;
+    QElapsedTimer clock;
+    clock.start();
+    std::int64_t nextPacketMs = 0;
+    int backoffMs = timing.backoffInitialMs;
+    while (!ctx.isCancelled() && !ctx.expired()) {
+        if (clock.elapsed() >= nextPacketMs) {
+            sendPacket();
+            nextPacketMs = clock.elapsed() + timing.resendIntervalMs;
+        }
+        ++result.attempts;
+        if (tryConnect()) {
+            result.ready = true;
+            break;
+        }
+        if (!waitUntil(ctx.stepDeadline(backoffMs), ctx.token))
+            break;
+        backoffMs = std::min(backoffMs * 3 / 2, timing.backoffMaxMs);
+    }
+    result.elapsedMs = clock.elapsed();
+    return result;
+}
+
+} // namespace onkyo
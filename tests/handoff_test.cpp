@@ -0,0 +1,200 @@
+// Upgrade handoff: records exported on one end of a socketpair and imported on the other, with the receiver
+// socket passed along, plus the guards in front of the listener (peer user, live socket path).
+
+#include <cerrno>
+#include <csignal>
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "onkyohandoff.h"
+#include "onkyolocalsocket.h"
+
+namespace {
+
+// Both ends of a pipe standing in for a receiver TCP connection.
+struct Pipe
+{
+    int read = -1;
+    int write = -1;
+    ~Pipe()
+    {
+        onkyo::closeHandoffDescriptor(read);
+        onkyo::closeHandoffDescriptor(write);
+    }
+};
+
+} // namespace
+
+class HandoffTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init()
+    {
+        QCOMPARE(::socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, m_channel), 0);
+    }
+
+    void cleanup()
+    {
+        onkyo::closeHandoffDescriptor(m_channel[0]);
+        onkyo::closeHandoffDescriptor(m_channel[1]);
+    }
+
+    void exportsAndImportsRecords()
+    {
+        Pipe session;
+        int ends[2];
+        QCOMPARE(::pipe2(ends, O_CLOEXEC), 0);
+        session.read = ends[0];
+        session.write = ends[1];
+
+        std::vector<onkyo::HandoffRecord> exported(2);
+        exported[0].externalId = "receiver-1";
+        exported[0].state = QJsonObject{{QStringLiteral("power"), true}, {QStringLiteral("volume"), 42}};
+        exported[0].fd = session.read;
+        exported[1].externalId = "receiver-2";
+        exported[1].state = QJsonObject{{QStringLiteral("power"), false}};
+        QCOMPARE(onkyo::sendHandoffRecords(m_channel[0], exported), 2);
+        QVERIFY(onkyo::sendHandoffDone(m_channel[0]));
+
+        // The exporter closes its copies once sent; the imported descriptor must keep the session open.
+        onkyo::closeHandoffDescriptor(session.read);
+        session.read = -1;
+
+        std::vector<onkyo::HandoffRecord> imported = onkyo::receiveHandoffRecords(m_channel[1], 1000);
+        QCOMPARE(imported.size(), std::size_t(2));
+        QCOMPARE(imported[0].externalId, std::string("receiver-1"));
+        QCOMPARE(imported[0].state, exported[0].state);
+        QCOMPARE(imported[1].externalId, std::string("receiver-2"));
+        QCOMPARE(imported[1].state, exported[1].state);
+        QCOMPARE(imported[1].fd, -1);
+
+        QVERIFY(imported[0].fd >= 0);
+        QVERIFY(::fcntl(imported[0].fd, F_GETFD) & FD_CLOEXEC);
+        QCOMPARE(::write(session.write, "!1PWR01\r", 8), ssize_t(8));
+        char frame[8] = {};
+        QCOMPARE(::read(imported[0].fd, frame, sizeof(frame)), ssize_t(8));
+        QCOMPARE(QByteArray(frame, 8), QByteArray("!1PWR01\r"));
+        onkyo::closeHandoffDescriptor(imported[0].fd);
+    }
+
+    void stopsAtClosedChannel()
+    {
+        std::vector<onkyo::HandoffRecord> exported(1);
+        exported[0].externalId = "receiver-1";
+        QCOMPARE(onkyo::sendHandoffRecords(m_channel[0], exported), 1);
+        onkyo::closeHandoffDescriptor(m_channel[0]);
+        m_channel[0] = -1;
+
+        const std::vector<onkyo::HandoffRecord> imported = onkyo::receiveHandoffRecords(m_channel[1], 1000);
+        QCOMPARE(imported.size(), std::size_t(1));
+        QCOMPARE(imported[0].externalId, std::string("receiver-1"));
+    }
+
+    void closesSurplusDescriptors()
+    {
+        Pipe first;
+        Pipe second;
+        int ends[2];
+        QCOMPARE(::pipe2(ends, O_CLOEXEC), 0);
+        first.read = ends[0];
+        first.write = ends[1];
+        QCOMPARE(::pipe2(ends, O_CLOEXEC), 0);
+        second.read = ends[0];
+        second.write = ends[1];
+
+        // A hand-built message with two descriptors where the protocol allows one.
+        const QByteArray payload = QJsonDocument(QJsonObject{
+                                                     {QStringLiteral("type"), QStringLiteral("instance")},
+                                                     {QStringLiteral("externalId"), QStringLiteral("receiver-1")},
+                                                 })
+                                       .toJson(QJsonDocument::Compact);
+        iovec iov{const_cast<char *>(payload.constData()), static_cast<std::size_t>(payload.size())};
+        alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr *header = CMSG_FIRSTHDR(&msg);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(2 * sizeof(int));
+        const int descriptors[2] = {first.read, second.read};
+        std::memcpy(CMSG_DATA(header), descriptors, sizeof(descriptors));
+        QCOMPARE(::sendmsg(m_channel[0], &msg, MSG_NOSIGNAL), ssize_t(payload.size()));
+
+        // Drop the sender's copy of the surplus read end: once the receiver closes its copy, writes see EPIPE.
+        onkyo::closeHandoffDescriptor(second.read);
+        second.read = -1;
+
+        QJsonObject message;
+        int fd = -1;
+        QVERIFY(onkyo::receiveHandoffMessage(m_channel[1], 1000, &message, &fd));
+        QCOMPARE(message.value(QStringLiteral("externalId")).toString(), QStringLiteral("receiver-1"));
+        QVERIFY(fd >= 0);
+        onkyo::closeHandoffDescriptor(fd);
+
+        ::signal(SIGPIPE, SIG_IGN);
+        QCOMPARE(::write(second.write, "x", 1), ssize_t(-1));
+        QCOMPARE(errno, EPIPE);
+    }
+
+    void acceptsPeerOfSameUser()
+    {
+        QVERIFY(onkyo::peerIsSameUser(m_channel[0]));
+        QVERIFY(onkyo::peerIsSameUser(m_channel[1]));
+        QVERIFY(!onkyo::peerIsSameUser(-1));
+    }
+
+    void keepsLiveSocketPath()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath(QStringLiteral("sidecar.sock.handoff"));
+        sockaddr_un address{};
+        QVERIFY(onkyo::fillUnixAddress(path, &address));
+
+        const int listener = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        QVERIFY(listener >= 0);
+        QCOMPARE(::bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)), 0);
+        QCOMPARE(::listen(listener, 1), 0);
+
+        QVERIFY(!onkyo::releaseStaleSocketPath(path, SOCK_SEQPACKET));
+        QVERIFY(QFile::exists(path));
+
+        // The old sidecar is gone but left its path behind: that one may be reclaimed.
+        ::close(listener);
+        QVERIFY(QFile::exists(path));
+        QVERIFY(onkyo::releaseStaleSocketPath(path, SOCK_SEQPACKET));
+        QVERIFY(!QFile::exists(path));
+        QVERIFY(onkyo::releaseStaleSocketPath(path, SOCK_SEQPACKET));
+    }
+
+    void keepsPathThatIsNotSocket()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath(QStringLiteral("sidecar.sock.handoff"));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.close();
+
+        QVERIFY(!onkyo::releaseStaleSocketPath(path, SOCK_SEQPACKET));
+        QVERIFY(QFile::exists(path));
+    }
+
+private:
+    int m_channel[2] = {-1, -1};
+};
+
+QTEST_GUILESS_MAIN(HandoffTest)
+#include "handoff_test.moc"
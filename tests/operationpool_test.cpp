@@ -0,0 +1,160 @@
+// Checks the operation queue path: nodes taken from and returned to the pool, and that a warm queue carrying
+// channel writes runs without allocating, the way queueOperation/pumpQueue/recycleOperation drive it.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <variant>
+
+#include "onkyooperationpool.h"
+
+namespace {
+
+std::atomic<std::size_t> g_allocations{0};
+
+// Stand-ins for the sidecar's ChannelWrite and PendingOperation; the scalar matches the SDK's value variant.
+using ScalarValue = std::variant<std::monostate, bool, std::int64_t, double, std::string>;
+
+struct ChannelWrite
+{
+    std::uint64_t cmdId = 0;
+    int channel = 0;
+    ScalarValue value;
+};
+
+struct ActionRequest
+{
+    std::uint64_t cmdId = 0;
+    std::string actionId;
+};
+
+struct PendingOperation
+{
+    int kind = 0;
+    std::int64_t enqueuedMs = 0;
+    std::variant<std::monostate, ChannelWrite, ActionRequest> payload;
+};
+
+constexpr std::size_t kPoolSize = 32;
+using Pool = onkyo::OperationPool<PendingOperation, kPoolSize>;
+using Queue = Pool::List;
+
+void clearOperation(PendingOperation &op)
+{
+    op.payload = std::monostate{};
+}
+
+int g_failures = 0;
+
+void check(bool condition, const char *what)
+{
+    if (condition)
+        return;
+    std::fprintf(stderr, "FAIL: %s\n", what);
+    ++g_failures;
+}
+
+PendingOperation &queueOperation(Pool &pool, Queue &queue, int kind, bool front)
+{
+    PendingOperation &op = pool.acquire(queue, front ? queue.begin() : queue.end());
+    op.kind = kind;
+    op.enqueuedMs = 0;
+    return op;
+}
+
+// What pumpQueue does: move the head out, hand its node back, run it.
+PendingOperation takeOperation(Pool &pool, Queue &queue)
+{
+    PendingOperation op = std::move(queue.front());
+    pool.release(queue, queue.begin(), clearOperation);
+    return op;
+}
+
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+int main()
+{
+    Pool pool;
+    Queue queue;
+
+    queueOperation(pool, queue, 1, false);
+    queueOperation(pool, queue, 2, true);
+    check(queue.size() == 2 && queue.front().kind == 2 && queue.back().kind == 1, "front and back enqueue");
+    check(pool.spare() == 0, "cold pool has no spare nodes");
+
+    queue.front().payload = ActionRequest{7, "readChannel"};
+    const PendingOperation first = takeOperation(pool, queue);
+    check(first.kind == 2 && std::get<ActionRequest>(first.payload).cmdId == 7, "taken operation keeps its payload");
+    check(pool.spare() == 1 && queue.size() == 1, "finished node becomes a spare");
+    check(std::holds_alternative<std::monostate>(pool.acquire(queue, queue.end()).payload),
+          "reused node holds no payload");
+    check(pool.spare() == 0 && queue.size() == 2, "spare node is reused");
+
+    // A burst larger than the pool: the surplus is freed, the pool stays bounded.
+    for (int i = 0; i < 100; ++i)
+        queueOperation(pool, queue, 3, false);
+    for (auto it = queue.begin(); it != queue.end();)
+        it = pool.release(queue, it, clearOperation);
+    check(queue.empty(), "release returns the following node");
+    check(pool.spare() == Pool::capacity(), "pool keeps at most its capacity");
+
+    // A flushed queue gives its nodes back as far as there is room.
+    Queue flushed;
+    for (int i = 0; i < 4; ++i)
+        queueOperation(pool, queue, 4, false);
+    flushed.swap(queue);
+    pool.reclaim(flushed, clearOperation);
+    check(flushed.empty() && pool.spare() == Pool::capacity(), "reclaim refills the pool");
+
+    // Steady state: bursts of volume and mute writes from core, each queued, batched behind the first
+    // and recycled, with a poll in front now and then.
+    const std::size_t before = g_allocations.load();
+    std::uint64_t cmdId = 0;
+    std::int64_t checksum = 0;
+    for (int round = 0; round < 20000; ++round) {
+        if (round % 10 == 0)
+            queueOperation(pool, queue, 0, true);
+        for (int i = 0; i < 8; ++i) {
+            PendingOperation &op = queueOperation(pool, queue, 1, false);
+            ChannelWrite write;
+            write.cmdId = ++cmdId;
+            write.channel = i % 2;
+            write.value = (i % 2) ? ScalarValue(true) : ScalarValue(std::int64_t(40 + i));
+            op.payload = std::move(write);
+        }
+        while (!queue.empty()) {
+            PendingOperation op = takeOperation(pool, queue);
+            if (const auto *write = std::get_if<ChannelWrite>(&op.payload))
+                checksum += static_cast<std::int64_t>(write->cmdId);
+        }
+    }
+    const std::size_t steadyAllocations = g_allocations.load() - before;
+    check(checksum > 0, "writes ran");
+    check(steadyAllocations == 0, "steady-state queue/recycle does not allocate");
+    if (steadyAllocations != 0)
+        std::fprintf(stderr, "  %zu allocations for %llu writes\n", steadyAllocations,
+                     static_cast<unsigned long long>(cmdId));
+
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,101 @@
+// Checks that the recent-command ring answers retries, evicts the least recently used cmdId and that
+// remembering new cmdIds does not allocate once the ring is warm.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "onkyorecentcommands.h"
+
+namespace {
+
+std::atomic<std::size_t> g_allocations{0};
+
+struct Response
+{
+    std::uint64_t id = 0;
+    int status = 0;
+    std::string error;
+};
+
+using Ring = onkyo::RecentCommandRing<std::uint64_t, Response, 64>;
+
+int g_failures = 0;
+
+void check(bool condition, const char *what)
+{
+    if (condition)
+        return;
+    std::fprintf(stderr, "FAIL: %s\n", what);
+    ++g_failures;
+}
+
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+int main()
+{
+    // The ring's storage comes with its owner; here that is static storage.
+    static Ring storage;
+    Ring *ring = &storage;
+
+    ring->remember(1);
+    check(ring->find(1) && !ring->find(1)->completed, "new cmdId is in flight");
+    check(ring->complete(1, Response{1, 0, {}}), "in-flight cmdId takes its result");
+    check(!ring->complete(1, Response{1, 1, {}}), "result is stored once");
+    check(ring->find(1) && ring->find(1)->completed && ring->find(1)->response.status == 0, "result is kept");
+    check(!ring->complete(2, Response{2, 0, {}}), "unknown cmdId keeps no result");
+
+    ring->forget(1);
+    check(!ring->find(1), "forgotten cmdId runs again");
+
+    for (std::uint64_t id = 10; id < 10 + Ring::capacity(); ++id)
+        ring->remember(id);
+    ring->remember(1000);
+    check(!ring->find(10), "oldest cmdId is replaced when full");
+    check(ring->find(11) && ring->find(1000), "newer cmdIds stay");
+
+    // A retried cmdId is used again, so the next new cmdId replaces the least recently used one instead.
+    check(ring->find(11) != nullptr, "retried cmdId is found");
+    ring->remember(1001);
+    check(ring->find(11) && !ring->find(12), "least recently used cmdId is replaced, not the retried one");
+
+    ring->clear();
+    check(!ring->find(1000), "clear drops every cmdId");
+
+    // Steady state: a stream of new volume writes, each remembered, completed and eventually replaced.
+    const std::size_t before = g_allocations.load();
+    Response success;
+    for (std::uint64_t id = 1; id <= 100000; ++id) {
+        if (!ring->find(id))
+            ring->remember(id);
+        success.id = id;
+        ring->complete(id, success);
+    }
+    const std::size_t steadyAllocations = g_allocations.load() - before;
+    check(steadyAllocations == 0, "steady-state remember/complete does not allocate");
+    if (steadyAllocations != 0)
+        std::fprintf(stderr, "  %zu allocations for 100000 cmdIds\n", steadyAllocations);
+
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
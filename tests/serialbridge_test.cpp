@@ -0,0 +1,140 @@
+// Serial transport: raw ISCP framing on partial input and every terminator, and the bridge relaying a pty
+// (standing in for a USB serial adapter) to the socket the session reads.
+
+#include <QTcpSocket>
+#include <QTest>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <unistd.h>
+
+#include "onkyotransport.h"
+
+namespace {
+
+// Runs extract() the way the session does: append, extract, drop what was consumed.
+struct RawReader
+{
+    QByteArray buffer;
+    QList<QByteArray> payloads;
+
+    void feed(const QByteArray &bytes)
+    {
+        buffer.append(bytes);
+        const int consumed = onkyo::RawIscpFraming<false>::extract(
+            buffer, [this](const QByteArray &payload) { payloads.append(payload); });
+        buffer.remove(0, consumed);
+    }
+};
+
+} // namespace
+
+class SerialBridgeTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void keepsPartialFrameUntilTerminator()
+    {
+        RawReader reader;
+        reader.feed("!1PWR");
+        QVERIFY(reader.payloads.isEmpty());
+        QCOMPARE(reader.buffer, QByteArray("!1PWR"));
+        reader.feed("01");
+        QVERIFY(reader.payloads.isEmpty());
+        reader.feed("\x1a!1AM");
+        QCOMPARE(reader.payloads, QList<QByteArray>{"!1PWR01"});
+        QCOMPARE(reader.buffer, QByteArray("!1AM"));
+    }
+
+    void splitsOnEveryTerminator_data()
+    {
+        QTest::addColumn<QByteArray>("input");
+        QTest::newRow("cr") << QByteArray("!1PWR01\r!1AMT00\r");
+        QTest::newRow("crlf") << QByteArray("!1PWR01\r\n!1AMT00\r\n");
+        QTest::newRow("eof") << QByteArray("!1PWR01\x1a!1AMT00\x1a");
+        QTest::newRow("eof cr lf") << QByteArray("!1PWR01\x1a\r\n!1AMT00\x1a\r\n");
+        QTest::newRow("lf only") << QByteArray("!1PWR01\n!1AMT00\n");
+    }
+
+    void splitsOnEveryTerminator()
+    {
+        QFETCH(QByteArray, input);
+        RawReader reader;
+        reader.feed(input);
+        QCOMPARE(reader.payloads, (QList<QByteArray>{"!1PWR01", "!1AMT00"}));
+        QVERIFY(reader.buffer.isEmpty());
+    }
+
+    void dropsUnterminatedNoise()
+    {
+        RawReader reader;
+        reader.feed(QByteArray(onkyo::kRawLineLimitBytes + 1, 'x'));
+        QVERIFY(reader.payloads.isEmpty());
+        QVERIFY(reader.buffer.isEmpty());
+        reader.feed("!1PWR01\r");
+        QCOMPARE(reader.payloads, QList<QByteArray>{"!1PWR01"});
+    }
+
+    void encodesRawCommands()
+    {
+        QCOMPARE(onkyo::RawIscpFraming<false>::encode("PWRQSTN"), QByteArray("!1PWRQSTN\r"));
+        QCOMPARE(onkyo::RawIscpFraming<true>::encode("PWRQSTN"), QByteArray("!1PWRQSTN\r\n"));
+    }
+
+    void rejectsUnsupportedBaudRate()
+    {
+        QVERIFY(!onkyo::termiosSpeed(4800).has_value());
+        QVERIFY(onkyo::termiosSpeed(115200).has_value());
+        onkyo::SerialBridge bridge;
+        QString error;
+        QCOMPARE(bridge.open(QStringLiteral("/dev/null"), 4800, &error), -1);
+        QVERIFY(error.contains(QStringLiteral("4800")));
+    }
+
+    void relaysPtyBothWays()
+    {
+        int master = -1;
+        int slave = -1;
+        char name[128] = {};
+        QCOMPARE(::openpty(&master, &slave, name, nullptr, nullptr), 0);
+        // The bridge opens the device by path, as it would /dev/ttyUSB0.
+        ::close(slave);
+        ::fcntl(master, F_SETFL, ::fcntl(master, F_GETFL) | O_NONBLOCK);
+
+        onkyo::SerialBridge bridge;
+        QString error;
+        const int fd = bridge.open(QString::fromLocal8Bit(name), 9600, &error);
+        QVERIFY2(fd >= 0, qPrintable(error));
+        QTcpSocket session;
+        QVERIFY(session.setSocketDescriptor(fd, QAbstractSocket::ConnectedState, QIODevice::ReadWrite));
+
+        // Receiver to session, in pieces that split a frame.
+        RawReader reader;
+        QCOMPARE(::write(master, "!1PWR0", 6), ssize_t(6));
+        QTRY_COMPARE_WITH_TIMEOUT((reader.feed(session.readAll()), reader.buffer), QByteArray("!1PWR0"), 2000);
+        QCOMPARE(::write(master, "1\x1a\r\n!1MVL2A\x1a", 12), ssize_t(12));
+        QTRY_COMPARE_WITH_TIMEOUT((reader.feed(session.readAll()), reader.payloads.size()), 2, 2000);
+        QCOMPARE(reader.payloads, (QList<QByteArray>{"!1PWR01", "!1MVL2A"}));
+
+        // Session to receiver.
+        const QByteArray command = onkyo::RawIscpFraming<false>::encode("PWRQSTN");
+        QCOMPARE(session.write(command), qint64(command.size()));
+        QByteArray received;
+        auto readMaster = [&]() {
+            char buffer[64];
+            const ssize_t n = ::read(master, buffer, sizeof(buffer));
+            if (n > 0)
+                received.append(buffer, static_cast<qsizetype>(n));
+            return received;
+        };
+        QTRY_COMPARE_WITH_TIMEOUT(readMaster(), command, 2000);
+
+        // Unplugged adapter: the session sees an orderly close.
+        ::close(master);
+        QTRY_COMPARE_WITH_TIMEOUT(session.state(), QAbstractSocket::UnconnectedState, 2000);
+    }
+};
+
+QTEST_GUILESS_MAIN(SerialBridgeTest)
+#include "serialbridge_test.moc"
@@ -0,0 +1,294 @@
+// Stress test for the shared-memory state table: concurrent writers and readers in one process, a second
+// process taking a record over, and a writer that died inside a write.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "onkyostatetable.h"
+
+namespace {
+
+using namespace onkyo::statetable;
+
+constexpr std::size_t kSlotsPerWrite = 4;
+constexpr int kWritesPerWriter = 200000;
+
+int g_failures = 0;
+
+void check(bool condition, const char *what)
+{
+    if (condition)
+        return;
+    std::fprintf(stderr, "FAIL: %s\n", what);
+    ++g_failures;
+}
+
+// Every field a publish touches is derived from one counter, so a torn copy shows up as a mismatch.
+void publishGeneration(Writer &writer, int index, std::int64_t generation)
+{
+    const std::string text = "gen-" + std::to_string(generation);
+    for (std::size_t slot = 0; slot < kSlotsPerWrite; ++slot) {
+        ChannelValue value;
+        value.type = ValueType::String;
+        value.intValue = generation;
+        value.doubleValue = static_cast<double>(generation);
+        value.text = text;
+        writer.publishChannel(index, slot, "stress", value, generation);
+    }
+}
+
+// False when the copy mixes two generations.
+bool consistent(const RecordData &data)
+{
+    if (data.channelCount < kSlotsPerWrite)
+        return data.channelCount == 0;
+    std::int64_t newest = 0;
+    for (std::size_t slot = 0; slot < kSlotsPerWrite; ++slot) {
+        const ChannelSlot &channel = data.channels[slot];
+        if (channel.updatedMs != channel.intValue || channel.doubleValue != static_cast<double>(channel.intValue)
+            || std::string(channel.text) != "gen-" + std::to_string(channel.intValue))
+            return false;
+        // Slots are written in order, so a later slot never runs ahead of an earlier one.
+        if (slot > 0 && channel.intValue > data.channels[slot - 1].intValue)
+            return false;
+        newest = std::max(newest, channel.intValue);
+    }
+    return data.updatedMs == newest;
+}
+
+struct Mapping
+{
+    Header *header = nullptr;
+    Record *records = nullptr;
+    std::size_t bytes = 0;
+};
+
+Mapping mapRaw(const std::string &name, std::size_t capacity)
+{
+    Mapping mapping;
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return mapping;
+    mapping.bytes = regionSize(capacity);
+    void *base = ::mmap(nullptr, mapping.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+        return {};
+    mapping.header = static_cast<Header *>(base);
+    mapping.records = reinterpret_cast<Record *>(static_cast<char *>(base) + sizeof(Header));
+    return mapping;
+}
+
+void testConcurrentReaders(const std::string &name)
+{
+    Writer writer;
+    std::string error;
+    check(writer.open(name, 8, &error), "writer opens the table");
+    Reader reader;
+    check(reader.open(name, &error), "reader opens the table");
+
+    const int first = writer.acquireRecord("stress-a");
+    const int second = writer.acquireRecord("stress-b");
+    check(first >= 0 && second >= 0 && first != second, "two instances get their own records");
+
+    std::atomic<bool> done{false};
+    std::atomic<long> torn{0};
+    std::atomic<long> reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&, r]() {
+            RecordData data;
+            const int index = (r % 2 == 0) ? first : second;
+            while (!done.load(std::memory_order_relaxed)) {
+                if (!reader.read(static_cast<std::size_t>(index), &data))
+                    continue;
+                reads.fetch_add(1, std::memory_order_relaxed);
+                if (!consistent(data))
+                    torn.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    std::thread writerA([&]() {
+        for (int generation = 1; generation <= kWritesPerWriter; ++generation)
+            publishGeneration(writer, first, generation);
+    });
+    std::thread writerB([&]() {
+        for (int generation = 1; generation <= kWritesPerWriter; ++generation)
+            publishGeneration(writer, second, generation);
+    });
+    writerA.join();
+    writerB.join();
+    done.store(true);
+    for (std::thread &thread : readers)
+        thread.join();
+
+    check(reads.load() > 0, "readers got consistent copies while writers ran");
+    check(torn.load() == 0, "no reader saw a torn record");
+    RecordData data;
+    check(reader.read(static_cast<std::size_t>(first), &data) && data.channels[0].intValue == kWritesPerWriter,
+          "final generation is visible");
+    check(reader.find("stress-b") == second, "records are found by externalId");
+}
+
+void testTakeover(const std::string &name)
+{
+    Writer writer;
+    check(writer.open(name, 8), "old sidecar opens the table");
+    const int index = writer.acquireRecord("takeover");
+    publishGeneration(writer, index, 1);
+
+    int ready[2];
+    check(::pipe(ready) == 0, "pipe");
+    const pid_t child = ::fork();
+    if (child == 0) {
+        // New sidecar: takes the record over and keeps publishing while the old one still tries to.
+        Writer successor;
+        if (!successor.open(name, 8) || successor.acquireRecord("takeover") != index)
+            ::_exit(1);
+        char byte = 1;
+        if (::write(ready[1], &byte, 1) != 1)
+            ::_exit(1);
+        for (int generation = 1000000; generation < 1000000 + kWritesPerWriter / 4; ++generation)
+            publishGeneration(successor, index, generation);
+        ::_exit(0);
+    }
+    char byte = 0;
+    check(::read(ready[0], &byte, 1) == 1, "successor claimed the record");
+
+    Reader reader;
+    reader.open(name);
+    std::atomic<bool> done{false};
+    std::atomic<long> torn{0};
+    std::thread observer([&]() {
+        RecordData data;
+        while (!done.load(std::memory_order_relaxed)) {
+            if (reader.read(static_cast<std::size_t>(index), &data) && !consistent(data))
+                torn.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    // Dropped: the record belongs to the successor now.
+    for (int generation = 2; generation < 2 + kWritesPerWriter / 4; ++generation)
+        publishGeneration(writer, index, generation);
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    done.store(true);
+    observer.join();
+    ::close(ready[0]);
+    ::close(ready[1]);
+
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "successor ran to completion");
+    check(torn.load() == 0, "two processes never wrote the record at once");
+    RecordData data;
+    check(reader.read(static_cast<std::size_t>(index), &data) && data.channels[0].intValue >= 1000000,
+          "old sidecar stopped writing after the takeover");
+}
+
+void testDeadWriter(const std::string &name)
+{
+    const pid_t child = ::fork();
+    if (child == 0) {
+        // Dies between beginWrite and endWrite.
+        Writer writer;
+        if (!writer.open(name, 8))
+            ::_exit(1);
+        const int index = writer.acquireRecord("crashed");
+        publishGeneration(writer, index, 7);
+        Mapping mapping = mapRaw(name, 8);
+        if (!mapping.records)
+            ::_exit(1);
+        mapping.records[index].sequence.fetch_add(1);
+        std::strcpy(mapping.records[index].data.channels[0].text, "half-written");
+        ::_exit(0);
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "crashing writer set up its record");
+
+    Reader reader;
+    reader.open(name);
+    const Mapping mapping = mapRaw(name, 8);
+    int index = -1;
+    for (std::size_t i = 0; i < reader.capacity(); ++i) {
+        if (std::strncmp(mapping.records[i].data.externalId, "crashed", kIdBytes) == 0)
+            index = static_cast<int>(i);
+    }
+    check(index >= 0, "crashed record is in the table");
+    RecordData data;
+    check(!reader.read(static_cast<std::size_t>(index), &data, 8), "record is busy while its sequence is odd");
+
+    Writer writer;
+    writer.open(name, 8);
+    check(writer.acquireRecord("crashed") == index, "dead owner's record is claimed again");
+    check((mapping.records[index].sequence.load() & 1u) == 0, "claim makes the sequence even");
+    check(reader.read(static_cast<std::size_t>(index), &data), "record is readable after the claim");
+    check(data.channelCount == 0, "half-written data is cleared");
+    publishGeneration(writer, index, 8);
+    check(reader.read(static_cast<std::size_t>(index), &data) && consistent(data) && data.channels[0].intValue == 8,
+          "new owner publishes");
+    ::munmap(mapping.header, mapping.bytes);
+}
+
+void testLayout(const std::string &name)
+{
+    Writer small;
+    check(small.open(name, 2), "table opens with two records");
+    check(small.acquireRecord("one") >= 0 && small.acquireRecord("two") >= 0, "two records fit");
+    check(small.acquireRecord("three") < 0, "third record does not fit");
+
+    Writer larger;
+    check(larger.open(name, 4) && larger.capacity() == 4, "configured capacity grows the table");
+    check(larger.acquireRecord("three") >= 0, "grown table takes another record");
+    Writer smaller;
+    check(smaller.open(name, 1) && smaller.capacity() == 4, "table is never shrunk");
+
+    Reader reader;
+    check(reader.open(name) && reader.capacity() == 4, "reader takes the capacity from the header");
+    const Mapping mapping = mapRaw(name, 4);
+    check(mapping.header && mapping.header->createdMs > 0, "header records its creation time");
+
+    const std::string longText = std::string(kTextBytes - 2, 'x') + "\xC3\xA9" + "tail";
+    ChannelValue value;
+    value.type = ValueType::String;
+    value.text = longText;
+    const int index = larger.acquireRecord("three");
+    larger.publishChannel(index, 0, "audioSignal", value, 1);
+    value.text = "short";
+    larger.publishChannel(index, 1, "videoSignal", value, 1);
+    RecordData data;
+    check(reader.read(static_cast<std::size_t>(index), &data), "record with long text is readable");
+    check(data.channels[0].flags & kSlotTextTruncated, "cut text is flagged");
+    check(std::strlen(data.channels[0].text) == kTextBytes - 2, "text is cut before a split UTF-8 sequence");
+    check((data.channels[1].flags & kSlotTextTruncated) == 0, "text that fits is not flagged");
+    if (mapping.header)
+        ::munmap(mapping.header, mapping.bytes);
+}
+
+} // namespace
+
+int main()
+{
+    const std::string prefix = "/phi-onkyo-statetable-test-" + std::to_string(::getpid());
+    const std::string names[] = {prefix + "-a", prefix + "-b", prefix + "-c", prefix + "-d"};
+    for (const std::string &name : names)
+        ::shm_unlink(name.c_str());
+
+    testConcurrentReaders(names[0]);
+    testTakeover(names[1]);
+    testDeadWriter(names[2]);
+    testLayout(names[3]);
+
+    for (const std::string &name : names)
+        ::shm_unlink(name.c_str());
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
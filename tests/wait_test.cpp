@@ -0,0 +1,159 @@
+// Cancellable waits: a write preempting a poll that waits on a receiver which never replies, abandoned waits
+// and waits on a quitting thread.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+#include <QThread>
+
+#include "onkyowait.h"
+
+namespace {
+
+// Upper bound for the time between a write being handed over and the poll in front of it giving way.
+// The wait reacts on the next event, so this only leaves room for a loaded test machine.
+constexpr qint64 kPreemptBoundMs = 50;
+constexpr int kPollDeadlineMs = 8000;
+
+} // namespace
+
+class WaitTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init()
+    {
+        QVERIFY(m_server.listen(QHostAddress::LocalHost, 0));
+        m_socket.connectToHost(QHostAddress::LocalHost, m_server.serverPort());
+        QVERIFY(m_socket.waitForConnected(2000));
+        QVERIFY(m_server.waitForNewConnection(2000));
+        // Accepted and left alone: the poll below never gets a reply.
+        m_peer = m_server.nextPendingConnection();
+        QVERIFY(m_peer);
+    }
+
+    void cleanup()
+    {
+        m_socket.abort();
+        delete m_peer;
+        m_peer = nullptr;
+        m_server.close();
+    }
+
+    void writePreemptsPollOnSameThread()
+    {
+        onkyo::CancellationToken poll;
+        qint64 handedOverMs = -1;
+        QElapsedTimer clock;
+        clock.start();
+        // What preemptRunningPoll() does when a write is queued behind the poll.
+        QTimer::singleShot(100, this, [&]() {
+            handedOverMs = clock.elapsed();
+            poll.cancel();
+        });
+
+        const onkyo::WaitStatus status = onkyo::waitForSocket(
+            m_socket,
+            [this]() { return m_socket.bytesAvailable() > 0; },
+            QDateTime::currentMSecsSinceEpoch() + kPollDeadlineMs,
+            poll);
+        const qint64 latencyMs = clock.elapsed() - handedOverMs;
+
+        QCOMPARE(status, onkyo::WaitStatus::Cancelled);
+        QVERIFY(handedOverMs >= 0);
+        qInfo("preemption latency %lld ms", static_cast<long long>(latencyMs));
+        QVERIFY2(latencyMs <= kPreemptBoundMs, qPrintable(QStringLiteral("latency %1 ms").arg(latencyMs)));
+    }
+
+    void writePreemptsPollFromCoreThread()
+    {
+        onkyo::CancellationToken poll;
+        QObject dispatch;
+        std::atomic<qint64> handedOverMs{-1};
+        QElapsedTimer clock;
+        clock.start();
+        // The command arrives from another thread and is queued onto the worker, as core invokes are.
+        std::thread core([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            handedOverMs = clock.elapsed();
+            QMetaObject::invokeMethod(&dispatch, [&]() { poll.cancel(); }, Qt::QueuedConnection);
+        });
+
+        const onkyo::WaitStatus status = onkyo::waitForSocket(
+            m_socket,
+            [this]() { return m_socket.bytesAvailable() > 0; },
+            QDateTime::currentMSecsSinceEpoch() + kPollDeadlineMs,
+            poll);
+        const qint64 latencyMs = clock.elapsed() - handedOverMs;
+        core.join();
+
+        QCOMPARE(status, onkyo::WaitStatus::Cancelled);
+        qInfo("preemption latency %lld ms", static_cast<long long>(latencyMs));
+        QVERIFY2(latencyMs <= kPreemptBoundMs, qPrintable(QStringLiteral("latency %1 ms").arg(latencyMs)));
+    }
+
+    void pollWithoutWriteRunsToDeadline()
+    {
+        QElapsedTimer clock;
+        clock.start();
+        const onkyo::WaitStatus status = onkyo::waitForSocket(
+            m_socket,
+            [this]() { return m_socket.bytesAvailable() > 0; },
+            QDateTime::currentMSecsSinceEpoch() + 200,
+            onkyo::CancellationToken());
+        QCOMPARE(status, onkyo::WaitStatus::TimedOut);
+        QVERIFY(clock.elapsed() >= 190);
+    }
+
+    void abandonedWaitDoesNotReturn()
+    {
+        onkyo::CancellationToken token;
+        QTimer::singleShot(50, this, [&]() { token.abandon(); });
+        bool returned = false;
+        bool thrown = false;
+        try {
+            onkyo::waitUntil(QDateTime::currentMSecsSinceEpoch() + 5000, token);
+            returned = true;
+        } catch (const onkyo::OperationAbandoned &) {
+            thrown = true;
+        }
+        QVERIFY(thrown);
+        QVERIFY(!returned);
+        QVERIFY(token.isCancelled());
+    }
+
+    void quittingThreadCancelsWait()
+    {
+        std::atomic<bool> slept{true};
+        std::atomic<qint64> waitedMs{-1};
+        QThread *worker = QThread::create([&]() {
+            QElapsedTimer clock;
+            clock.start();
+            slept = onkyo::waitUntil(QDateTime::currentMSecsSinceEpoch() + 5000, onkyo::CancellationToken());
+            waitedMs = clock.elapsed();
+        });
+        worker->start();
+        QTest::qWait(100);
+        worker->quit();
+        QVERIFY(worker->wait(2000));
+        delete worker;
+
+        QVERIFY(!slept);
+        QVERIFY(waitedMs >= 0 && waitedMs < 1000);
+    }
+
+private:
+    QTcpServer m_server;
+    QTcpSocket m_socket;
+    QTcpSocket *m_peer = nullptr;
+};
+
+QTEST_GUILESS_MAIN(WaitTest)
+#include "wait_test.moc"
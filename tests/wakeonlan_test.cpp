@@ -0,0 +1,166 @@
+// Wake-on-LAN: MAC parsing, the magic packet, one packet sent to a local listener as if wolBroadcast were
+// 127.0.0.1, and the wake sequence against a local receiver that boots once the packet arrived.
+
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QNetworkDatagram>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+#include <QTimer>
+#include <QUdpSocket>
+
+#include "onkyowol.h"
+
+namespace {
+
+// Time the fake receiver needs between the magic packet and an open control port.
+constexpr int kBootMs = 600;
+constexpr int kConnectTimeoutMs = 400;
+
+} // namespace
+
+class WakeOnLanTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parsesMacAddresses_data()
+    {
+        QTest::addColumn<QString>("text");
+        QTest::addColumn<QByteArray>("mac");
+
+        const QByteArray mac = QByteArray::fromHex("0009B0123456");
+        QTest::newRow("colons") << QStringLiteral("00:09:B0:12:34:56") << mac;
+        QTest::newRow("dashes") << QStringLiteral("00-09-b0-12-34-56") << mac;
+        QTest::newRow("bare") << QStringLiteral(" 0009B0123456 ") << mac;
+        QTest::newRow("all zero") << QStringLiteral("00:00:00:00:00:00") << QByteArray();
+        QTest::newRow("short") << QStringLiteral("00:09:B0:12:34") << QByteArray();
+        QTest::newRow("not hex") << QStringLiteral("00:09:B0:12:34:ZZ") << QByteArray();
+        QTest::newRow("empty") << QString() << QByteArray();
+    }
+
+    void parsesMacAddresses()
+    {
+        QFETCH(QString, text);
+        QFETCH(QByteArray, mac);
+        QCOMPARE(onkyo::parseMacAddress(text), mac);
+    }
+
+    void formatsMacAddress()
+    {
+        QCOMPARE(onkyo::formatMacAddress(QByteArray::fromHex("0009b0123456")), QStringLiteral("00:09:B0:12:34:56"));
+    }
+
+    void buildsMagicPacket()
+    {
+        const QByteArray mac = QByteArray::fromHex("0009B0123456");
+        const QByteArray packet = onkyo::wakeOnLanPacket(mac);
+        QCOMPARE(packet.size(), 102);
+        QCOMPARE(packet.left(6), QByteArray(6, '\xFF'));
+        for (int i = 0; i < 16; ++i)
+            QCOMPARE(packet.mid(6 + 6 * i, 6), mac);
+    }
+
+    void fallsBackToBroadcast()
+    {
+        QCOMPARE(onkyo::wakeOnLanTarget(QString()), QHostAddress(QHostAddress::Broadcast));
+        QCOMPARE(onkyo::wakeOnLanTarget(QStringLiteral("not an address")), QHostAddress(QHostAddress::Broadcast));
+        QCOMPARE(onkyo::wakeOnLanTarget(QStringLiteral(" 127.0.0.1 ")), QHostAddress(QHostAddress::LocalHost));
+    }
+
+    void sendsPacketToConfiguredTarget()
+    {
+        QUdpSocket listener;
+        QVERIFY(listener.bind(QHostAddress::LocalHost, 0));
+
+        const QByteArray mac = onkyo::parseMacAddress(QStringLiteral("00:09:B0:12:34:56"));
+        const QHostAddress target = onkyo::wakeOnLanTarget(QStringLiteral("127.0.0.1"));
+        QVERIFY(onkyo::sendWakeOnLan(mac, target, listener.localPort()));
+
+        QTRY_VERIFY_WITH_TIMEOUT(listener.hasPendingDatagrams(), 2000);
+        const QNetworkDatagram datagram = listener.receiveDatagram();
+        QCOMPARE(datagram.data().size(), 102);
+        QCOMPARE(datagram.data(), onkyo::wakeOnLanPacket(mac));
+    }
+
+    void measuresWakeToReady()
+    {
+        const QByteArray mac = onkyo::parseMacAddress(QStringLiteral("00:09:B0:12:34:56"));
+        QUdpSocket listener;
+        QVERIFY(listener.bind(QHostAddress::LocalHost, 0));
+
+        // A free port for the control endpoint, closed again until the receiver has booted.
+        QTcpServer control;
+        QVERIFY(control.listen(QHostAddress::LocalHost, 0));
+        const quint16 controlPort = control.serverPort();
+        control.close();
+
+        QElapsedTimer clock;
+        clock.start();
+        qint64 packetMs = -1;
+        qint64 listeningMs = -1;
+        int packets = 0;
+        QObject::connect(&listener, &QUdpSocket::readyRead, &listener, [&]() {
+            while (listener.hasPendingDatagrams()) {
+                if (listener.receiveDatagram().data() != onkyo::wakeOnLanPacket(mac))
+                    continue;
+                ++packets;
+                if (packetMs >= 0)
+                    continue;
+                packetMs = clock.elapsed();
+                QTimer::singleShot(kBootMs, &control, [&]() {
+                    if (control.listen(QHostAddress::LocalHost, controlPort))
+                        listeningMs = clock.elapsed();
+                });
+            }
+        });
+
+        QTcpSocket session;
+        const qint64 startedMs = clock.elapsed();
+        const onkyo::OperationContext ctx = onkyo::OperationContext::withTimeout(10000);
+        const onkyo::WakeResult wake = onkyo::runWakeSequence(
+            ctx, onkyo::WakeTiming{},
+            [&]() { QVERIFY(onkyo::sendWakeOnLan(mac, QHostAddress(QHostAddress::LocalHost), listener.localPort())); },
+            [&]() {
+                session.abort();
+                session.connectToHost(QHostAddress::LocalHost, controlPort);
+                return onkyo::waitForSocket(
+                           session,
+                           [&]() { return session.state() == QAbstractSocket::ConnectedState; },
+                           ctx.stepDeadline(kConnectTimeoutMs),
+                           ctx.token)
+                    == onkyo::WaitStatus::Ready;
+            });
+
+        QVERIFY(wake.ready);
+        QCOMPARE(packets, 1);
+        QVERIFY(packetMs >= 0);
+        QVERIFY(listeningMs >= packetMs + kBootMs);
+        QVERIFY(wake.attempts > 1);
+        // On the sequence's own clock: ready no earlier than the port opened (1 ms for the clocks' rounding)
+        // and no later than one backoff step after it.
+        const qint64 openMs = listeningMs - startedMs;
+        qInfo("wake-to-ready %lld ms after %d attempts, port open after %lld ms",
+              static_cast<long long>(wake.elapsedMs), wake.attempts, static_cast<long long>(openMs));
+        QVERIFY(wake.elapsedMs >= kBootMs);
+        QVERIFY(wake.elapsedMs + 1 >= openMs);
+        QVERIFY2(wake.elapsedMs <= openMs + onkyo::WakeTiming{}.backoffMaxMs + 200,
+                 qPrintable(QStringLiteral("wake %1 ms, port open %2 ms").arg(wake.elapsedMs).arg(openMs)));
+    }
+
+    void cancelledWakeStops()
+    {
+        onkyo::OperationContext ctx = onkyo::OperationContext::withTimeout(10000);
+        QTimer::singleShot(300, this, [&]() { ctx.token.cancel(); });
+        int packets = 0;
+        const onkyo::WakeResult wake = onkyo::runWakeSequence(
+            ctx, onkyo::WakeTiming{}, [&]() { ++packets; }, []() { return false; });
+        QVERIFY(!wake.ready);
+        QCOMPARE(packets, 1);
+        QVERIFY(wake.elapsedMs < 1000);
+    }
+};
+
+QTEST_GUILESS_MAIN(WakeOnLanTest)
+#include "wakeonlan_test.moc"